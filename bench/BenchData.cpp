@@ -0,0 +1,121 @@
+#include "BenchData.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/*
+ Implementation details:
+ - Operands that could make an expression fail are guarded in the text itself: divisors
+   become abs(e)+1, sqrt and ln take abs(e)(+1), and powers use a literal exponent of 2 or 3,
+   so every generated expression evaluates.
+ - Zipf words are drawn by binary search in the cumulative weight table; the vocabulary
+   itself is random lowercase words of 2-10 letters.
+*/
+
+const char* const BENCH_VARIABLES[3] = {"x", "y", "z"};
+
+namespace {
+
+void append_expression(BenchRng& rng, int depth, std::string& out) {
+    if (depth <= 0) {
+        if (rng.below(2) == 0) {
+            out += BENCH_VARIABLES[rng.below(3)];
+        } else {
+            char buf[32];
+            std::snprintf(buf, sizeof buf, "%.2f", 0.5 + rng.uniform() * 99.5);
+            out += buf;
+        }
+        return;
+    }
+    switch (rng.below(10)) {
+    case 0:
+        out += "sin(";
+        append_expression(rng, depth - 1, out);
+        out += ')';
+        return;
+    case 1:
+        out += "sqrt(abs(";
+        append_expression(rng, depth - 1, out);
+        out += "))";
+        return;
+    case 2:
+        out += "ln(abs(";
+        append_expression(rng, depth - 1, out);
+        out += ")+1)";
+        return;
+    case 3:
+        out += '(';
+        append_expression(rng, depth - 1, out);
+        out += rng.below(2) ? ")^2" : ")^3";
+        return;
+    case 4:
+        out += '(';
+        append_expression(rng, depth - 1, out);
+        out += ")/(abs(";
+        append_expression(rng, depth - 1, out);
+        out += ")+1)";
+        return;
+    default: {
+        static const char OPS[] = "+-*";
+        out += '(';
+        append_expression(rng, depth - 1, out);
+        out += OPS[rng.below(3)];
+        append_expression(rng, depth - 1, out);
+        out += ')';
+        return;
+    }
+    }
+}
+
+} // namespace
+
+std::string randomExpression(BenchRng& rng, int depth) {
+    std::string out;
+    append_expression(rng, depth, out);
+    return out;
+}
+
+std::string zipfCorpus(BenchRng& rng, std::size_t bytes, std::size_t vocabulary, double s) {
+    std::vector<std::string> words(vocabulary);
+    for (auto& w : words) {
+        std::size_t len = 2 + rng.below(9);
+        for (std::size_t i = 0; i < len; ++i) w.push_back((char)('a' + rng.below(26)));
+    }
+    std::vector<double> cdf(vocabulary);
+    double sum = 0;
+    for (std::size_t k = 0; k < vocabulary; ++k) cdf[k] = sum += 1.0 / std::pow((double)(k + 1), s);
+
+    std::string out;
+    out.reserve(bytes + 16);
+    std::size_t line = 0, sentence = 0;
+    while (out.size() < bytes) {
+        double u = rng.uniform() * sum;
+        std::size_t k = (std::size_t)(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        const std::string& w = words[std::min(k, vocabulary - 1)];
+        out += w;
+        line += w.size() + 1;
+        if (++sentence >= 6 + rng.below(12)) {
+            out += rng.below(4) ? '.' : '!';
+            sentence = 0;
+        }
+        if (line >= 72) {
+            out += '\n';
+            line = 0;
+        } else {
+            out += ' ';
+        }
+    }
+    out.resize(bytes);
+    return out;
+}
+
+std::vector<char> randomBytes(BenchRng& rng, std::size_t n) {
+    std::vector<char> out(n);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t v = rng.next();
+        for (int b = 0; b < 8; ++b) out[i + b] = (char)(v >> (8 * b));
+    }
+    for (; i < n; ++i) out[i] = (char)rng.next();
+    return out;
+}
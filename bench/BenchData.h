@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ BenchData - 基准测试的输入数据生成器
+ - 全部由固定种子的 splitmix64 生成，不使用 <random> 的分布（不同标准库实现结果不同），
+   同一种子在任何机器上得到完全相同的数据，基准结果之间才有可比性
+ - randomExpression: 指定嵌套深度的随机表达式，叶子是数字或变量 x y z（避免整条表达式被常量折叠），
+   不会出现除零、负数开方等错误
+ - zipfCorpus: 按 Zipf 分布抽词的英文样文本，带句号和换行，接近真实文本的词频
+ - randomBytes: 均匀随机的二进制数据
+*/
+class BenchRng {
+public:
+    explicit BenchRng(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    // [0, n)
+    std::size_t below(std::size_t n) { return (std::size_t)(next() % n); }
+    // [0, 1)
+    double uniform() { return (double)(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    std::uint64_t state;
+};
+
+// variables used by randomExpression; bind them before evaluating
+extern const char* const BENCH_VARIABLES[3];
+
+std::string randomExpression(BenchRng& rng, int depth);
+// about `bytes` of text drawn from a vocabulary of `vocabulary` words with Zipf exponent s
+std::string zipfCorpus(BenchRng& rng, std::size_t bytes, std::size_t vocabulary = 20000, double s = 1.1);
+std::vector<char> randomBytes(BenchRng& rng, std::size_t n);
@@ -0,0 +1,103 @@
+#include "BenchHarness.h"
+#include "CpuFeatures.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <ostream>
+
+/*
+ Implementation details:
+ - Allocations are counted by replacing the global operator new for the whole bench binary,
+   so allocations inside suite_core count too. Array new forwards to it by default.
+ - The clock overhead is the smallest of many back-to-back now() differences; it is subtracted
+   from each p99 sample and the result clamped at zero.
+*/
+
+namespace {
+
+std::atomic<std::uint64_t> alloc_count{0};
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+std::uint64_t BenchRunner::allocations() {
+    return alloc_count.load(std::memory_order_relaxed);
+}
+
+BenchRunner::BenchRunner(Options o) : opt(std::move(o)) {
+    double best = 1e9;
+    for (int i = 0; i < 1000; ++i) {
+        auto a = Clock::now();
+        auto b = Clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(b - a).count());
+    }
+    clockOverheadNs = best;
+
+    std::printf("%-36s %12s %12s %12s %12s %10s\n", "Benchmark", "ns/op", "p99 ns", "iterations", "MB/s",
+                "allocs/op");
+    std::printf("%s\n", std::string(99, '-').c_str());
+}
+
+bool BenchRunner::selected(const std::string& name) const {
+    return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+}
+
+void BenchRunner::report(Result r, std::size_t bytesPerOp, std::vector<double>& samples) {
+    if (!samples.empty()) {
+        std::size_t k = std::min(samples.size() - 1, samples.size() * 99 / 100);
+        std::nth_element(samples.begin(), samples.begin() + (std::ptrdiff_t)k, samples.end());
+        r.p99Ns = std::max(0.0, samples[k]);
+    }
+    if (bytesPerOp > 0) r.bytesPerSecond = (double)bytesPerOp / (r.nsPerOp * 1e-9);
+
+    char mbs[32] = "-";
+    if (bytesPerOp > 0) std::snprintf(mbs, sizeof mbs, "%.1f", r.bytesPerSecond / 1e6);
+    std::printf("%-36s %12.1f %12.1f %12llu %12s %10.2f\n", r.name.c_str(), r.nsPerOp, r.p99Ns,
+                (unsigned long long)r.iterations, mbs, r.allocsPerOp);
+    std::fflush(stdout);
+    done.push_back(std::move(r));
+}
+
+void BenchRunner::writeJson(std::ostream& out) const {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    nlohmann::json j;
+    j["context"] = {
+        {"date", date},
+        {"simd", simdLevelName(cpuSimdLevel())},
+        {"min_time", opt.minTime},
+        {"samples", opt.samples},
+    };
+    nlohmann::json list = nlohmann::json::array();
+    for (const Result& r : done) {
+        list.push_back({
+            {"name", r.name},
+            {"iterations", r.iterations},
+            {"ns_per_op", r.nsPerOp},
+            {"p99_ns", r.p99Ns},
+            {"bytes_per_second", r.bytesPerSecond},
+            {"allocs_per_op", r.allocsPerOp},
+        });
+    }
+    j["benchmarks"] = list;
+    out << j.dump(2) << "\n";
+}
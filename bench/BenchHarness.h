@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*
+ BenchHarness - 自带的微基准框架（思路同 Google Benchmark，不引入外部依赖）
+ - run(name, bytesPerOp, op): 先自动标定迭代次数，使一轮至少持续 minTime 秒，再测量：
+     ns/op          = 一整轮的总时间 / 迭代次数
+     p99            = 另外逐次计时 samples 次，取第 99 百分位（已减去计时本身的开销）
+     bytes/s        = bytesPerOp > 0 时按 ns/op 换算
+     allocs/op      = 一整轮中 operator new 的调用次数 / 迭代次数（本程序替换了全局 operator new）
+ - filter 非空时只运行名称包含它的基准
+ - writeJson 输出机器可读的结果，bench/compare.py 用它对比基线
+*/
+class BenchRunner {
+public:
+    struct Options {
+        double minTime = 0.25;
+        std::size_t samples = 10000;
+        std::string filter;
+    };
+
+    struct Result {
+        std::string name;
+        std::uint64_t iterations = 0;
+        double nsPerOp = 0;
+        double p99Ns = 0;
+        double bytesPerSecond = 0; // 0 when the benchmark processes no byte stream
+        double allocsPerOp = 0;
+    };
+
+    explicit BenchRunner(Options opt);
+
+    bool selected(const std::string& name) const;
+
+    template <class Op>
+    void run(const std::string& name, std::size_t bytesPerOp, Op&& op);
+
+    const std::vector<Result>& results() const { return done; }
+    void writeJson(std::ostream& out) const;
+
+    // operator new calls so far in this process
+    static std::uint64_t allocations();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Options opt;
+    double clockOverheadNs;
+    std::vector<Result> done;
+
+    void report(Result r, std::size_t bytesPerOp, std::vector<double>& samples);
+};
+
+// keeps the compiler from optimizing away a value the benchmark does not otherwise use
+template <class T>
+inline void benchKeep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+template <class Op>
+void BenchRunner::run(const std::string& name, std::size_t bytesPerOp, Op&& op) {
+    if (!selected(name)) return;
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    // calibrate: grow the batch until it takes a tenth of minTime, then scale up
+    op();
+    std::uint64_t iters = 1;
+    while (true) {
+        auto t0 = Clock::now();
+        for (std::uint64_t i = 0; i < iters; ++i) op();
+        double dt = seconds(Clock::now() - t0);
+        if (dt >= opt.minTime / 10) {
+            iters = std::max<std::uint64_t>(1, (std::uint64_t)((double)iters * opt.minTime / dt));
+            break;
+        }
+        iters *= 10;
+    }
+
+    Result r;
+    r.name = name;
+    r.iterations = iters;
+    std::uint64_t allocs = allocations();
+    auto t0 = Clock::now();
+    for (std::uint64_t i = 0; i < iters; ++i) op();
+    r.nsPerOp = seconds(Clock::now() - t0) * 1e9 / (double)iters;
+    r.allocsPerOp = (double)(allocations() - allocs) / (double)iters;
+
+    std::vector<double> samples((std::size_t)std::min<std::uint64_t>(iters, opt.samples));
+    for (double& s : samples) {
+        auto a = Clock::now();
+        op();
+        s = std::chrono::duration<double, std::nano>(Clock::now() - a).count() - clockOverheadNs;
+    }
+    report(std::move(r), bytesPerOp, samples);
+}
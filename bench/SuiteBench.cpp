@@ -0,0 +1,222 @@
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CpuFeatures.h"
+#include "tools/CalcProgram.h"
+#include "tools/CalculatorTool.h"
+#include "tools/ColorConvert.h"
+#include "tools/ColorPickerTool.h"
+#include "tools/TextEncryptTool.h"
+#include "tools/TextStatsCounter.h"
+#include "tools/UnitBatch.h"
+#include "tools/UnitConverterTool.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// suite_bench [--filter <substring>] [--json <file>] [--min-time <seconds>] [--samples N]
+// Every input comes from a fixed seed, so runs on the same machine measure the same work.
+
+namespace {
+
+constexpr std::size_t EXPRESSIONS = 64; // cycled through; fits the program cache
+constexpr std::size_t PAYLOAD = 1 << 20;
+constexpr std::size_t BATCH_ROWS = 4096;
+constexpr std::size_t IMAGE_SIDE = 256; // one conversion tile
+
+void bench_calculator(BenchRunner& b) {
+    CalculatorTool calc;
+    for (int i = 0; i < 3; ++i) calc.setVariable(BENCH_VARIABLES[i], 1.25 + i);
+
+    for (int depth : {4, 8}) {
+        BenchRng rng(1000 + depth);
+        std::vector<std::string> exprs;
+        for (std::size_t i = 0; i < EXPRESSIONS; ++i) exprs.push_back(randomExpression(rng, depth));
+        std::vector<ToolArgs> requests(exprs.begin(), exprs.end());
+        std::string suffix = "/depth:" + std::to_string(depth);
+        std::size_t i = 0;
+
+        b.run("calc/compile" + suffix, 0, [&] { benchKeep(CalcProgram::compile(exprs[i++ % EXPRESSIONS])); });
+        b.run("calc/eval" + suffix, 0, [&] { benchKeep(calc.evalExpr(exprs[i++ % EXPRESSIONS])); });
+        ToolOutput out;
+        b.run("calc/execute" + suffix, 0, [&] {
+            out.clear();
+            calc.execute(requests[i++ % EXPRESSIONS], out);
+        });
+    }
+
+    BenchRng rng(7);
+    std::string expr = randomExpression(rng, 6);
+    std::vector<double> xs(BATCH_ROWS), res(BATCH_ROWS);
+    for (double& x : xs) x = rng.uniform() * 10;
+    std::unordered_map<std::string, const double*> columns = {{"x", xs.data()}};
+    b.run("calc/batch/rows:4096", BATCH_ROWS * sizeof(double),
+          [&] { calc.evalBatch(expr, columns, BATCH_ROWS, res.data()); });
+}
+
+void bench_textstats(BenchRunner& b) {
+    BenchRng rng(42);
+    std::string corpus = zipfCorpus(rng, PAYLOAD);
+    std::string small = corpus.substr(0, 4096);
+
+    auto count = [&](const std::string& text, std::size_t sketchBytes) {
+        TextStatsCounter c(sketchBytes);
+        c.feed(text, true);
+        c.finish();
+        benchKeep(c.summary(8));
+    };
+    b.run("textstats/count/zipf:4KiB", small.size(), [&] { count(small, 0); });
+    b.run("textstats/count/zipf:1MiB", corpus.size(), [&] { count(corpus, 0); });
+    b.run("textstats/approx/zipf:1MiB", corpus.size(), [&] { count(corpus, 64 << 10); });
+}
+
+void bench_encrypt(BenchRunner& b) {
+    BenchRng rng(99);
+    std::vector<char> data = randomBytes(rng, PAYLOAD);
+
+    std::vector<const CryptKernels*> crypt = {&cryptScalarKernels()};
+    std::vector<const Base64Kernels*> b64 = {&base64ScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    SimdLevel level = cpuSimdLevel();
+    if (level >= SimdLevel::Sse2) crypt.push_back(&cryptSse2Kernels());
+    if (level >= SimdLevel::Avx2) crypt.push_back(&cryptAvx2Kernels());
+    if (level >= SimdLevel::Ssse3) b64.push_back(&base64Ssse3Kernels());
+    if (level >= SimdLevel::Avx2) b64.push_back(&base64Avx2Kernels());
+#endif
+
+    for (const CryptKernels* k : crypt) {
+        for (CryptMethod m : {CryptMethod::Xor, CryptMethod::Caesar}) {
+            CryptSettings s;
+            s.method = m;
+            CryptStream stream(s, *k);
+            b.run(std::string("encrypt/") + cryptMethodName(m) + "/" + k->name, data.size(),
+                  [&] { stream.apply(data.data(), data.size()); });
+        }
+    }
+
+    std::string text = base64Encode(std::string_view(data.data(), data.size()));
+    std::vector<char> sink(Base64Encoder::maxOutput(data.size()));
+    for (const Base64Kernels* k : b64) {
+        b.run(std::string("base64/encode/") + k->name, data.size(), [&] {
+            Base64Encoder e(*k);
+            e.finish(sink.data() + e.update(data.data(), data.size(), sink.data()));
+        });
+        b.run(std::string("base64/decode/") + k->name, text.size(), [&] {
+            Base64Decoder d(*k);
+            d.update(text.data(), text.size(), sink.data());
+            d.finish();
+        });
+    }
+}
+
+void bench_small_tools(BenchRunner& b) {
+    ColorPickerTool color;
+    UnitConverterTool unit;
+    ToolArgs rgb("12 200 31"), meters("2.75");
+    ToolOutput out;
+    b.run("color/execute", 0, [&] {
+        out.clear();
+        color.execute(rgb, out);
+    });
+    b.run("unit/execute", 0, [&] {
+        out.clear();
+        unit.execute(meters, out);
+    });
+}
+
+void bench_units(BenchRunner& b) {
+    BenchRng rng(5);
+    UnitConversion c = unitConversion("F", "C");
+    std::vector<double> xs(BATCH_ROWS), res(BATCH_ROWS);
+    for (double& x : xs) x = rng.uniform() * 200 - 50;
+    b.run("unit/convert/rows:4096", BATCH_ROWS * sizeof(double), [&] { convertUnits(c, xs.data(), res.data(), BATCH_ROWS); });
+
+    // id,reading,label rows; the middle column is converted
+    std::string csv;
+    for (std::size_t row = 0; csv.size() < PAYLOAD; ++row)
+        csv += std::to_string(row) + "," + std::to_string(rng.uniform() * 1000) + ",sensor\n";
+    UnitCsvOptions opt;
+    opt.conversion = unitConversion("km", "mi");
+    opt.columns = {"2"};
+    std::ostringstream sink;
+    b.run("unit/csv/1MiB", csv.size(), [&] {
+        std::istringstream in(csv);
+        sink.str(std::string());
+        benchKeep(convertUnitCsv(in, sink, opt).values);
+    });
+}
+
+void bench_color(BenchRunner& b) {
+    // gradients with a little noise: many distinct colors, some repetition, like a photo
+    BenchRng rng(11);
+    std::size_t n = IMAGE_SIDE * IMAGE_SIDE;
+    std::vector<std::uint8_t> px(n * 3);
+    for (std::size_t y = 0; y < IMAGE_SIDE; ++y)
+        for (std::size_t x = 0; x < IMAGE_SIDE; ++x) {
+            std::uint8_t* p = &px[(y * IMAGE_SIDE + x) * 3];
+            p[0] = (std::uint8_t)x;
+            p[1] = (std::uint8_t)y;
+            p[2] = (std::uint8_t)((x + y) / 2 + rng.below(8));
+        }
+    Rgb8In in = Rgb8In::interleaved(px.data());
+    std::vector<float> out(n * 3);
+    std::vector<std::uint16_t> index(n);
+
+    std::vector<const ColorKernels*> sets = {&colorScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    SimdLevel level = cpuSimdLevel();
+    if (level >= SimdLevel::Sse2) sets.push_back(&colorSse2Kernels());
+    if (level >= SimdLevel::Avx2) sets.push_back(&colorAvx2Kernels());
+#endif
+    for (const ColorKernels* k : sets) {
+        ColorConvertOptions opt;
+        opt.kernels = k;
+        b.run(std::string("color/hsv/") + k->name, px.size(),
+              [&] { rgbToColorSpace(ColorSpace::Hsv, in, Float3Out::interleaved(out.data()), n, opt); });
+        b.run(std::string("color/lab/") + k->name, px.size(),
+              [&] { rgbToColorSpace(ColorSpace::Lab, in, Float3Out::interleaved(out.data()), n, opt); });
+        b.run(std::string("color/nearest/") + k->name, px.size(),
+              [&] { cssPalette().nearest(in, index.data(), n, opt); });
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchRunner::Options opt;
+    std::string json;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--filter" && more) opt.filter = argv[++i];
+        else if (a == "--json" && more) json = argv[++i];
+        else if (a == "--min-time" && more) opt.minTime = std::atof(argv[++i]);
+        else if (a == "--samples" && more) opt.samples = (std::size_t)std::atoll(argv[++i]);
+        else {
+            std::cerr << "usage: suite_bench [--filter <substring>] [--json <file>] [--min-time <seconds>] [--samples N]\n";
+            return 2;
+        }
+    }
+    if (opt.minTime <= 0) opt.minTime = 0.25;
+
+    BenchRunner b(opt);
+    bench_calculator(b);
+    bench_textstats(b);
+    bench_encrypt(b);
+    bench_small_tools(b);
+    bench_units(b);
+    bench_color(b);
+
+    if (!json.empty()) {
+        std::ofstream out(json);
+        if (!out) {
+            std::cerr << "Cannot write " << json << "\n";
+            return 1;
+        }
+        b.writeJson(out);
+    }
+    return 0;
+}
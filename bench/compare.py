@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Compares two suite_bench JSON files and flags regressions.
+
+    bench/compare.py baseline.json current.json [--threshold 0.10] [--p99-threshold 0.25] [--allow-missing]
+
+A benchmark regresses when its ns/op grows by more than --threshold, its p99 by more
+than --p99-threshold, or it allocates more per op than before. A baseline benchmark
+missing from the current run also fails, unless --allow-missing is given (a renamed or
+dropped benchmark otherwise needs a new baseline). Exits with 1 if anything regressed,
+so the script can gate a CI job.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {b["name"]: b for b in data["benchmarks"]}, data.get("context", {})
+
+
+def change(old, new):
+    if old <= 0:
+        return 0.0
+    return (new - old) / old
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=0.10, help="allowed ns/op growth (default 0.10)")
+    ap.add_argument("--p99-threshold", type=float, default=0.25, help="allowed p99 growth (default 0.25)")
+    ap.add_argument("--allow-missing", action="store_true", help="do not fail on baseline benchmarks missing from current")
+    args = ap.parse_args()
+
+    base, base_ctx = load(args.baseline)
+    cur, cur_ctx = load(args.current)
+    if base_ctx.get("simd") != cur_ctx.get("simd"):
+        print("warning: SIMD level differs (%s vs %s)" % (base_ctx.get("simd"), cur_ctx.get("simd")))
+
+    print("%-36s %12s %12s %8s %8s %10s  %s" % ("Benchmark", "old ns/op", "new ns/op", "time", "p99", "allocs/op", ""))
+    regressions = 0
+    for name, b in base.items():
+        c = cur.get(name)
+        if c is None:
+            print("%-36s %12.1f %12s %8s %8s %10s  %s" % (
+                name, b["ns_per_op"], "-", "", "", "", "missing" if args.allow_missing else "MISSING"))
+            if not args.allow_missing:
+                regressions += 1
+            continue
+        dt = change(b["ns_per_op"], c["ns_per_op"])
+        dp = change(b["p99_ns"], c["p99_ns"])
+        notes = []
+        if dt > args.threshold:
+            notes.append("SLOWER")
+        if dp > args.p99_threshold:
+            notes.append("P99")
+        # allocations are deterministic; allow only rounding noise
+        if c["allocs_per_op"] > b["allocs_per_op"] + 0.01:
+            notes.append("ALLOCS")
+        if notes:
+            regressions += 1
+        elif dt < -args.threshold:
+            notes.append("faster")
+        print("%-36s %12.1f %12.1f %+7.1f%% %+7.1f%% %10s  %s" % (
+            name, b["ns_per_op"], c["ns_per_op"], dt * 100, dp * 100,
+            "%.2f>%.2f" % (b["allocs_per_op"], c["allocs_per_op"]) if "ALLOCS" in notes else "%.2f" % c["allocs_per_op"],
+            " ".join(notes)))
+    for name in cur:
+        if name not in base:
+            print("%-36s %12s %12.1f %8s %8s %10.2f  new" % (name, "-", cur[name]["ns_per_op"], "", "", cur[name]["allocs_per_op"]))
+
+    if regressions:
+        print("\n%d regression(s)" % regressions)
+        return 1
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,16 +1,171 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+/*
+ ConfigManager - config.json 的读取、保存和热加载
+ - 配置以不可变快照（ConfigSnapshot）发布：修改和重新加载都生成新快照再原子地替换指针，
+   读取方从不加锁，正在运行的工具手里的旧快照保持有效
+ - 类型化的键 ConfigKey<T> 在快照生成时解析一次并缓存（缺失或类型不对时取默认值），
+   key.get() 只是一次代数比较加一次数组访问，没有字符串查找
+ - 修改只能通过 set(section, key, value)：值没有变化时什么也不做，否则标记为脏
+ - save() 只是请求保存：干净时直接跳过；否则在 saveDelay 之后由后台线程写一次，
+   期间的所有修改和 save() 合并到这一次写入里（saveDelay 为 0 时立即写）
+ - flush() 立即写出未保存的修改；程序退出（析构）时自动 flush
+ - 写入先写到 config.json.tmp 并 fsync，再 rename 覆盖，崩溃时只会留下旧文件或新文件
+ - watch()（Linux，inotify）监视 config.json，被外部修改后自动重新加载，unwatch() 停止监视；
+   解析失败时保留原来的配置，外部修改覆盖尚未保存的本地修改
+ - saveStats() 统计保存请求、实际写盘次数、省掉的写入次数和热加载次数
+*/
+
+// resolved value of one ConfigKey; integers are widened to int64
+using ConfigSlot = std::variant<bool, std::int64_t, double, std::string>;
+
+template <class T>
+class ConfigKey;
+
+class ConfigSnapshot {
+public:
+    const nlohmann::json& json() const { return doc; }
+    std::uint64_t generation() const { return gen; }
+
+    template <class T>
+    typename ConfigKey<T>::Result get(const ConfigKey<T>& key) const {
+        using Stored = typename ConfigKey<T>::Stored;
+        if constexpr (std::is_same_v<T, std::string>)
+            return std::get<Stored>(slots[key.index()]);
+        else
+            return static_cast<T>(std::get<Stored>(slots[key.index()]));
+    }
+
+private:
+    friend class ConfigManager;
+    nlohmann::json doc;
+    std::uint64_t gen = 0;
+    std::vector<ConfigSlot> slots; // one per registered key, by ConfigKey::index()
+};
 
 class ConfigManager {
 public:
+    struct SaveStats {
+        std::uint64_t requests = 0; // save() calls
+        std::uint64_t writes = 0;   // files actually written
+        std::uint64_t avoided = 0;  // save() calls that found nothing new to write
+        std::uint64_t reloads = 0;  // external changes picked up by watch()
+    };
+    using Resolver = ConfigSlot (*)(const nlohmann::json* value, const ConfigSlot& fallback);
+
     static ConfigManager& instance();
+    ~ConfigManager();
 
-    nlohmann::json& config();
+    // the calling thread's view of the newest snapshot: one atomic load when nothing changed.
+    // The reference stays valid until this thread calls current() again after a change.
+    const ConfigSnapshot& current() const {
+        const ConfigSnapshot* s = tlsSnapshot;
+        if (s && s->generation() == gen.load(std::memory_order_acquire)) return *s;
+        return refresh();
+    }
+    // a snapshot that can be kept (or handed to another thread) for as long as needed
+    std::shared_ptr<const ConfigSnapshot> snapshot() const;
+    // bumped by every published change (set() or reload)
+    std::uint64_t generation() const { return gen.load(std::memory_order_acquire); }
+
+    // cfg[section][key] = value; returns false (and stays clean) when the value is unchanged
+    bool set(const std::string& section, const std::string& key, const nlohmann::json& value);
     void save();
+    // throws runtime_error if the file cannot be written
+    void flush();
+    // starts reloading config.json when it changes on disk; false where this is not supported
+    bool watch();
+    // stops the watcher started by watch(); the destructor does this too
+    void unwatch();
+
+    void setSaveDelay(std::chrono::milliseconds delay);
+    SaveStats saveStats() const;
+
+    // used by ConfigKey; returns the key's slot index
+    static std::size_t registerKey(const char* section, const char* key, ConfigSlot fallback, Resolver resolve);
 
 private:
     ConfigManager();
-    nlohmann::json cfg;
+
+    static inline thread_local const ConfigSnapshot* tlsSnapshot = nullptr; // kept alive by refresh()
+
+    std::string path = "config.json";
+    std::shared_ptr<const ConfigSnapshot> snap; // only through std::atomic_load / std::atomic_store
+    std::atomic<std::uint64_t> gen{0};
+
+    mutable std::mutex mu;      // writers: publishing, save bookkeeping
+    std::mutex writeMu;         // one file write at a time
+    std::condition_variable cv;
+    std::thread flusher;        // started by the first delayed save
+    std::thread watcher;        // started by watch()
+    int inotifyFd = -1;
+    int stopFd = -1;
+    std::deque<std::size_t> ownWrites; // hashes of our recent writes, whose change events are not reloads
+    std::chrono::milliseconds saveDelay{1000};
+    std::chrono::steady_clock::time_point deadline;
+    std::uint64_t version = 0;      // bumped by every effective set()
+    std::uint64_t savedVersion = 0; // version last written (or loaded)
+    bool pending = false;           // a delayed write is scheduled
+    bool stopping = false;
+    SaveStats stats;
+
+    const ConfigSnapshot& refresh() const;
+    void publishLocked(nlohmann::json doc);
+    void republish();
+    void reload();
+    void flusherLoop();
+    void watchLoop();
 };
 
+// a typed config value, e.g. `const ConfigKey<int> SHIFT{"encrypt", "shift", 3};` at namespace scope
+template <class T>
+class ConfigKey {
+    static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, std::string>, "unsupported config type");
+
+public:
+    using Stored = std::conditional_t<
+        std::is_same_v<T, bool>, bool,
+        std::conditional_t<std::is_integral_v<T>, std::int64_t,
+                           std::conditional_t<std::is_floating_point_v<T>, double, std::string>>>;
+    using Result = std::conditional_t<std::is_same_v<T, std::string>, const std::string&, T>;
+
+    ConfigKey(const char* section, const char* key, T fallback)
+        : idx(ConfigManager::registerKey(section, key, ConfigSlot(Stored(fallback)), &resolve)) {}
+
+    // value in the calling thread's current snapshot
+    Result get() const { return ConfigManager::instance().current().get(*this); }
+    std::size_t index() const { return idx; }
+
+private:
+    std::size_t idx;
+
+    static ConfigSlot resolve(const nlohmann::json* v, const ConfigSlot& fallback) {
+        if (!v) return fallback;
+        if constexpr (std::is_same_v<T, bool>) {
+            if (v->is_boolean()) return v->get<bool>();
+        } else if constexpr (std::is_integral_v<T>) {
+            if (v->is_number_integer()) {
+                std::int64_t x = v->get<std::int64_t>();
+                if (!(std::is_unsigned_v<T> && x < 0)) return x;
+            }
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if (v->is_number()) return v->get<double>();
+        } else {
+            if (v->is_string()) return v->get<std::string>();
+        }
+        return fallback;
+    }
+};
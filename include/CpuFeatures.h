@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+/*
+ CpuFeatures - 运行时 CPU 特性检测，用于选择 SIMD 内核
+ - 环境变量 SUITE_SIMD=scalar|sse2|ssse3|sse4.2|avx2 可以把选择限制到更低的级别（便于对比和排查）
+ - SSSE3 提供字节重排（pshufb），按字节查表的内核（Base64）从这一级开始
+*/
+enum class SimdLevel { Scalar = 0, Sse2 = 1, Ssse3 = 2, Sse42 = 3, Avx2 = 4 };
+
+// best level supported by both the build and the running CPU, capped by SUITE_SIMD
+SimdLevel cpuSimdLevel();
+
+std::string simdLevelName(SimdLevel level);
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+ MappedFile - 只读内存映射文件（POSIX mmap）
+ - 打开失败时抛出 runtime_error；空文件得到 size() == 0、data() == nullptr
+ - 映射页由文件支撑，按顺序处理时可以用 release() 提示内核回收已经处理过的部分，
+   这样扫描多 GB 文件时常驻内存保持有界
+ - 无法映射的输入（管道、/proc 等）由调用方改用流式读取
+*/
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return ptr; }
+    std::size_t size() const { return len; }
+
+    // the range [offset, offset+length) will not be read again
+    void release(std::size_t offset, std::size_t length);
+
+    // false for special files whose size is unknown (pipes, character devices, /proc)
+    static bool mappable(const std::string& path);
+
+private:
+    const char* ptr = nullptr;
+    std::size_t len = 0;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/*
+ Metrics - 热路径计数与计时，按需导出为 JSON 或 Prometheus 文本
+ - MetricTimer: 调用次数 + 延迟直方图（HDR 风格：每个 2 的幂分 8 个子桶，相对误差 ≤ 12.5%）；
+   sampleEvery > 1 时每 sampleEvery 次调用计时一次（次数仍然精确），用于几十纳秒级的热点
+ - MetricCounter: 只计数（例如错误数）
+ - 每个线程写自己的一份数据（单写者，relaxed 原子读写，无锁、无共享缓存行）；
+   导出时在锁内合并所有线程，线程退出时把数据并入汇总
+ - 指标用 metricTimer / metricCounter 注册（通常保存在静态引用里），之后一直有效；
+   同名同标签重复注册返回同一个对象
+ - CMake 选项 SUITE_METRICS=OFF 时整个机制编译为空操作：MetricScope 是空对象，导出只输出 "disabled"
+ - 环境变量 SUITE_METRICS_OUT=<文件> 时程序退出前写出全部指标（.json 结尾为 JSON，否则 Prometheus）
+*/
+
+// log-linear bucket index for a value in nanoseconds (shared with ToolServer's latency stats)
+struct MetricBuckets {
+    static constexpr std::size_t SUB = 8;         // sub-buckets per power of two
+    static constexpr std::size_t COUNT = 48 * SUB; // values up to 2^49 ns (6.5 days); larger ones clamp
+
+    static std::size_t index(std::uint64_t v) {
+        if (v < SUB) return (std::size_t)v;
+        int lg = 63 - __builtin_clzll(v); // >= 3
+        std::size_t b = (std::size_t)(lg - 2) * SUB + (std::size_t)((v >> (lg - 3)) & (SUB - 1));
+        return b < COUNT ? b : COUNT - 1;
+    }
+    // largest value that lands in bucket b
+    static std::uint64_t upper(std::size_t b) {
+        if (b < SUB) return b;
+        std::size_t lg = b / SUB + 2, sub = b % SUB;
+        return ((SUB + sub + 1) << (lg - 3)) - 1;
+    }
+};
+
+#ifdef SUITE_METRICS
+
+// one thread's data for one metric; only the owning thread writes
+struct MetricCell {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> sumNs{0};
+    std::atomic<std::uint64_t> maxNs{0};
+    std::atomic<std::uint64_t> buckets[MetricBuckets::COUNT] = {};
+
+    static void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void record(std::uint64_t ns) {
+        bump(samples, 1);
+        bump(sumNs, ns);
+        bump(buckets[MetricBuckets::index(ns)], 1);
+        if (ns > maxNs.load(std::memory_order_relaxed)) maxNs.store(ns, std::memory_order_relaxed);
+    }
+};
+
+class Metrics {
+public:
+    static constexpr bool enabled = true;
+    static constexpr std::size_t MAX_METRICS = 256;
+
+    struct ThreadCells {
+        std::atomic<MetricCell*> cells[MAX_METRICS] = {};
+    };
+
+    // the calling thread's cell for metric `id`, created on first use
+    static MetricCell& cell(std::uint32_t id) {
+        if (ThreadCells* t = tls)
+            if (MetricCell* c = t->cells[id].load(std::memory_order_relaxed)) return *c;
+        return newCell(id);
+    }
+
+    static void writeJson(std::ostream& out);
+    static void writePrometheus(std::ostream& out);
+    // one spdlog line per metric that has been used
+    static void logSummary();
+    // writes every metric to `path`: JSON if it ends in ".json", Prometheus text otherwise
+    static void writeFile(const std::string& path);
+
+private:
+    static inline thread_local ThreadCells* tls = nullptr;
+    static MetricCell& newCell(std::uint32_t id);
+};
+
+class MetricTimer {
+public:
+    const std::uint32_t id;
+    const std::uint32_t sampleMask; // sampleEvery - 1
+
+    MetricTimer(std::uint32_t id, std::uint32_t sampleEvery) : id(id), sampleMask(sampleEvery - 1) {}
+};
+
+class MetricCounter {
+public:
+    const std::uint32_t id;
+
+    explicit MetricCounter(std::uint32_t id) : id(id) {}
+    void add(std::uint64_t n = 1) const { MetricCell::bump(Metrics::cell(id).calls, n); }
+};
+
+// counts one call and times it when it is a sampled one
+class MetricScope {
+public:
+    explicit MetricScope(const MetricTimer& t) : cell(Metrics::cell(t.id)) {
+        std::uint64_t n = cell.calls.load(std::memory_order_relaxed) + 1;
+        cell.calls.store(n, std::memory_order_relaxed);
+        if (((n - 1) & t.sampleMask) == 0) start = std::chrono::steady_clock::now(); // calls 1, 1 + k * sampleEvery
+    }
+    ~MetricScope() {
+        if (start != std::chrono::steady_clock::time_point())
+            cell.record((std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+    MetricScope(const MetricScope&) = delete;
+    MetricScope& operator=(const MetricScope&) = delete;
+
+private:
+    MetricCell& cell;
+    std::chrono::steady_clock::time_point start;
+};
+
+#else
+
+class Metrics {
+public:
+    static constexpr bool enabled = false;
+
+    static void writeJson(std::ostream& out);
+    static void writePrometheus(std::ostream& out);
+    static void logSummary() {}
+    static void writeFile(const std::string& path);
+};
+
+class MetricTimer {};
+
+class MetricCounter {
+public:
+    void add(std::uint64_t = 1) const {}
+};
+
+class MetricScope {
+public:
+    explicit MetricScope(const MetricTimer&) {}
+};
+
+#endif
+
+// name: Prometheus-style base name, e.g. "suite_calc_eval"; exported as <name>_seconds (a
+// summary with p50/p90/p99/p999) and <name>_calls_total. label: "" or key=value.
+// sampleEvery must be a power of two. Registration takes a lock; keep the returned reference
+MetricTimer& metricTimer(const char* name, const char* help, const std::string& label = "", unsigned sampleEvery = 1);
+MetricCounter& metricCounter(const char* name, const char* help, const std::string& label = "");
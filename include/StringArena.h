@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ StringArena - 只追加的字符串存储（bump allocator）
+ - 字符串依次复制到 64 KiB 的块中，每块只分配一次；返回的 string_view 在 clear() 之前一直有效
+ - 不能单独释放某个字符串，clear() 或析构时整体释放
+ - adopt() 接管另一个 arena 的所有块（地址不变），合并容器时不需要重新复制
+*/
+class StringArena {
+public:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    StringArena() = default;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    std::string_view store(std::string_view s) {
+        if (s.size() > left) newBlock(s.size());
+        char* p = ptr;
+        std::memcpy(p, s.data(), s.size());
+        ptr += s.size();
+        left -= s.size();
+        return std::string_view(p, s.size());
+    }
+
+    // other's strings now live as long as this arena; other is left empty
+    void adopt(StringArena&& other);
+    void clear();
+
+    std::size_t blockCount() const { return blocks.size(); }
+    std::size_t bytesReserved() const { return reserved; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* ptr = nullptr;
+    std::size_t left = 0;
+    std::size_t reserved = 0;
+
+    void newBlock(std::size_t atLeast);
+};
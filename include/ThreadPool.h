@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ ThreadPool - 工作窃取线程池
+ - 每个工作线程有自己的任务队列；线程内提交的任务进入自己的队列（LIFO，缓存友好）
+ - 空闲线程从其他队列的另一端窃取任务（FIFO）
+ - wait() 等待所有已提交任务完成，并重新抛出任务中第一个未捕获的异常
+*/
+class ThreadPool {
+public:
+    // threads == 0 -> std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    template <class F>
+    auto async(F&& f) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> fut = task->get_future();
+        submit([task] { (*task)(); });
+        return fut;
+    }
+
+    void wait();
+
+    unsigned size() const { return (unsigned)workers.size(); }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void loop(unsigned id);
+    bool take(unsigned id, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::size_t queued = 0; // tasks sitting in queues, guarded by sleepMutex
+    bool stopping = false;
+
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    std::size_t pending = 0; // submitted but not finished, guarded by doneMutex
+    std::exception_ptr firstError;
+};
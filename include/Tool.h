@@ -1,11 +1,64 @@
 #pragma once
+#include "Metrics.h"
+#include "ToolIO.h"
+#include <exception>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 class Tool {
 public:
     virtual ~Tool() = default;
     virtual std::string name() const = 0;
     virtual std::string description() const { return ""; }
+    // the interactive loop: reads std::cin, writes std::cout, passes each request to execute()
     virtual void run() = 0;
-};
 
+    // one request without a terminal (server mode, batches, benchmarks): the reply is appended
+    // to `out`. May be called from several threads at once and may read, but not change,
+    // per-instance state; never touches std::cin or std::cout. Throws runtime_error for bad input.
+    virtual void execute(const ToolArgs& args, ToolOutput& out) {
+        (void)args;
+        (void)out;
+        throw std::runtime_error(name() + " does not take requests");
+    }
+
+    // execute() counted as suite_tool_request{tool="<name>"} (every 16th call timed) once
+    // enableMetrics() has run (ToolRegistry does that); callers that serve requests go through here
+    void invoke(const ToolArgs& args, ToolOutput& out) {
+        if (!Metrics::enabled || !requests) {
+            execute(args, out);
+            return;
+        }
+        MetricScope scope(*requests);
+        try {
+            execute(args, out);
+        } catch (...) {
+            errors->add();
+            throw;
+        }
+    }
+
+    void enableMetrics() {
+        requests = &metricTimer("suite_tool_request", "Tool requests", "tool=" + name(), 16);
+        errors = &metricCounter("suite_tool_errors_total", "Tool requests that failed", "tool=" + name());
+    }
+
+    // invoke() for the interactive loops: an error becomes "<errorPrefix><message>\n" in `out`
+    // instead of an exception; false on error
+    bool respond(const ToolArgs& args, ToolOutput& out, std::string_view errorPrefix) {
+        std::size_t at = out.size();
+        try {
+            invoke(args, out);
+            return true;
+        } catch (const std::exception& e) {
+            out.truncate(at);
+            out << errorPrefix << e.what() << '\n';
+            return false;
+        }
+    }
+
+private:
+    MetricTimer* requests = nullptr;
+    MetricCounter* errors = nullptr;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+ ToolArgs / ToolOutput - Tool::execute 的输入和输出
+ - ToolArgs 把一条请求按空格/制表符切成单词，只保存指向原文的 string_view，不复制、不分配；
+   最多 MAX_WORDS 个单词，其余内容仍可通过 rest() 取得
+ - rest(i) 是第 i 个单词起的原文（跳过前一个单词后的一个分隔符），用于 "encrypt <text>"
+   这类带任意文本的请求，文本中的空格原样保留
+ - ToolOutput 是可重复使用的输出缓冲区：clear() 保留容量，预热后的缓冲区写入回复不再分配内存；
+   数字格式化用 to_chars / snprintf，不经过 iostream，double 的格式与 ostream 默认格式（%g）相同
+*/
+class ToolArgs {
+public:
+    static constexpr std::size_t MAX_WORDS = 8;
+
+    ToolArgs() = default;
+    // views into `text`, which must outlive the ToolArgs
+    explicit ToolArgs(std::string_view text);
+
+    std::string_view text() const { return all; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // empty past the last word
+    std::string_view operator[](std::size_t i) const { return i < count ? words[i] : std::string_view(); }
+
+    // the text after word i - 1 and the one separator that follows it, as written;
+    // rest(0) is the whole text, empty if there are fewer than i words
+    std::string_view rest(std::size_t i) const;
+
+    // word i as a number; false if it is missing or not entirely a number
+    bool toInt(std::size_t i, long long* out) const;
+    bool toDouble(std::size_t i, double* out) const;
+
+private:
+    std::string_view all;
+    std::array<std::string_view, MAX_WORDS> words;
+    std::size_t count = 0;
+};
+
+class ToolOutput {
+public:
+    void clear() { buf.clear(); }
+    void reserve(std::size_t n) { buf.reserve(n); }
+    std::size_t size() const { return buf.size(); }
+    bool empty() const { return buf.empty(); }
+    std::string_view view() const { return buf; }
+    std::size_t capacity() const { return buf.capacity(); }
+
+    // room for n more chars at the end; keep the used part with truncate(size() + used)
+    char* extend(std::size_t n) {
+        std::size_t at = buf.size();
+        buf.resize(at + n);
+        return &buf[at];
+    }
+    void truncate(std::size_t n) { buf.resize(n); }
+
+    ToolOutput& operator<<(std::string_view s) {
+        buf.append(s.data(), s.size());
+        return *this;
+    }
+    ToolOutput& operator<<(const char* s) { return *this << std::string_view(s); }
+    ToolOutput& operator<<(char c) {
+        buf.push_back(c);
+        return *this;
+    }
+    template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>, int> = 0>
+    ToolOutput& operator<<(T v) {
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp + sizeof tmp, v);
+        buf.append(tmp, (std::size_t)(r.ptr - tmp));
+        return *this;
+    }
+    // 6 significant digits, like an ostream with default flags
+    ToolOutput& operator<<(double v);
+
+private:
+    std::string buf;
+};
@@ -1,20 +1,70 @@
 #pragma once
-#include <unordered_map>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "Tool.h"
 
+/*
+ ToolRegistry - 工具目录：启动时只登记工厂函数和元数据（名字、说明、别名），第一次使用时才构造工具
+ - get(): 按名字或别名精确查找（区分大小写），需要时构造；可在多个线程中同时调用
+ - resolve(): 交互输入用，另外接受不区分大小写的名字 / 别名前缀；前缀不唯一时返回 nullptr，
+   matches() 列出候选
+ - listTools(): 按名字排序的列表，登记时建好，不会构造任何工具
+ - 登记（registerFactory / registerTool）只应在启动阶段、第一次查找之前进行
+ - 环境变量 SUITE_TRACE_STARTUP=1 时用 spdlog 输出启动过程中各步骤和每个工具构造的耗时
+*/
 class ToolRegistry {
 public:
+    using Factory = std::function<std::unique_ptr<Tool>()>;
+
+    struct ToolInfo {
+        std::string name; // must equal the constructed tool's name()
+        std::string description;
+        std::vector<std::string> aliases;
+        Factory factory;
+    };
+
     static ToolRegistry& instance();
 
+    // false if the name or an alias is already taken
+    bool registerFactory(ToolInfo info);
+    // an already constructed tool, for tests and embedding
     bool registerTool(std::unique_ptr<Tool> tool);
 
-    Tool* get(const std::string& name);
-    std::vector<std::string> listTools() const;
+    Tool* get(std::string_view name);
+    Tool* resolve(std::string_view query);
+    std::vector<std::string> matches(std::string_view query) const;
+
+    const std::vector<std::string>& listTools() const { return sorted; }
+    // metadata without constructing the tool; nullptr for unknown names
+    const ToolInfo* info(std::string_view name) const;
+
+    // with SUITE_TRACE_STARTUP set: logs `what` with the time since the registry was created
+    // (during static initialization, before main) and since the previous trace
+    static void traceStartup(std::string_view what);
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<Tool>> tools;
-};
+    struct Entry {
+        ToolInfo info;
+        std::atomic<Tool*> tool{nullptr};
+        std::unique_ptr<Tool> owned;
+    };
+    struct Key {
+        std::string text; // a name or alias; lowercased in `folded`
+        Entry* entry;
+    };
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::vector<std::string> sorted;
+    std::vector<Key> exact;  // sorted by text
+    std::vector<Key> folded; // sorted by text
+    std::mutex constructing;
 
+    Tool* construct(Entry& e);
+    Entry* findExact(std::string_view name) const;
+    std::vector<Entry*> findPrefix(std::string_view query) const;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include "ToolRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ ToolServer - 常驻服务模式：通过 Unix 域套接字把所有已注册工具提供给其他进程
+ - 一个 epoll 线程负责 accept、读写和分帧，请求交给工作线程池调用 Tool::execute
+ - 帧格式（长度为小端 u32，不含自身）：
+     请求: 长度 | 工具名 '\0' 输入
+     响应: 长度 | '+'（成功）或 '-'（错误信息） 内容
+ - 同一连接上可以连续发送多个请求（流水线），响应严格按请求顺序返回；
+   每个连接最多 MAX_PIPELINE 个请求在处理中，超过后暂停读取该连接（背压）
+ - 工具名 "!stats" 返回服务器统计：请求数、错误数、延迟 p50 / p99 / 最大值
+   （从收到完整请求到响应进入发送缓冲区）
+ - 工具名 "!metrics" 返回 Metrics 的全部指标：输入为 "json" 时是 JSON，否则是 Prometheus 文本
+ - SIGINT / SIGTERM 时停止，删除套接字文件并把统计写到 stderr
+ - 套接字文件权限为 0600；已有服务器在监听同一路径时拒绝启动，残留的旧文件会被替换
+*/
+class ToolServer {
+public:
+    static constexpr std::size_t MAX_PIPELINE = 64;
+    static constexpr std::uint32_t MAX_FRAME = 64u << 20;
+
+    struct Stats {
+        std::uint64_t connections = 0;
+        std::uint64_t requests = 0;
+        std::uint64_t errors = 0;
+        double p50Micros = 0;
+        double p99Micros = 0;
+        double maxMicros = 0;
+    };
+
+    // threads == 0 -> one worker per core
+    ToolServer(ToolRegistry& registry, std::string socketPath, unsigned threads = 0);
+    ~ToolServer();
+
+    ToolServer(const ToolServer&) = delete;
+    ToolServer& operator=(const ToolServer&) = delete;
+
+    // runs the event loop until stop() or SIGINT / SIGTERM; throws runtime_error if the socket
+    // cannot be set up
+    void serve();
+    // callable from any thread (or a signal handler)
+    void stop();
+
+    // consistent only after serve() has returned
+    Stats stats() const;
+    static std::string formatStats(const Stats& s);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// blocking client for ToolServer; requests may be pipelined (send several, then receive)
+class ToolClient {
+public:
+    // throws runtime_error if nothing listens at socketPath
+    explicit ToolClient(const std::string& socketPath);
+    ~ToolClient();
+
+    ToolClient(const ToolClient&) = delete;
+    ToolClient& operator=(const ToolClient&) = delete;
+
+    void send(std::string_view tool, std::string_view input);
+    // the next response in request order; false if the server closed the connection.
+    // *ok is false when body holds an error message
+    bool receive(std::string& body, bool* ok);
+
+    // send + receive; throws runtime_error with the server's message on errors
+    std::string call(std::string_view tool, std::string_view input);
+
+private:
+    int fd = -1;
+    std::string buf;
+};
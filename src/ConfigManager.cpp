@@ -1,12 +1,129 @@
 #include "ConfigManager.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+/*
+ Implementation details:
+ - Every change builds a new ConfigSnapshot: a copy of the document plus one resolved slot per
+   registered ConfigKey. The tree is C++17, so the snapshot pointer is published with
+   std::atomic_store and read with std::atomic_load; current() avoids even that by caching the
+   pointer per thread (a plain thread_local pointer, with a shared_ptr in refresh() keeping it
+   alive) and comparing the snapshot's generation with the atomic counter, which is stored after
+   the snapshot so a reader that sees a new generation also finds the new snapshot.
+ - Dirty tracking is a version counter: set() bumps `version` only when the stored value
+   differs, and a write records the version it serialized. A change that lands while the
+   file is being written is therefore still dirty afterwards.
+ - The delay is counted from the first unsaved request, not the last one, so a steady
+   stream of changes is written at least once per saveDelay instead of being put off forever.
+ - Snapshots are immutable, so a write serializes one without holding `mu`; `writeMu` keeps
+   flush() and the flusher thread from writing concurrently.
+ - watch() watches the directory, not the file: saving (ours or an editor's) replaces the inode
+   with a rename. Events for our own writes are recognised by hashing the file and comparing it
+   with our last few writes; anything else that parses replaces the configuration.
+*/
+
+namespace {
+
+void write_atomically(const std::string& path, const std::string& text) {
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Cannot create " + tmp + ": " + std::strerror(errno));
+    const char* p = text.data();
+    std::size_t left = text.size();
+    while (left > 0) {
+        ssize_t w = ::write(fd, p, left);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) {
+            int err = errno;
+            ::close(fd);
+            ::unlink(tmp.c_str());
+            throw std::runtime_error("Cannot write " + tmp + ": " + std::strerror(err));
+        }
+        p += w;
+        left -= (std::size_t)w;
+    }
+    // the data must be on disk before the rename makes it visible
+    if (::fsync(fd) != 0 || ::close(fd) != 0) {
+        ::unlink(tmp.c_str());
+        throw std::runtime_error("Cannot write " + tmp + ": " + std::strerror(errno));
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        ::unlink(tmp.c_str());
+        throw std::runtime_error("Cannot replace " + path + ": " + std::strerror(err));
+    }
+}
+
+constexpr std::size_t OWN_WRITES_KEPT = 16;
+
+struct KeyDesc {
+    std::string section, key;
+    ConfigSlot fallback;
+    ConfigManager::Resolver resolve;
+};
+
+struct KeyRegistry {
+    std::mutex mu;
+    std::vector<KeyDesc> keys;
+};
+
+// keys are registered during static initialization, possibly before the manager exists
+KeyRegistry& key_registry() {
+    static KeyRegistry r;
+    return r;
+}
+
+std::atomic<ConfigManager*> live_manager{nullptr};
+
+bool read_file(const std::string& path, std::string* out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return false;
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    *out = ss.str();
+    return true;
+}
+
+} // namespace
 
 ConfigManager::ConfigManager() {
-    std::ifstream f("config.json");
-    if (f.is_open()) {
-        f >> cfg;
-    } else {
-        cfg = nlohmann::json::object();
+    nlohmann::json doc = nlohmann::json::object();
+    std::ifstream f(path);
+    if (f.is_open()) f >> doc;
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        publishLocked(std::move(doc));
+    }
+    live_manager.store(this);
+}
+
+ConfigManager::~ConfigManager() {
+    live_manager.store(nullptr);
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (flusher.joinable()) flusher.join();
+    unwatch();
+    try {
+        flush();
+    } catch (...) {
+        // nothing useful to do at exit; the previous file is still intact
     }
 }
 
@@ -15,12 +132,233 @@ ConfigManager& ConfigManager::instance() {
     return inst;
 }
 
-nlohmann::json& ConfigManager::config() {
-    return cfg;
+const ConfigSnapshot& ConfigManager::refresh() const {
+    thread_local std::shared_ptr<const ConfigSnapshot> held;
+    held = std::atomic_load(&snap);
+    tlsSnapshot = held.get();
+    return *held;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigManager::snapshot() const {
+    return std::atomic_load(&snap);
+}
+
+std::size_t ConfigManager::registerKey(const char* section, const char* key, ConfigSlot fallback, Resolver resolve) {
+    std::size_t idx;
+    {
+        KeyRegistry& r = key_registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        idx = r.keys.size();
+        r.keys.push_back({section, key, std::move(fallback), resolve});
+    }
+    // a key created after startup needs a snapshot that has its slot
+    if (ConfigManager* m = live_manager.load()) m->republish();
+    return idx;
+}
+
+void ConfigManager::publishLocked(nlohmann::json doc) {
+    auto next = std::make_shared<ConfigSnapshot>();
+    next->doc = std::move(doc);
+    if (!next->doc.is_object()) next->doc = nlohmann::json::object();
+    next->gen = gen.load(std::memory_order_relaxed) + 1;
+    {
+        KeyRegistry& r = key_registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        next->slots.reserve(r.keys.size());
+        for (const KeyDesc& k : r.keys) {
+            const nlohmann::json* v = nullptr;
+            auto sec = next->doc.find(k.section);
+            if (sec != next->doc.end() && sec->is_object()) {
+                auto it = sec->find(k.key);
+                if (it != sec->end()) v = &*it;
+            }
+            next->slots.push_back(k.resolve(v, k.fallback));
+        }
+    }
+    std::uint64_t g = next->gen;
+    std::atomic_store(&snap, std::shared_ptr<const ConfigSnapshot>(std::move(next)));
+    gen.store(g, std::memory_order_release);
+}
+
+void ConfigManager::republish() {
+    std::lock_guard<std::mutex> lk(mu);
+    publishLocked(std::atomic_load(&snap)->doc);
+}
+
+bool ConfigManager::set(const std::string& section, const std::string& key, const nlohmann::json& value) {
+    std::lock_guard<std::mutex> lk(mu);
+    const nlohmann::json& cur = std::atomic_load(&snap)->doc;
+    auto sec = cur.find(section);
+    if (sec != cur.end() && sec->is_object()) {
+        auto it = sec->find(key);
+        if (it != sec->end() && *it == value) return false;
+    }
+    nlohmann::json doc = cur;
+    if (!doc[section].is_object()) doc[section] = nlohmann::json::object();
+    doc[section][key] = value;
+    publishLocked(std::move(doc));
+    ++version;
+    return true;
 }
 
 void ConfigManager::save() {
-    std::ofstream f("config.json");
-    f << cfg.dump(4);
+    std::unique_lock<std::mutex> lk(mu);
+    ++stats.requests;
+    if (version == savedVersion) {
+        ++stats.avoided;
+        return;
+    }
+    if (saveDelay.count() == 0) {
+        lk.unlock();
+        flush();
+        return;
+    }
+    if (pending) {
+        ++stats.avoided; // covered by the scheduled write
+        return;
+    }
+    pending = true;
+    deadline = std::chrono::steady_clock::now() + saveDelay;
+    if (!flusher.joinable()) flusher = std::thread([this] { flusherLoop(); });
+    lk.unlock();
+    cv.notify_all();
 }
 
+void ConfigManager::flush() {
+    std::lock_guard<std::mutex> wl(writeMu);
+    std::shared_ptr<const ConfigSnapshot> s;
+    std::uint64_t v;
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        pending = false;
+        if (version == savedVersion) return;
+        s = std::atomic_load(&snap);
+        v = version;
+    }
+    std::string text = s->doc.dump(4);
+    {
+        // recorded before the rename so the watcher already knows the text when the event arrives;
+        // events are read late, so the file may hold any of the last few writes by then
+        std::lock_guard<std::mutex> lk(mu);
+        ownWrites.push_back(std::hash<std::string>()(text));
+        if (ownWrites.size() > OWN_WRITES_KEPT) ownWrites.pop_front();
+    }
+    write_atomically(path, text);
+    std::lock_guard<std::mutex> lk(mu);
+    if (savedVersion < v) savedVersion = v;
+    ++stats.writes;
+}
+
+bool ConfigManager::watch() {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lk(mu);
+    if (watcher.joinable()) return true;
+    std::string dir = ".", name = path;
+    std::size_t slash = path.rfind('/');
+    if (slash != std::string::npos) {
+        dir = path.substr(0, slash + 1);
+        name = path.substr(slash + 1);
+    }
+    inotifyFd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0) return false;
+    if (::inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        (stopFd = ::eventfd(0, EFD_CLOEXEC)) < 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    // the watcher never takes process signals, so a caller that blocks them later and reads a
+    // signalfd (--serve) still sees every one
+    sigset_t all, old;
+    sigfillset(&all);
+    ::pthread_sigmask(SIG_BLOCK, &all, &old);
+    watcher = std::thread([this] { watchLoop(); });
+    ::pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ConfigManager::unwatch() {
+#ifdef __linux__
+    if (watcher.joinable()) {
+        std::uint64_t one = 1;
+        (void)!::write(stopFd, &one, sizeof one);
+        watcher.join();
+    }
+    if (inotifyFd >= 0) ::close(inotifyFd);
+    if (stopFd >= 0) ::close(stopFd);
+    inotifyFd = stopFd = -1;
+#endif
+}
+
+void ConfigManager::watchLoop() {
+#ifdef __linux__
+    std::string name = path.substr(path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1);
+    alignas(inotify_event) char buf[4096];
+    while (true) {
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents) return;
+        bool changed = false;
+        ssize_t n;
+        while ((n = ::read(inotifyFd, buf, sizeof buf)) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                if (ev->len > 0 && name == ev->name) changed = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        if (changed) reload();
+    }
+#endif
+}
+
+void ConfigManager::reload() {
+    std::string text;
+    if (!read_file(path, &text)) return;
+    nlohmann::json doc = nlohmann::json::parse(text, nullptr, false);
+    if (doc.is_discarded() || !doc.is_object()) {
+        std::cerr << path << ": parse error, keeping the previous configuration\n";
+        return;
+    }
+    std::size_t h = std::hash<std::string>()(text);
+    std::lock_guard<std::mutex> lk(mu);
+    if (std::find(ownWrites.begin(), ownWrites.end(), h) != ownWrites.end()) return;
+    if (doc == std::atomic_load(&snap)->doc) return;
+    publishLocked(std::move(doc));
+    savedVersion = ++version; // the file already holds it
+    ++stats.reloads;
+}
+
+void ConfigManager::flusherLoop() {
+    std::unique_lock<std::mutex> lk(mu);
+    while (!stopping) {
+        if (!pending) {
+            cv.wait(lk);
+            continue;
+        }
+        if (cv.wait_until(lk, deadline, [this] { return stopping || !pending; })) continue;
+        lk.unlock();
+        try {
+            flush();
+        } catch (...) {
+            // stays dirty; the next save() or the final flush tries again
+        }
+        lk.lock();
+    }
+}
+
+void ConfigManager::setSaveDelay(std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lk(mu);
+    saveDelay = delay;
+}
+
+ConfigManager::SaveStats ConfigManager::saveStats() const {
+    std::lock_guard<std::mutex> lk(mu);
+    return stats;
+}
@@ -0,0 +1,48 @@
+#include "CpuFeatures.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+SimdLevel detect() {
+#ifdef SUITE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("sse4.2")) return SimdLevel::Sse42;
+    if (__builtin_cpu_supports("ssse3")) return SimdLevel::Ssse3;
+    return SimdLevel::Sse2; // baseline on x86-64
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel env_cap() {
+    const char* v = std::getenv("SUITE_SIMD");
+    if (!v) return SimdLevel::Avx2;
+    if (std::strcmp(v, "scalar") == 0) return SimdLevel::Scalar;
+    if (std::strcmp(v, "sse2") == 0) return SimdLevel::Sse2;
+    if (std::strcmp(v, "ssse3") == 0) return SimdLevel::Ssse3;
+    if (std::strcmp(v, "sse4.2") == 0) return SimdLevel::Sse42;
+    return SimdLevel::Avx2;
+}
+
+} // namespace
+
+SimdLevel cpuSimdLevel() {
+    static const SimdLevel level = [] {
+        SimdLevel hw = detect(), cap = env_cap();
+        return (int)hw < (int)cap ? hw : cap;
+    }();
+    return level;
+}
+
+std::string simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::Sse2: return "sse2";
+    case SimdLevel::Ssse3: return "ssse3";
+    case SimdLevel::Sse42: return "sse4.2";
+    case SimdLevel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
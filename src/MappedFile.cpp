@@ -0,0 +1,46 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    len = (std::size_t)st.st_size;
+    if (len > 0) {
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        ::madvise(p, len, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (ptr) ::munmap(const_cast<char*>(ptr), len);
+}
+
+void MappedFile::release(std::size_t offset, std::size_t length) {
+    // madvise needs a page-aligned start; keep the partial page at the front
+    long page = ::sysconf(_SC_PAGESIZE);
+    std::size_t begin = (offset + (std::size_t)page - 1) / (std::size_t)page * (std::size_t)page;
+    std::size_t end = offset + length;
+    if (!ptr || end <= begin) return;
+    ::madvise(const_cast<char*>(ptr) + begin, end - begin, MADV_DONTNEED);
+}
+
+bool MappedFile::mappable(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+}
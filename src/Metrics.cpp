@@ -0,0 +1,322 @@
+#include "Metrics.h"
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+/*
+ Implementation details:
+ - The registry is allocated once and never freed, so metrics held in static references
+   stay valid during static destruction and in atexit handlers.
+ - A thread gets its ThreadCells on its first record; a function-local thread_local guard
+   folds the thread's cells into `retired` and frees them when the thread exits. Readers
+   merge `retired` and every live thread under the registry mutex, which the exiting
+   thread also takes, so no cell is freed while it is being read.
+ - Cells are written with relaxed load + store by their only writer (no locked RMW);
+   a reader may see a sample's bucket before its sum, which only skews an in-flight read.
+ - Quantiles report the upper bound of the HDR bucket that holds the rank, capped at the max.
+*/
+
+#ifdef SUITE_METRICS
+
+namespace {
+
+struct MetricDef {
+    std::string name;
+    std::string help;
+    std::string labelKey, labelValue;
+    bool timer = false;
+    unsigned sampleEvery = 1;
+    std::unique_ptr<MetricTimer> asTimer;
+    std::unique_ptr<MetricCounter> asCounter;
+};
+
+struct Merged {
+    std::uint64_t calls = 0;
+    std::uint64_t samples = 0;
+    std::uint64_t sumNs = 0;
+    std::uint64_t maxNs = 0;
+    std::uint64_t buckets[MetricBuckets::COUNT] = {};
+
+    void add(const MetricCell& c) {
+        calls += c.calls.load(std::memory_order_relaxed);
+        samples += c.samples.load(std::memory_order_relaxed);
+        sumNs += c.sumNs.load(std::memory_order_relaxed);
+        maxNs = std::max(maxNs, c.maxNs.load(std::memory_order_relaxed));
+        for (std::size_t b = 0; b < MetricBuckets::COUNT; ++b) buckets[b] += c.buckets[b].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t quantile(double q) const {
+        if (samples == 0) return 0;
+        // nearest rank: the smallest value with at least q of the samples at or below it
+        std::uint64_t rank = std::max<std::uint64_t>(1, (std::uint64_t)std::ceil(q * (double)samples)), seen = 0;
+        for (std::size_t b = 0; b < MetricBuckets::COUNT; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return std::min(MetricBuckets::upper(b), maxNs);
+        }
+        return maxNs;
+    }
+};
+
+struct Registry {
+    std::mutex m;
+    std::vector<std::unique_ptr<MetricDef>> defs; // index = metric id
+    std::vector<Metrics::ThreadCells*> live;
+    std::vector<std::unique_ptr<Merged>> retired; // per id, from threads that exited
+};
+
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// folds the exiting thread's cells into the registry
+struct ThreadExit {
+    Metrics::ThreadCells* cells = nullptr;
+    Metrics::ThreadCells** slot = nullptr; // the thread's Metrics::tls
+
+    ~ThreadExit() {
+        *slot = nullptr;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lk(r.m);
+        for (std::size_t id = 0; id < r.defs.size(); ++id) {
+            MetricCell* c = cells->cells[id].load(std::memory_order_relaxed);
+            if (!c) continue;
+            r.retired[id]->add(*c);
+            delete c;
+        }
+        r.live.erase(std::find(r.live.begin(), r.live.end(), cells));
+        delete cells;
+    }
+};
+
+MetricDef& define(const char* name, const char* help, const std::string& label, bool timer, unsigned sampleEvery) {
+    if (sampleEvery == 0 || (sampleEvery & (sampleEvery - 1)) != 0)
+        throw std::runtime_error(std::string("Metric ") + name + ": sampleEvery must be a power of two");
+    std::string key, value;
+    if (!label.empty()) {
+        std::size_t eq = label.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("Metric label must be key=value: " + label);
+        key = label.substr(0, eq);
+        value = label.substr(eq + 1);
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.m);
+    for (auto& d : r.defs)
+        if (d->name == name && d->labelKey == key && d->labelValue == value) {
+            if (d->timer != timer) throw std::runtime_error(std::string("Metric ") + name + " registered as another type");
+            return *d;
+        }
+    if (r.defs.size() == Metrics::MAX_METRICS) throw std::runtime_error("Too many metrics");
+
+    auto d = std::make_unique<MetricDef>();
+    std::uint32_t id = (std::uint32_t)r.defs.size();
+    d->name = name;
+    d->help = help;
+    d->labelKey = std::move(key);
+    d->labelValue = std::move(value);
+    d->timer = timer;
+    d->sampleEvery = sampleEvery;
+    if (timer) d->asTimer = std::make_unique<MetricTimer>(id, sampleEvery);
+    else d->asCounter = std::make_unique<MetricCounter>(id);
+    r.defs.push_back(std::move(d));
+    r.retired.push_back(std::make_unique<Merged>());
+    return *r.defs.back();
+}
+
+// every metric merged over all threads, in id order; call with the registry locked
+std::vector<Merged> merge_locked(Registry& r) {
+    std::vector<Merged> out(r.defs.size());
+    for (std::size_t id = 0; id < out.size(); ++id) {
+        const Merged& old = *r.retired[id];
+        out[id] = old;
+        for (Metrics::ThreadCells* t : r.live)
+            if (MetricCell* c = t->cells[id].load(std::memory_order_acquire)) out[id].add(*c);
+    }
+    return out;
+}
+
+std::string prom_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '\\' || c == '"') out.push_back('\\');
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+// {key="value",extra} with either part optional; empty if both are
+std::string prom_labels(const MetricDef& d, const std::string& extra = "") {
+    std::string l;
+    if (!d.labelKey.empty()) l = d.labelKey + "=\"" + prom_escape(d.labelValue) + "\"";
+    if (!extra.empty()) l += (l.empty() ? "" : ",") + extra;
+    return l.empty() ? l : "{" + l + "}";
+}
+
+std::string seconds(std::uint64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.9g", (double)ns * 1e-9);
+    return buf;
+}
+
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+} // namespace
+
+MetricCell& Metrics::newCell(std::uint32_t id) {
+    if (!tls) {
+        thread_local ThreadExit guard;
+        guard.cells = new ThreadCells;
+        guard.slot = &tls;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lk(r.m);
+        r.live.push_back(guard.cells);
+        tls = guard.cells;
+    }
+    MetricCell* c = new MetricCell;
+    tls->cells[id].store(c, std::memory_order_release);
+    return *c;
+}
+
+MetricTimer& metricTimer(const char* name, const char* help, const std::string& label, unsigned sampleEvery) {
+    return *define(name, help, label, true, sampleEvery).asTimer;
+}
+
+MetricCounter& metricCounter(const char* name, const char* help, const std::string& label) {
+    return *define(name, help, label, false, 1).asCounter;
+}
+
+void Metrics::writeJson(std::ostream& out) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.m);
+    std::vector<Merged> all = merge_locked(r);
+
+    nlohmann::json list = nlohmann::json::array();
+    for (std::size_t id = 0; id < all.size(); ++id) {
+        const MetricDef& d = *r.defs[id];
+        const Merged& m = all[id];
+        nlohmann::json j = {{"name", d.name}, {"type", d.timer ? "timer" : "counter"}};
+        if (!d.labelKey.empty()) j["labels"] = {{d.labelKey, d.labelValue}};
+        if (!d.timer) {
+            j["value"] = m.calls;
+        } else {
+            j["calls"] = m.calls;
+            j["sample_every"] = d.sampleEvery;
+            j["samples"] = m.samples;
+            j["sum_ns"] = m.sumNs;
+            j["max_ns"] = m.maxNs;
+            j["p50_ns"] = m.quantile(0.5);
+            j["p90_ns"] = m.quantile(0.9);
+            j["p99_ns"] = m.quantile(0.99);
+            j["p999_ns"] = m.quantile(0.999);
+        }
+        list.push_back(std::move(j));
+    }
+    out << nlohmann::json{{"enabled", true}, {"metrics", list}}.dump(2) << "\n";
+}
+
+void Metrics::writePrometheus(std::ostream& out) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.m);
+    std::vector<Merged> all = merge_locked(r);
+
+    // HELP / TYPE once per family; members of a family may have been registered apart
+    std::vector<bool> done(all.size());
+    for (std::size_t first = 0; first < all.size(); ++first) {
+        if (done[first]) continue;
+        const MetricDef& f = *r.defs[first];
+        if (f.timer) {
+            out << "# HELP " << f.name << "_seconds " << f.help;
+            if (f.sampleEvery > 1) out << " (1 in " << f.sampleEvery << " calls timed)";
+            out << "\n# TYPE " << f.name << "_seconds summary\n";
+        } else {
+            out << "# HELP " << f.name << " " << f.help << "\n# TYPE " << f.name << " counter\n";
+        }
+        for (std::size_t id = first; id < all.size(); ++id) {
+            const MetricDef& d = *r.defs[id];
+            if (d.name != f.name) continue;
+            const Merged& m = all[id];
+            if (!d.timer) {
+                out << d.name << prom_labels(d) << " " << m.calls << "\n";
+                continue;
+            }
+            for (double q : QUANTILES) {
+                char ql[32];
+                std::snprintf(ql, sizeof ql, "quantile=\"%g\"", q);
+                out << d.name << "_seconds" << prom_labels(d, ql) << " " << seconds(m.quantile(q)) << "\n";
+            }
+            out << d.name << "_seconds_sum" << prom_labels(d) << " " << seconds(m.sumNs) << "\n";
+            out << d.name << "_seconds_count" << prom_labels(d) << " " << m.samples << "\n";
+        }
+        if (f.timer) {
+            out << "# HELP " << f.name << "_calls_total " << f.help << " (all calls)\n";
+            out << "# TYPE " << f.name << "_calls_total counter\n";
+        }
+        for (std::size_t id = first; id < all.size(); ++id) {
+            const MetricDef& d = *r.defs[id];
+            if (d.name != f.name) continue;
+            done[id] = true;
+            if (d.timer) out << d.name << "_calls_total" << prom_labels(d) << " " << all[id].calls << "\n";
+        }
+    }
+}
+
+void Metrics::logSummary() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.m);
+    std::vector<Merged> all = merge_locked(r);
+    for (std::size_t id = 0; id < all.size(); ++id) {
+        const MetricDef& d = *r.defs[id];
+        const Merged& m = all[id];
+        if (m.calls == 0) continue;
+        std::string label = d.labelKey.empty() ? "" : "{" + d.labelKey + "=" + d.labelValue + "}";
+        if (!d.timer) {
+            spdlog::info("{}{}: {}", d.name, label, m.calls);
+            continue;
+        }
+        spdlog::info("{}{}: {} calls, p50 {:.3f} us, p99 {:.3f} us, max {:.3f} us", d.name, label, m.calls,
+                     (double)m.quantile(0.5) / 1e3, (double)m.quantile(0.99) / 1e3, (double)m.maxNs / 1e3);
+    }
+}
+
+#else
+
+void Metrics::writeJson(std::ostream& out) {
+    out << "{\"enabled\": false, \"metrics\": []}\n";
+}
+
+void Metrics::writePrometheus(std::ostream& out) {
+    out << "# metrics disabled at build time (SUITE_METRICS=OFF)\n";
+}
+
+MetricTimer& metricTimer(const char*, const char*, const std::string&, unsigned) {
+    static MetricTimer t;
+    return t;
+}
+
+MetricCounter& metricCounter(const char*, const char*, const std::string&) {
+    static MetricCounter c;
+    return c;
+}
+
+#endif
+
+void Metrics::writeFile(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write " + path);
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (json) writeJson(out);
+    else writePrometheus(out);
+}
@@ -0,0 +1,26 @@
+#include "StringArena.h"
+#include <algorithm>
+
+void StringArena::newBlock(std::size_t atLeast) {
+    // strings longer than a block get a block of their own
+    std::size_t size = std::max(atLeast, BLOCK_SIZE);
+    blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+    ptr = blocks.back().get();
+    left = size;
+    reserved += size;
+}
+
+void StringArena::adopt(StringArena&& other) {
+    // keep filling our current block; other's partially used one is simply retired
+    for (auto& b : other.blocks) blocks.push_back(std::move(b));
+    reserved += other.reserved;
+    other.blocks.clear();
+    other.clear();
+}
+
+void StringArena::clear() {
+    blocks.clear();
+    ptr = nullptr;
+    left = 0;
+    reserved = 0;
+}
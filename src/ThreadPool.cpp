@@ -0,0 +1,99 @@
+#include "ThreadPool.h"
+
+namespace {
+
+// identifies the pool and queue of the current worker thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local unsigned current_index = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i) workers.emplace_back([this, i] { loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(sleepMutex);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lk(doneMutex);
+        ++pending;
+    }
+    // count first so a worker that takes the task never sees `queued` go below zero
+    {
+        std::lock_guard<std::mutex> lk(sleepMutex);
+        ++queued;
+    }
+    unsigned q = current_pool == this ? current_index
+                                      : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    {
+        std::lock_guard<std::mutex> lk(queues[q]->m);
+        queues[q]->tasks.push_back(std::move(task));
+    }
+    sleepCv.notify_one();
+}
+
+bool ThreadPool::take(unsigned id, std::function<void()>& task) {
+    // own queue from the back, then steal from the front of the others
+    for (unsigned k = 0; k < size(); ++k) {
+        Queue& q = *queues[(id + k) % size()];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (q.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::loop(unsigned id) {
+    current_pool = this;
+    current_index = id;
+    while (true) {
+        std::function<void()> task;
+        if (take(id, task)) {
+            {
+                std::lock_guard<std::mutex> lk(sleepMutex);
+                --queued;
+            }
+            std::exception_ptr err;
+            try {
+                task();
+            } catch (...) {
+                err = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lk(doneMutex);
+            if (err && !firstError) firstError = err;
+            if (--pending == 0) doneCv.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(sleepMutex);
+        sleepCv.wait(lk, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lk(doneMutex);
+    doneCv.wait(lk, [this] { return pending == 0; });
+    if (firstError) {
+        std::exception_ptr err = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(err);
+    }
+}
@@ -0,0 +1,52 @@
+#include "ToolIO.h"
+#include <cstdio>
+
+namespace {
+
+bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+ToolArgs::ToolArgs(std::string_view text) : all(text) {
+    std::size_t i = 0;
+    while (count < MAX_WORDS) {
+        while (i < text.size() && is_separator(text[i])) ++i;
+        if (i == text.size()) break;
+        std::size_t b = i;
+        while (i < text.size() && !is_separator(text[i])) ++i;
+        words[count++] = text.substr(b, i - b);
+    }
+}
+
+std::string_view ToolArgs::rest(std::size_t i) const {
+    if (i == 0) return all;
+    if (i > count) return std::string_view();
+    const std::string_view& prev = words[i - 1];
+    std::size_t end = (std::size_t)(prev.data() - all.data()) + prev.size();
+    return end < all.size() ? all.substr(end + 1) : std::string_view();
+}
+
+bool ToolArgs::toInt(std::size_t i, long long* out) const {
+    std::string_view w = (*this)[i];
+    if (w.empty()) return false;
+    const char* first = w.data() + (w[0] == '+' && w.size() > 1 ? 1 : 0);
+    auto r = std::from_chars(first, w.data() + w.size(), *out);
+    return r.ec == std::errc() && r.ptr == w.data() + w.size();
+}
+
+bool ToolArgs::toDouble(std::size_t i, double* out) const {
+    std::string_view w = (*this)[i];
+    if (w.empty()) return false;
+    const char* first = w.data() + (w[0] == '+' && w.size() > 1 ? 1 : 0);
+    auto r = std::from_chars(first, w.data() + w.size(), *out);
+    return r.ec == std::errc() && r.ptr == w.data() + w.size();
+}
+
+ToolOutput& ToolOutput::operator<<(double v) {
+    char tmp[32];
+    int n = std::snprintf(tmp, sizeof tmp, "%g", v);
+    buf.append(tmp, (std::size_t)n);
+    return *this;
+}
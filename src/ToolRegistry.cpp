@@ -1,24 +1,156 @@
 #include "ToolRegistry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - Registration keeps three sorted vectors: display names (listTools), exact names + aliases,
+   and the same keys lowercased for resolve(). Registration happens once at startup; lookups
+   binary-search on string_view, so a server request does not build a std::string, and a
+   prefix is a contiguous range in the lowercased index.
+ - An entry's tool pointer is published with release / acquire; the first get() of a tool
+   constructs it under a mutex (double-checked), so concurrent server workers build it once.
+ - Construction also registers the tool's metrics, so unused tools never show up in exports.
+*/
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string fold(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = (char)std::tolower((unsigned char)c);
+    return out;
+}
+
+bool trace_enabled() {
+    static const bool on = [] {
+        const char* v = std::getenv("SUITE_TRACE_STARTUP");
+        return v && *v && std::string(v) != "0";
+    }();
+    return on;
+}
+
+// first use is the registry's creation, i.e. static initialization
+Clock::time_point trace_origin() {
+    static const Clock::time_point t = Clock::now();
+    return t;
+}
+
+template <class Keys>
+auto lower(Keys& keys, std::string_view text) {
+    return std::lower_bound(keys.begin(), keys.end(), text,
+                            [](const auto& k, std::string_view t) { return k.text < t; });
+}
+
+} // namespace
 
 ToolRegistry& ToolRegistry::instance() {
+    trace_origin();
     static ToolRegistry inst;
     return inst;
 }
 
+void ToolRegistry::traceStartup(std::string_view what) {
+    if (!trace_enabled()) return;
+    static Clock::time_point last = trace_origin();
+    Clock::time_point now = Clock::now();
+    spdlog::info("startup +{:.3f} ms ({:.3f} ms) {}",
+                 std::chrono::duration<double, std::milli>(now - trace_origin()).count(),
+                 std::chrono::duration<double, std::milli>(now - last).count(), what);
+    last = now;
+}
+
+bool ToolRegistry::registerFactory(ToolInfo info) {
+    std::vector<std::string> keys = info.aliases;
+    keys.insert(keys.begin(), info.name);
+    for (const auto& k : keys)
+        if (findExact(k)) return false;
+
+    entries.push_back(std::make_unique<Entry>());
+    Entry* e = entries.back().get();
+    e->info = std::move(info);
+    sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), e->info.name), e->info.name);
+    for (const auto& k : keys) {
+        exact.insert(lower(exact, k), Key{k, e});
+        std::string f = fold(k);
+        auto at = lower(folded, f);
+        folded.insert(at, Key{std::move(f), e});
+    }
+    return true;
+}
+
 bool ToolRegistry::registerTool(std::unique_ptr<Tool> tool) {
-    std::string n = tool->name();
-    tools[n] = std::move(tool);
+    Tool* t = tool.get();
+    if (!registerFactory({t->name(), t->description(), {}, nullptr})) return false;
+    Entry& e = *entries.back();
+    t->enableMetrics();
+    e.owned = std::move(tool);
+    e.tool.store(t, std::memory_order_release);
     return true;
 }
 
-Tool* ToolRegistry::get(const std::string& name) {
-    if (tools.count(name)) return tools[name].get();
-    return nullptr;
+Tool* ToolRegistry::construct(Entry& e) {
+    std::lock_guard<std::mutex> lk(constructing);
+    if (Tool* t = e.tool.load(std::memory_order_relaxed)) return t;
+
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<Tool> tool = e.info.factory();
+    if (!tool || tool->name() != e.info.name)
+        throw std::runtime_error("Tool factory for " + e.info.name + " built " + (tool ? tool->name() : "nothing"));
+    tool->enableMetrics();
+    if (trace_enabled())
+        spdlog::info("constructed {} in {:.3f} ms", e.info.name,
+                     std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+    e.owned = std::move(tool);
+    e.tool.store(e.owned.get(), std::memory_order_release);
+    return e.owned.get();
+}
+
+ToolRegistry::Entry* ToolRegistry::findExact(std::string_view name) const {
+    auto it = lower(exact, name);
+    return it != exact.end() && it->text == name ? it->entry : nullptr;
 }
 
-std::vector<std::string> ToolRegistry::listTools() const {
+std::vector<ToolRegistry::Entry*> ToolRegistry::findPrefix(std::string_view query) const {
+    std::string q = fold(query);
+    std::vector<Entry*> found;
+    for (auto it = lower(folded, q); it != folded.end() && it->text.compare(0, q.size(), q) == 0; ++it) {
+        if (it->text == q) return {it->entry}; // a whole name or alias beats longer ones
+        if (std::find(found.begin(), found.end(), it->entry) == found.end()) found.push_back(it->entry);
+    }
+    return found;
+}
+
+Tool* ToolRegistry::get(std::string_view name) {
+    Entry* e = findExact(name);
+    if (!e) return nullptr;
+    if (Tool* t = e->tool.load(std::memory_order_acquire)) return t;
+    return construct(*e);
+}
+
+Tool* ToolRegistry::resolve(std::string_view query) {
+    if (Tool* t = get(query)) return t;
+    if (query.empty()) return nullptr;
+    std::vector<Entry*> found = findPrefix(query);
+    if (found.size() != 1) return nullptr;
+    return get(found[0]->info.name);
+}
+
+std::vector<std::string> ToolRegistry::matches(std::string_view query) const {
     std::vector<std::string> names;
-    for (auto& p : tools) names.push_back(p.first);
+    if (query.empty()) return names;
+    for (Entry* e : findPrefix(query)) names.push_back(e->info.name);
+    std::sort(names.begin(), names.end());
     return names;
 }
 
+const ToolRegistry::ToolInfo* ToolRegistry::info(std::string_view name) const {
+    Entry* e = findExact(name);
+    return e ? &e->info : nullptr;
+}
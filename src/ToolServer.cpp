@@ -0,0 +1,528 @@
+#include "ToolServer.h"
+#include "Metrics.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ Implementation details:
+ - Only the event-loop thread touches connections. A worker gets the tool, the input and
+   (connection id, sequence number); its reply goes into a mutex-protected completion list
+   and an eventfd wakes the loop, which files the reply under its sequence number and moves
+   every reply that is next in line into the connection's output buffer.
+ - Connections are looked up by a 64-bit id rather than the fd, so a reply for a connection
+   that closed meanwhile cannot reach a new connection that reused the fd.
+ - Reading stops (EPOLLIN is dropped) while MAX_PIPELINE requests of a connection are in
+   flight; EPOLLOUT is only requested while output is pending.
+ - Latencies go into a log-linear histogram (MetricBuckets: 8 sub-buckets per power of two
+   of nanoseconds, so percentiles are within 12.5%) that only the loop thread updates.
+ - SIGINT / SIGTERM are blocked before the workers start (they inherit the mask) and read
+   through a signalfd, so they arrive as ordinary events.
+*/
+
+namespace {
+
+constexpr std::size_t READ_CHUNK = 64 * 1024;
+constexpr const char* STATS_TOOL = "!stats";
+constexpr const char* METRICS_TOOL = "!metrics";
+
+std::uint32_t read_u32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (std::uint32_t)u[0] | (std::uint32_t)u[1] << 8 | (std::uint32_t)u[2] << 16 | (std::uint32_t)u[3] << 24;
+}
+
+void append_u32(std::string& s, std::uint32_t v) {
+    char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+    s.append(b, 4);
+}
+
+void append_frame(std::string& s, char status, std::string_view body) {
+    append_u32(s, (std::uint32_t)body.size() + 1);
+    s.push_back(status);
+    s.append(body.data(), body.size());
+}
+
+sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr.sun_path) throw std::runtime_error("Socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+class LatencyHistogram {
+public:
+    void add(std::uint64_t ns) {
+        ++counts[MetricBuckets::index(ns)];
+        ++total;
+        maxNs = std::max(maxNs, ns);
+    }
+
+    // upper bound of the bucket holding the q-quantile
+    std::uint64_t quantile(double q) const {
+        if (total == 0) return 0;
+        std::uint64_t rank = (std::uint64_t)(q * (double)(total - 1)) + 1, seen = 0;
+        for (std::size_t b = 0; b < MetricBuckets::COUNT; ++b) {
+            seen += counts[b];
+            if (seen >= rank) return std::min(MetricBuckets::upper(b), maxNs);
+        }
+        return maxNs;
+    }
+
+    std::uint64_t max() const { return maxNs; }
+
+private:
+    std::uint64_t counts[MetricBuckets::COUNT] = {};
+    std::uint64_t total = 0;
+    std::uint64_t maxNs = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+    std::size_t inPos = 0;
+    std::string out;
+    std::size_t outPos = 0;
+    std::uint64_t nextSeq = 0;  // assigned to the next request
+    std::uint64_t nextSend = 0; // reply that goes out next
+    std::map<std::uint64_t, std::string> done; // replies waiting for an earlier one
+    std::size_t inFlight = 0;
+    bool peerClosed = false;
+    std::uint32_t events = 0; // currently registered with epoll
+};
+
+struct Completion {
+    std::uint64_t conn;
+    std::uint64_t seq;
+    bool ok;
+    std::string body;
+    Clock::time_point start;
+};
+
+} // namespace
+
+struct ToolServer::Impl {
+    ToolRegistry& registry;
+    std::string path;
+    unsigned threads;
+
+    int epfd = -1, listenFd = -1, wakeFd = -1, sigFd = -1;
+    std::atomic<bool> stopRequested{false};
+    std::unordered_map<std::uint64_t, Conn> conns; // by id
+    std::unordered_map<int, std::uint64_t> byFd;
+    std::uint64_t nextId = 1;
+
+    std::mutex doneMutex;
+    std::vector<Completion> completions; // guarded by doneMutex
+
+    LatencyHistogram latency;
+    Stats st;
+
+    Impl(ToolRegistry& r, std::string p, unsigned t) : registry(r), path(std::move(p)), threads(t) {}
+
+    void setEvents(Conn& c, std::uint32_t ev) {
+        if (ev == c.events) return;
+        epoll_event e{};
+        e.events = ev;
+        e.data.u64 = byFd[c.fd];
+        ::epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &e);
+        c.events = ev;
+    }
+
+    void updateEvents(Conn& c) {
+        std::uint32_t ev = 0;
+        if (!c.peerClosed && c.inFlight < MAX_PIPELINE) ev |= EPOLLIN;
+        if (c.outPos < c.out.size()) ev |= EPOLLOUT;
+        setEvents(c, ev);
+    }
+
+    void closeConn(std::uint64_t id) {
+        auto it = conns.find(id);
+        if (it == conns.end()) return;
+        ::epoll_ctl(epfd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        ::close(it->second.fd);
+        byFd.erase(it->second.fd);
+        conns.erase(it);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, or a transient error; epoll reports the next one
+            std::uint64_t id = nextId++;
+            Conn& c = conns[id];
+            c.fd = fd;
+            c.events = EPOLLIN;
+            byFd[fd] = id;
+            epoll_event e{};
+            e.events = EPOLLIN;
+            e.data.u64 = id;
+            ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &e);
+            ++st.connections;
+        }
+    }
+
+    // hands complete frames to the pool; false if the connection must be dropped
+    bool dispatch(std::uint64_t id, Conn& c, ThreadPool& pool) {
+        while (c.inFlight < MAX_PIPELINE && c.in.size() - c.inPos >= 4) {
+            std::uint32_t len = read_u32(c.in.data() + c.inPos);
+            if (len > MAX_FRAME) return false;
+            if (c.in.size() - c.inPos - 4 < len) break;
+            std::string_view frame(c.in.data() + c.inPos + 4, len);
+            c.inPos += 4 + (std::size_t)len;
+
+            std::uint64_t seq = c.nextSeq++;
+            Clock::time_point start = Clock::now();
+            std::size_t nul = frame.find('\0');
+            std::string_view name = frame.substr(0, nul);
+            std::string_view input = nul == std::string_view::npos ? std::string_view() : frame.substr(nul + 1);
+            ++c.inFlight;
+            if (name == STATS_TOOL) {
+                finish({id, seq, true, formatStats(current()), start});
+                continue;
+            }
+            if (name == METRICS_TOOL) {
+                std::ostringstream text;
+                if (input == "json") Metrics::writeJson(text);
+                else Metrics::writePrometheus(text);
+                finish({id, seq, true, text.str(), start});
+                continue;
+            }
+            Tool* tool = registry.get(name);
+            if (!tool) {
+                finish({id, seq, false, "Unknown tool: " + std::string(name), start});
+                continue;
+            }
+            pool.submit([this, tool, id, seq, start, in = std::string(input)] {
+                Completion r{id, seq, true, std::string(), start};
+                // the reply buffer keeps its capacity across this worker's requests
+                thread_local ToolOutput out;
+                out.clear();
+                try {
+                    tool->invoke(ToolArgs(in), out);
+                    r.body.assign(out.view());
+                } catch (const std::exception& e) {
+                    r.ok = false;
+                    r.body = e.what();
+                }
+                {
+                    std::lock_guard<std::mutex> lk(doneMutex);
+                    completions.push_back(std::move(r));
+                }
+                std::uint64_t one = 1;
+                (void)!::write(wakeFd, &one, sizeof one);
+            });
+        }
+        if (c.inPos == c.in.size()) {
+            c.in.clear();
+            c.inPos = 0;
+        } else if (c.inPos > c.in.size() / 2) {
+            c.in.erase(0, c.inPos);
+            c.inPos = 0;
+        }
+        return true;
+    }
+
+    // files a reply and queues every reply that is now next in line
+    void finish(Completion r) {
+        auto it = conns.find(r.conn);
+        if (it == conns.end()) return; // the client went away
+        Conn& c = it->second;
+        latency.add((std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - r.start).count());
+        ++st.requests;
+        if (!r.ok) ++st.errors;
+        --c.inFlight;
+        if (r.seq == c.nextSend) {
+            append_frame(c.out, r.ok ? '+' : '-', r.body);
+            ++c.nextSend;
+            for (auto d = c.done.begin(); d != c.done.end() && d->first == c.nextSend; d = c.done.erase(d)) {
+                c.out += d->second;
+                ++c.nextSend;
+            }
+        } else {
+            std::string frame;
+            append_frame(frame, r.ok ? '+' : '-', r.body);
+            c.done.emplace(r.seq, std::move(frame));
+        }
+    }
+
+    // false if the connection is finished or broken
+    bool flushOut(Conn& c) {
+        while (c.outPos < c.out.size()) {
+            ssize_t w = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (w < 0) return false;
+            c.outPos += (std::size_t)w;
+        }
+        if (c.outPos == c.out.size()) {
+            c.out.clear();
+            c.outPos = 0;
+        }
+        return !(c.peerClosed && c.inFlight == 0 && c.out.empty());
+    }
+
+    void onReadable(std::uint64_t id, Conn& c, ThreadPool& pool) {
+        char buf[READ_CHUNK];
+        while (true) {
+            ssize_t r = ::read(c.fd, buf, sizeof buf);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (r < 0) {
+                closeConn(id);
+                return;
+            }
+            if (r == 0) {
+                // no more requests (shutdown of the write side); replies in flight still go out
+                c.peerClosed = true;
+                break;
+            }
+            c.in.append(buf, (std::size_t)r);
+            if (c.in.size() - c.inPos > MAX_FRAME + 4) break; // dispatch() decides
+        }
+        if (!dispatch(id, c, pool)) {
+            closeConn(id);
+            return;
+        }
+        progress(id, c);
+    }
+
+    void progress(std::uint64_t id, Conn& c) {
+        if (!flushOut(c)) {
+            closeConn(id);
+            return;
+        }
+        updateEvents(c);
+    }
+
+    void drainCompletions(ThreadPool& pool) {
+        std::uint64_t n;
+        (void)!::read(wakeFd, &n, sizeof n);
+        std::vector<Completion> batch;
+        {
+            std::lock_guard<std::mutex> lk(doneMutex);
+            batch.swap(completions);
+        }
+        std::vector<std::uint64_t> touched;
+        for (Completion& r : batch) {
+            touched.push_back(r.conn);
+            finish(std::move(r));
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (std::uint64_t id : touched) {
+            auto it = conns.find(id);
+            if (it == conns.end()) continue;
+            // room in the pipeline again: frames already buffered can go now
+            if (!dispatch(id, it->second, pool)) {
+                closeConn(id);
+                continue;
+            }
+            progress(id, it->second);
+        }
+    }
+
+    Stats current() const {
+        Stats s = st;
+        s.p50Micros = (double)latency.quantile(0.50) / 1e3;
+        s.p99Micros = (double)latency.quantile(0.99) / 1e3;
+        s.maxMicros = (double)latency.max() / 1e3;
+        return s;
+    }
+
+    void openSocket() {
+        sockaddr_un addr = unix_address(path);
+        // a live server keeps its socket; a stale file from a crashed one is replaced
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe >= 0) {
+            bool live = ::connect(probe, (sockaddr*)&addr, sizeof addr) == 0;
+            ::close(probe);
+            if (live) throw std::runtime_error("A server is already listening on " + path);
+        }
+        ::unlink(path.c_str());
+
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        mode_t old = ::umask(0177);
+        int rc = ::bind(listenFd, (sockaddr*)&addr, sizeof addr);
+        ::umask(old);
+        if (rc != 0) throw std::runtime_error("Cannot bind " + path + ": " + std::strerror(errno));
+        if (::listen(listenFd, SOMAXCONN) != 0) throw std::runtime_error(std::string("listen: ") + std::strerror(errno));
+    }
+
+    void closeAll() {
+        for (auto& kv : conns) ::close(kv.second.fd);
+        conns.clear();
+        byFd.clear();
+        for (int* fd : {&listenFd, &wakeFd, &sigFd, &epfd}) {
+            if (*fd >= 0) ::close(*fd);
+            *fd = -1;
+        }
+    }
+};
+
+ToolServer::ToolServer(ToolRegistry& registry, std::string socketPath, unsigned threads)
+    : impl(std::make_unique<Impl>(registry, std::move(socketPath), threads)) {}
+
+ToolServer::~ToolServer() {
+    impl->closeAll();
+}
+
+void ToolServer::stop() {
+    impl->stopRequested.store(true);
+    if (impl->wakeFd >= 0) {
+        std::uint64_t one = 1;
+        (void)!::write(impl->wakeFd, &one, sizeof one);
+    }
+}
+
+ToolServer::Stats ToolServer::stats() const {
+    return impl->current();
+}
+
+std::string ToolServer::formatStats(const Stats& s) {
+    std::ostringstream o;
+    o << "connections " << s.connections << ", requests " << s.requests << ", errors " << s.errors
+      << ", latency p50 " << s.p50Micros << " us, p99 " << s.p99Micros << " us, max " << s.maxMicros << " us\n";
+    return o.str();
+}
+
+void ToolServer::serve() {
+    Impl& m = *impl;
+    m.openSocket();
+    m.epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    m.wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    sigset_t oldMask;
+    ::pthread_sigmask(SIG_BLOCK, &sigs, &oldMask);
+    m.sigFd = ::signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m.epfd < 0 || m.wakeFd < 0 || m.sigFd < 0) {
+        ::pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+        throw std::runtime_error(std::string("Server setup failed: ") + std::strerror(errno));
+    }
+    // ids 0 and below nextId's start are never connections
+    constexpr std::uint64_t LISTEN_ID = 0, WAKE_ID = ~0ull, SIG_ID = ~0ull - 1;
+    for (auto [fd, id] : {std::pair<int, std::uint64_t>{m.listenFd, LISTEN_ID}, {m.wakeFd, WAKE_ID}, {m.sigFd, SIG_ID}}) {
+        epoll_event e{};
+        e.events = EPOLLIN;
+        e.data.u64 = id;
+        ::epoll_ctl(m.epfd, EPOLL_CTL_ADD, fd, &e);
+    }
+
+    {
+        ThreadPool pool(m.threads); // joined before the connections go away
+        epoll_event events[64];
+        while (!m.stopRequested.load()) {
+            int n = ::epoll_wait(m.epfd, events, 64, -1);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) break;
+            for (int i = 0; i < n; ++i) {
+                std::uint64_t id = events[i].data.u64;
+                if (id == LISTEN_ID) {
+                    m.acceptAll();
+                } else if (id == WAKE_ID) {
+                    m.drainCompletions(pool);
+                } else if (id == SIG_ID) {
+                    // consume it, or it would fire when the mask is restored
+                    signalfd_siginfo info;
+                    (void)!::read(m.sigFd, &info, sizeof info);
+                    m.stopRequested.store(true);
+                } else {
+                    auto it = m.conns.find(id);
+                    if (it == m.conns.end()) continue;
+                    Conn& c = it->second;
+                    // both directions closed: nobody is left to read the replies
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) m.closeConn(id);
+                    else if (events[i].events & EPOLLIN) m.onReadable(id, c, pool);
+                    else if (events[i].events & EPOLLOUT) m.progress(id, c);
+                }
+            }
+        }
+    }
+
+    ::unlink(m.path.c_str());
+    m.closeAll();
+    ::pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+}
+
+ToolClient::ToolClient(const std::string& socketPath) {
+    sockaddr_un addr = unix_address(socketPath);
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof addr) != 0) {
+        int err = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Cannot connect to " + socketPath + ": " + std::strerror(err));
+    }
+}
+
+ToolClient::~ToolClient() {
+    if (fd >= 0) ::close(fd);
+}
+
+void ToolClient::send(std::string_view tool, std::string_view input) {
+    std::string frame;
+    append_u32(frame, (std::uint32_t)(tool.size() + 1 + input.size()));
+    frame.append(tool.data(), tool.size());
+    frame.push_back('\0');
+    frame.append(input.data(), input.size());
+    const char* p = frame.data();
+    std::size_t left = frame.size();
+    while (left > 0) {
+        ssize_t w = ::send(fd, p, left, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) throw std::runtime_error(std::string("Send failed: ") + std::strerror(errno));
+        p += w;
+        left -= (std::size_t)w;
+    }
+}
+
+bool ToolClient::receive(std::string& body, bool* ok) {
+    char chunk[READ_CHUNK];
+    while (buf.size() < 4 || buf.size() - 4 < read_u32(buf.data())) {
+        ssize_t r = ::read(fd, chunk, sizeof chunk);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("Receive failed: ") + std::strerror(errno));
+        if (r == 0) return false;
+        buf.append(chunk, (std::size_t)r);
+    }
+    std::uint32_t len = read_u32(buf.data());
+    if (len == 0) throw std::runtime_error("Malformed response");
+    *ok = buf[4] == '+';
+    body.assign(buf, 5, len - 1);
+    buf.erase(0, 4 + (std::size_t)len);
+    return true;
+}
+
+std::string ToolClient::call(std::string_view tool, std::string_view input) {
+    send(tool, input);
+    std::string body;
+    bool ok;
+    if (!receive(body, &ok)) throw std::runtime_error("Server closed the connection");
+    if (!ok) throw std::runtime_error(body);
+    return body;
+}
@@ -1,25 +1,394 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include <sys/resource.h>
+#include "ConfigManager.h"
+#include "Metrics.h"
 #include "ToolRegistry.h"
+#ifdef SUITE_TOOL_SERVER
+#include "ToolServer.h"
+#endif
+#include "tools/CalculatorTool.h"
+#include "tools/ColorPickerTool.h"
+#include "tools/PpmImage.h"
+#include "tools/TextEncryptTool.h"
+#include "tools/TextStatsTool.h"
+#include "tools/UnitBatch.h"
 
-int main() {
-    auto& reg = ToolRegistry::instance();
+namespace {
 
-    while (true) {
-        std::cout << "\n=== Personal Utility Suite ===\n";
-        std::cout << "Available tools:\n";
+// SUITE_METRICS_OUT=<file>: every metric is written there when the program exits
+void write_metrics_at_exit() {
+    const char* path = std::getenv("SUITE_METRICS_OUT");
+    if (!path || !*path) return;
+    try {
+        Metrics::writeFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+    }
+}
+
+// --batch [file|-] [--threads N]: evaluate one expression per line without the menu
+int run_batch(int argc, char** argv) {
+    std::string path = "-";
+    unsigned threads = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc) threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else path = a;
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = path == "-" ? std::cin : file;
+
+    CalculatorTool calc;
+    auto st = calc.runBatch(in, std::cout, threads);
+    std::cerr << "batch: " << st.lines << " lines in " << st.seconds << " s ("
+              << (st.seconds > 0 ? st.lines / st.seconds : 0.0) << " lines/s, "
+              << st.threads << " threads)\n";
+    return 0;
+}
+
+// --textstats [file|-] [--threads N] [--top N] [--approx] [--mem]: one-pass text statistics of a
+// file (memory-mapped) or stdin; defaults from the "textstats" section of config.json.
+// --mem adds word storage and peak resident memory.
+// --follow [--interval S] [--window-lines N] [--window-seconds S]: rolling statistics of a growing
+// input (e.g. tail -f), printed every S seconds
+int run_textstats(int argc, char** argv) {
+    std::string path = "-";
+    unsigned threads = 0;
+    bool mem = false;
+    bool follow = false;
+    double interval = 1.0;
+    TextStatsOptions opt = TextStatsTool::loadOptions();
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc) threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--top" && i + 1 < argc) opt.topN = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--approx") opt.approximate = true;
+        else if (a == "--mem") mem = true;
+        else if (a == "--follow") follow = true;
+        else if (a == "--interval" && i + 1 < argc) interval = std::strtod(argv[++i], nullptr);
+        else if (a == "--window-lines" && i + 1 < argc) opt.windowLines = std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--window-seconds" && i + 1 < argc) opt.windowSeconds = std::max(0.0, std::strtod(argv[++i], nullptr));
+        else path = a;
+    }
+    std::ios::sync_with_stdio(false);
+    try {
+        if (follow) {
+            std::ifstream file;
+            if (path != "-") {
+                file.open(path, std::ios::binary);
+                if (!file.is_open()) throw std::runtime_error("Cannot open " + path);
+            }
+            TextStatsTool::follow(path == "-" ? std::cin : file, std::cout, opt, interval);
+            return 0;
+        }
+        auto s = TextStatsTool::analyzeFile(path, opt, threads);
+        TextStatsTool::printSummary(std::cout, s, opt.topN);
+        if (mem) {
+            struct rusage ru;
+            ::getrusage(RUSAGE_SELF, &ru);
+            std::cout << "Distinct words kept: " << s.distinctWords << "\n";
+            std::cout << "Word storage: " << s.wordMemoryBytes / 1024 << " KiB\n";
+            std::cout << "Peak RSS: " << ru.ru_maxrss << " KiB\n"; // kilobytes on Linux
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// --encrypt|--decrypt <in|-> <out|-> [--method xor|caesar|base64] [--key k] [--shift n]: streams a
+// file through the cipher or the Base64 codec; defaults from the "encrypt" section of config.json.
+// --encrypt-bench [MiB]: kernel throughput
+int run_encrypt(int argc, char** argv) {
+    std::string mode = argv[1];
+    if (mode == "--encrypt-bench") {
+        std::size_t mib = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+        TextEncryptTool::benchmark(std::cout, std::max<std::size_t>(1, mib) << 20);
+        return 0;
+    }
+    CryptSettings s = TextEncryptTool::loadSettings();
+    s.decrypt = mode == "--decrypt";
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--method" && i + 1 < argc) s.method = cryptMethodFromName(argv[++i]);
+        else if (a == "--key" && i + 1 < argc) s.key = argv[++i];
+        else if (a == "--shift" && i + 1 < argc) s.shift = (int)std::strtol(argv[++i], nullptr, 10);
+        else paths.push_back(a);
+    }
+    if (paths.size() != 2) {
+        std::cerr << "usage: " << mode << " <in|-> <out|-> [--method xor|caesar|base64] [--key k] [--shift n]\n";
+        return 1;
+    }
+    try {
+        TextEncryptTool::cryptFile(paths[0], paths[1], s);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// --units <from> <to> [file|-] [--column C]... [--header] [--delimiter X] [--digits N]: converts
+// CSV columns (1-based numbers, or names with --header; default column 1) and writes the CSV to stdout
+int run_units(int argc, char** argv) {
+    const char* usage = "usage: --units <from> <to> [file|-] [--column C]... [--header] [--delimiter X] [--digits N]\n";
+    if (argc < 4) {
+        std::cerr << usage;
+        return 1;
+    }
+    std::string path = "-";
+    UnitCsvOptions opt;
+    std::vector<std::string> columns;
+    for (int i = 4; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--column" && more) columns.push_back(argv[++i]);
+        else if (a == "--header") opt.header = true;
+        else if (a == "--delimiter" && more) opt.delimiter = std::string(argv[++i]) == "\\t" ? '\t' : argv[i][0];
+        else if (a == "--digits" && more) opt.digits = (int)std::strtol(argv[++i], nullptr, 10);
+        else if (a.size() > 2 && a.compare(0, 2, "--") == 0) {
+            std::cerr << usage;
+            return 1;
+        } else path = a;
+    }
+    if (!columns.empty()) opt.columns = columns;
+
+    std::ios::sync_with_stdio(false);
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = path == "-" ? std::cin : file;
+    try {
+        opt.conversion = unitConversion(argv[2], argv[3]);
+        UnitCsvStats st = convertUnitCsv(in, std::cout, opt);
+        std::cerr << "units: " << st.rows << " rows, " << st.values << " values converted, " << st.skipped
+                  << " skipped in " << st.seconds << " s\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
 
-        for (auto& name : reg.listTools())
-            std::cout << " - " << name << "\n";
+// --color-bench [in.ppm|WxH] [--threads N]: conversion and palette matching throughput per kernel
+// level on an image (default: a 1920x1080 gradient with noise)
+// --palette <in.ppm> <out.ppm> [--threads N]: replaces every pixel by its nearest CSS named color
+int run_color(int argc, char** argv) {
+    bool bench = std::string(argv[1]) == "--color-bench";
+    unsigned threads = 1;
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc) threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else paths.push_back(a);
+    }
+    if (bench ? paths.size() > 1 : paths.size() != 2) {
+        std::cerr << (bench ? "usage: --color-bench [in.ppm|WxH] [--threads N]\n"
+                            : "usage: --palette <in.ppm> <out.ppm> [--threads N]\n");
+        return 1;
+    }
+    try {
+        if (!bench) {
+            auto t0 = std::chrono::steady_clock::now();
+            std::size_t n = ColorPickerTool::quantizeFile(paths[0], paths[1], threads);
+            double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            std::cerr << "palette: " << n << " pixels in " << dt << " s\n";
+            return 0;
+        }
+        PpmImage img;
+        std::size_t w = 1920, h = 1080;
+        if (!paths.empty() && std::sscanf(paths[0].c_str(), "%zux%zu", &w, &h) != 2) {
+            img = readPpm(paths[0]);
+        } else {
+            img.width = std::max<std::size_t>(1, w);
+            img.height = std::max<std::size_t>(1, h);
+            img.pixels.resize(img.size() * 3);
+            unsigned seed = 1;
+            for (std::size_t y = 0; y < img.height; ++y)
+                for (std::size_t x = 0; x < img.width; ++x) {
+                    std::uint8_t* p = &img.pixels[(y * img.width + x) * 3];
+                    seed = seed * 1103515245 + 12345;
+                    p[0] = (std::uint8_t)(x * 255 / img.width);
+                    p[1] = (std::uint8_t)(y * 255 / img.height);
+                    p[2] = (std::uint8_t)(seed >> 24);
+                }
+        }
+        ColorPickerTool::benchmark(std::cout, img, threads);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef SUITE_TOOL_SERVER
+// --serve <socket> [--threads N]: answer tool requests on a Unix socket until SIGINT / SIGTERM
+int run_serve(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: --serve <socket> [--threads N]\n";
+        return 1;
+    }
+    unsigned threads = 0;
+    for (int i = 3; i < argc; ++i)
+        if (std::string(argv[i]) == "--threads" && i + 1 < argc) threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+    try {
+        ToolServer server(ToolRegistry::instance(), argv[2], threads);
+        std::cerr << "serving on " << argv[2] << "\n";
+        // edits to config.json reach the tools while serving, as in the menu
+        ConfigManager::instance().watch();
+        server.serve();
+        ConfigManager::instance().unwatch();
+        std::cerr << ToolServer::formatStats(server.stats());
+        Metrics::logSummary();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
 
-        std::cout << "\nEnter tool name (or quit): ";
+// --request <socket> <tool> [input|-] [--repeat N]: one request to a running server ("-" or no
+// input reads stdin). --repeat pipelines N copies and reports the round-trip rate instead.
+int run_request(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: --request <socket> <tool> [input|-] [--repeat N]\n";
+        return 1;
+    }
+    std::string input = "-";
+    std::size_t repeat = 0;
+    for (int i = 4; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--repeat" && i + 1 < argc) repeat = std::strtoul(argv[++i], nullptr, 10);
+        else input = a;
+    }
+    if (input == "-") {
+        std::ostringstream ss;
+        ss << std::cin.rdbuf();
+        input = ss.str();
+    }
+    try {
+        ToolClient client(argv[2]);
+        if (repeat == 0) {
+            std::cout << client.call(argv[3], input);
+            return 0;
+        }
+        // keep a bounded window of requests in flight
+        constexpr std::size_t WINDOW = 32;
+        auto t0 = std::chrono::steady_clock::now();
+        std::size_t sent = 0, received = 0, errors = 0;
+        std::string body;
+        bool ok;
+        while (received < repeat) {
+            while (sent < repeat && sent - received < WINDOW) {
+                client.send(argv[3], input);
+                ++sent;
+            }
+            if (!client.receive(body, &ok)) throw std::runtime_error("Server closed the connection");
+            ++received;
+            if (!ok) ++errors;
+        }
+        double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << repeat << " requests in " << dt << " s (" << repeat / dt << " req/s, " << errors << " errors)\n";
+        std::cout << client.call("!stats", "");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+#else
+int run_serve(int, char**) {
+    std::cerr << "--serve is unsupported on this platform\n";
+    return 1;
+}
+
+int run_request(int, char**) {
+    std::cerr << "--request is unsupported on this platform\n";
+    return 1;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::atexit(write_metrics_at_exit);
+    if (argc > 1 && std::string(argv[1]) == "--batch") return run_batch(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--textstats") return run_textstats(argc, argv);
+    if (argc > 1 && (std::string(argv[1]) == "--encrypt" || std::string(argv[1]) == "--decrypt" ||
+                     std::string(argv[1]) == "--encrypt-bench"))
+        return run_encrypt(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--units") return run_units(argc, argv);
+    if (argc > 1 && (std::string(argv[1]) == "--color-bench" || std::string(argv[1]) == "--palette"))
+        return run_color(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--serve") return run_serve(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--request") return run_request(argc, argv);
+
+    auto& reg = ToolRegistry::instance();
+    // edits to config.json take effect without restarting
+    ConfigManager::instance().watch();
+    ToolRegistry::traceStartup("config loaded and watched");
+
+    // the tool list never changes after startup; build the menu once
+    std::string menu = "\n=== Personal Utility Suite ===\nAvailable tools:\n";
+    for (auto& name : reg.listTools()) {
+        menu += " - " + name;
+        if (const auto* info = reg.info(name); info && !info->aliases.empty()) {
+            menu += " (";
+            for (std::size_t i = 0; i < info->aliases.size(); ++i) menu += (i ? ", " : "") + info->aliases[i];
+            menu += ")";
+        }
+        menu += "\n";
+    }
+    menu += "\nEnter tool name (or quit): ";
+    ToolRegistry::traceStartup("menu ready");
+
+    while (true) {
+        std::cout << menu;
         std::string name;
         std::getline(std::cin, name);
 
         if (name == "quit") break;
+        if (name == "metrics") {
+            Metrics::writePrometheus(std::cout);
+            continue;
+        }
 
-        Tool* t = reg.get(name);
+        // full name, alias, or an unambiguous prefix of either (any case)
+        Tool* t = reg.resolve(name);
         if (!t) {
-            std::cout << "Tool not found!\n";
+            std::vector<std::string> candidates = reg.matches(name);
+            if (candidates.size() < 2) {
+                std::cout << "Tool not found!\n";
+                continue;
+            }
+            std::cout << "Ambiguous tool name, did you mean:";
+            for (const auto& c : candidates) std::cout << " " << c << ";";
+            std::cout << "\n";
             continue;
         }
 
@@ -27,4 +396,3 @@ int main() {
     }
     return 0;
 }
-
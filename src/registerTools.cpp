@@ -5,14 +5,21 @@
 #include "tools/TextStatsTool.h"
 #include "tools/UnitConverterTool.h"
 
+// only factories and metadata here: a tool is constructed the first time it is looked up.
+// Descriptions come from the tool classes, so the registry entry and description() always agree
 __attribute__((constructor))
 static void register_all_tools() {
     auto& r = ToolRegistry::instance();
 
-    r.registerTool(std::make_unique<CalculatorTool>());
-    r.registerTool(std::make_unique<ColorPickerTool>());
-    r.registerTool(std::make_unique<TextEncryptTool>());
-    r.registerTool(std::make_unique<TextStatsTool>());
-    r.registerTool(std::make_unique<UnitConverterTool>());
+    r.registerFactory({"Calculator", CalculatorTool::DESCRIPTION, {"calc"},
+                       [] { return std::make_unique<CalculatorTool>(); }});
+    r.registerFactory({"Color Picker", ColorPickerTool::DESCRIPTION, {"color"},
+                       [] { return std::make_unique<ColorPickerTool>(); }});
+    r.registerFactory({"Text Encrypt", TextEncryptTool::DESCRIPTION, {"encrypt"},
+                       [] { return std::make_unique<TextEncryptTool>(); }});
+    r.registerFactory({"Text Stats", TextStatsTool::DESCRIPTION, {"textstats"},
+                       [] { return std::make_unique<TextStatsTool>(); }});
+    r.registerFactory({"Unit Converter", UnitConverterTool::DESCRIPTION, {"unit"},
+                       [] { return std::make_unique<UnitConverterTool>(); }});
+    ToolRegistry::traceStartup("tools registered");
 }
-
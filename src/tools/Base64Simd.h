@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+/*
+ Base64Simd - Base64（RFC 4648 标准字母表）的批量编解码内核
+ - encode：编码 in 中尽可能长的、由完整 3 字节组构成的前缀，返回消耗的字节数（3 的倍数），
+   输出 4/3 倍的字符
+ - decode：解码由完整 4 字符组构成的前缀，遇到含非字母表字符（包括 '=' 和换行）的块就停下，
+   返回消耗的字符数（4 的倍数）；剩余部分和错误报告交给标量路径
+ - 向量内核只处理整块，可能少处理结尾的几十个字节；out 必须能容纳整个输入的结果
+*/
+struct Base64Kernels {
+    const char* name;
+    std::size_t (*encode)(const unsigned char* in, std::size_t n, char* out);
+    std::size_t (*decode)(const char* in, std::size_t n, unsigned char* out);
+};
+
+const Base64Kernels& base64ScalarKernels();
+#ifdef SUITE_X86_SIMD
+const Base64Kernels& base64Ssse3Kernels();
+const Base64Kernels& base64Avx2Kernels();
+#endif
+
+// best kernel set for the running CPU (see cpuSimdLevel)
+const Base64Kernels& base64Kernels();
@@ -0,0 +1,47 @@
+// Compiled with -mavx2; only called after runtime CPU detection.
+#include <immintrin.h>
+#include "Base64SimdKernels.inl"
+
+namespace {
+
+struct Avx2 {
+    using V = __m256i;
+    static constexpr std::size_t LANES = 2;
+    static constexpr std::size_t ENCODE_READ = 28; // two 16-byte loads, 12 bytes apart
+
+    static V load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static V loadEncode(const unsigned char* p) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+    static void store(char* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    // lanes hold 12 valid bytes each: close the gap before storing
+    static void storeDecoded(unsigned char* p, V v) {
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    static V dup(__m128i x) { return _mm256_broadcastsi128_si256(x); }
+    static V set1_8(char c) { return _mm256_set1_epi8(c); }
+    static V set1_32(int x) { return _mm256_set1_epi32(x); }
+    static V shuffle(V table, V idx) { return _mm256_shuffle_epi8(table, idx); }
+    static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V add_8(V a, V b) { return _mm256_add_epi8(a, b); }
+    static V subs_u8(V a, V b) { return _mm256_subs_epu8(a, b); }
+    static V cmpgt_8(V a, V b) { return _mm256_cmpgt_epi8(a, b); }
+    static V cmpeq_8(V a, V b) { return _mm256_cmpeq_epi8(a, b); }
+    static V srli_32(V a, int n) { return _mm256_srli_epi32(a, n); }
+    static V mulhi_u16(V a, V b) { return _mm256_mulhi_epu16(a, b); }
+    static V mullo_16(V a, V b) { return _mm256_mullo_epi16(a, b); }
+    static V maddubs(V a, V b) { return _mm256_maddubs_epi16(a, b); }
+    static V madd_16(V a, V b) { return _mm256_madd_epi16(a, b); }
+    static bool allZero(V a) { return _mm256_testz_si256(a, a) != 0; }
+};
+
+} // namespace
+
+const Base64Kernels& base64Avx2Kernels() {
+    static const Base64Kernels k = Base64VecKernels<Avx2>::table("avx2");
+    return k;
+}
@@ -0,0 +1,68 @@
+// Shared Base64 block codec for Base64Simd*.cpp (x86 only: the constants are SSE registers).
+// Each including translation unit provides a traits struct S whose vectors are made of
+// 16-byte lanes and is compiled with the matching target flags; everything here has
+// internal linkage.
+//
+// Encode and decode follow Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2
+// Instructions" (2018): multiply-shift to split 6-bit fields, a pshufb offset table to map
+// them to ASCII, and nibble lookup tables that validate and translate in one pass.
+#include "Base64Simd.h"
+#include <cstddef>
+
+namespace {
+
+template <class S>
+struct Base64VecKernels {
+    using V = typename S::V;
+    static constexpr std::size_t IN_BYTES = 12 * S::LANES; // raw bytes per block
+    static constexpr std::size_t CHARS = 16 * S::LANES;    // base64 chars per block
+
+    static std::size_t encode(const unsigned char* in, std::size_t n, char* out) {
+        const V spread = S::dup(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        const V offsets = S::dup(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+        std::size_t i = 0;
+        for (; i + S::ENCODE_READ <= n; i += IN_BYTES, out += CHARS) {
+            // each 32-bit word holds one 3-byte group as bytes b1 b0 b2 b1
+            V v = S::shuffle(S::loadEncode(in + i), spread);
+            V a = S::mulhi_u16(S::and_(v, S::set1_32(0x0fc0fc00)), S::set1_32(0x04000040));
+            V b = S::mullo_16(S::and_(v, S::set1_32(0x003f03f0)), S::set1_32(0x01000010));
+            V idx = S::or_(a, b); // one 6-bit index per byte
+            // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+            V reduced = S::subs_u8(idx, S::set1_8(51));
+            reduced = S::or_(reduced, S::and_(S::cmpgt_8(S::set1_8(26), idx), S::set1_8(13)));
+            S::store(out, S::add_8(idx, S::shuffle(offsets, reduced)));
+        }
+        return i;
+    }
+
+    static std::size_t decode(const char* in, std::size_t n, unsigned char* out) {
+        const V lutLo = S::dup(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                                             0x1B, 0x1B, 0x1B, 0x1A));
+        const V lutHi = S::dup(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                             0x10, 0x10, 0x10, 0x10));
+        const V lutRoll = S::dup(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+        const V pack = S::dup(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        std::size_t i = 0;
+        // the store writes CHARS bytes of which IN_BYTES are valid; the excess lands where the
+        // next block's output goes, so a further block of input must exist
+        for (; i + 2 * CHARS <= n; i += CHARS, out += IN_BYTES) {
+            V v = S::load(in + i);
+            V hi = S::and_(S::srli_32(v, 4), S::set1_8(0x0f));
+            V lo = S::and_(v, S::set1_8(0x0f));
+            if (!S::allZero(S::and_(S::shuffle(lutLo, lo), S::shuffle(lutHi, hi)))) break;
+            V roll = S::shuffle(lutRoll, S::add_8(S::cmpeq_8(v, S::set1_8('/')), hi));
+            V vals = S::add_8(v, roll); // 6-bit values
+            V pairs = S::maddubs(vals, S::set1_32(0x01400140));
+            V words = S::madd_16(pairs, S::set1_32(0x00011000)); // 24 bits per 32-bit word
+            S::storeDecoded(out, S::shuffle(words, pack));
+        }
+        return i;
+    }
+
+    static Base64Kernels table(const char* name) {
+        return {name, &encode, &decode};
+    }
+};
+
+} // namespace
@@ -0,0 +1,39 @@
+// Compiled with -mssse3; only called after runtime CPU detection.
+#include <tmmintrin.h>
+#include "Base64SimdKernels.inl"
+
+namespace {
+
+struct Ssse3 {
+    using V = __m128i;
+    static constexpr std::size_t LANES = 1;
+    static constexpr std::size_t ENCODE_READ = 16;
+
+    static V load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static V loadEncode(const unsigned char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(char* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static void storeDecoded(unsigned char* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V dup(__m128i x) { return x; }
+    static V set1_8(char c) { return _mm_set1_epi8(c); }
+    static V set1_32(int x) { return _mm_set1_epi32(x); }
+    static V shuffle(V table, V idx) { return _mm_shuffle_epi8(table, idx); }
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+    static V add_8(V a, V b) { return _mm_add_epi8(a, b); }
+    static V subs_u8(V a, V b) { return _mm_subs_epu8(a, b); }
+    static V cmpgt_8(V a, V b) { return _mm_cmpgt_epi8(a, b); }
+    static V cmpeq_8(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+    static V srli_32(V a, int n) { return _mm_srli_epi32(a, n); }
+    static V mulhi_u16(V a, V b) { return _mm_mulhi_epu16(a, b); }
+    static V mullo_16(V a, V b) { return _mm_mullo_epi16(a, b); }
+    static V maddubs(V a, V b) { return _mm_maddubs_epi16(a, b); }
+    static V madd_16(V a, V b) { return _mm_madd_epi16(a, b); }
+    static bool allZero(V a) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0xFFFF; }
+};
+
+} // namespace
+
+const Base64Kernels& base64Ssse3Kernels() {
+    static const Base64Kernels k = Base64VecKernels<Ssse3>::table("ssse3");
+    return k;
+}
@@ -0,0 +1,215 @@
+#include "CalcBatch.h"
+#include "CalcSimd.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// ---- scalar fallback kernels ----
+
+void s_add(const double* a, const double* b, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = a[i] + b[i]; }
+void s_sub(const double* a, const double* b, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = a[i] - b[i]; }
+void s_mul(const double* a, const double* b, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = a[i] * b[i]; }
+void s_affine(const double* x, double m, double a, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = x[i] * m + a; }
+bool s_div(const double* a, const double* b, double* out, std::size_t n) {
+    bool ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (b[i] == 0.0) ok = false;
+        out[i] = a[i] / b[i];
+    }
+    return ok;
+}
+void s_neg(const double* x, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = -x[i]; }
+void s_abs(const double* x, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = std::fabs(x[i]); }
+bool s_sqrt(const double* x, double* out, std::size_t n) {
+    bool ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (x[i] < 0) ok = false;
+        out[i] = std::sqrt(x[i]);
+    }
+    return ok;
+}
+void s_sin(const double* x, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = std::sin(x[i]); }
+void s_cos(const double* x, double* out, std::size_t n) { for (std::size_t i = 0; i < n; ++i) out[i] = std::cos(x[i]); }
+bool s_ln(const double* x, double* out, std::size_t n) {
+    bool ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (x[i] <= 0) ok = false;
+        out[i] = std::log(x[i]);
+    }
+    return ok;
+}
+bool s_log10(const double* x, double* out, std::size_t n) {
+    bool ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (x[i] <= 0) ok = false;
+        out[i] = std::log10(x[i]);
+    }
+    return ok;
+}
+
+// ---- column-wise evaluation ----
+
+constexpr std::size_t BLOCK = 512; // rows per block; keeps the working set in L1/L2
+
+// a stack entry is either a block of values or a broadcast constant
+struct Slot {
+    const double* p;
+    double k;
+    bool isConst;
+};
+
+struct BatchRunner {
+    const CalcKernels& kern = calcKernels();
+    std::vector<double>& scratch;
+    std::size_t levels = 0; // stack blocks in scratch; temp blocks follow
+    std::size_t m = 0;      // rows in the current block
+
+    double* buf(std::size_t depth) { return scratch.data() + depth * BLOCK; }
+    double* temp_buf(std::size_t slot) { return buf(levels + slot); }
+
+    // Tee: keep a copy, the stack block will be reused
+    Slot tee(const Slot& s, std::size_t slot) {
+        if (s.isConst) return s;
+        double* t = temp_buf(slot);
+        std::copy(s.p, s.p + m, t);
+        return {t, 0.0, false};
+    }
+
+    const double* materialize(const Slot& s, std::size_t depth) {
+        if (!s.isConst) return s.p;
+        double* b = buf(depth);
+        std::fill(b, b + m, s.k);
+        return b;
+    }
+
+    void binary(const CalcInstr& in, Slot& a, const Slot& b, std::size_t d) {
+        if (a.isConst && b.isConst) {
+            a.k = calcApply(in, a.k, b.k);
+            return;
+        }
+
+        double* o = buf(d);
+        if (in.op == CalcOp::Pow) {
+            // std::pow like CalcProgram::eval, so a row's result does not depend on where it
+            // falls in the block; x^2..x^8 arrive here already rewritten into multiplications
+            const double* pa = materialize(a, d);
+            const double* pb = materialize(b, d + 1);
+            for (std::size_t i = 0; i < m; ++i) o[i] = std::pow(pa[i], pb[i]);
+        } else {
+            const double* pa = materialize(a, d);
+            const double* pb = materialize(b, d + 1);
+            switch (in.op) {
+            case CalcOp::Add: kern.add(pa, pb, o, m); break;
+            case CalcOp::Sub: kern.sub(pa, pb, o, m); break;
+            case CalcOp::Mul: kern.mul(pa, pb, o, m); break;
+            case CalcOp::Div:
+                if (!kern.div(pa, pb, o, m)) throw std::runtime_error("Division by zero");
+                break;
+            default: break;
+            }
+        }
+        a = {o, 0.0, false};
+    }
+
+    void unary(const CalcInstr& in, Slot& a, std::size_t d) {
+        if (a.isConst) {
+            a.k = calcApply(in, a.k);
+            return;
+        }
+        const double* x = a.p;
+        double* o = buf(d);
+        if (in.op == CalcOp::Neg) {
+            kern.neg(x, o, m);
+        } else {
+            switch ((CalcFunc)in.slot) {
+            case CalcFunc::Sin: kern.sin(x, o, m); break;
+            case CalcFunc::Cos: kern.cos(x, o, m); break;
+            case CalcFunc::Abs: kern.abs(x, o, m); break;
+            case CalcFunc::Sqrt:
+                if (!kern.sqrt(x, o, m)) throw std::runtime_error("sqrt of negative");
+                break;
+            case CalcFunc::Log:
+                if (!kern.log10(x, o, m)) throw std::runtime_error("log of non-positive");
+                break;
+            case CalcFunc::Ln:
+                if (!kern.ln(x, o, m)) throw std::runtime_error("ln of non-positive");
+                break;
+            default:
+                for (std::size_t i = 0; i < m; ++i) o[i] = in.fn(x[i]);
+                break;
+            }
+        }
+        a = {o, 0.0, false};
+    }
+};
+
+} // namespace
+
+const CalcKernels& calcScalarKernels() {
+    static const CalcKernels k = {"scalar", s_add, s_sub, s_mul, s_div, s_neg, s_abs, s_sqrt, s_sin, s_cos, s_ln, s_log10, s_affine};
+    return k;
+}
+
+const CalcKernels& calcKernels() {
+    static const CalcKernels& k = [] () -> const CalcKernels& {
+#ifdef SUITE_X86_SIMD
+        SimdLevel level = cpuSimdLevel();
+        if (level >= SimdLevel::Avx2) return calcAvx2Kernels();
+        if (level >= SimdLevel::Sse2) return calcSse2Kernels();
+#endif
+        return calcScalarKernels();
+    }();
+    return k;
+}
+
+void evalCalcBatch(const CalcProgram& prog, const CalcColumn* columns, std::size_t rows, double* out) {
+    thread_local std::vector<double> scratch;
+    // one block per stack level, one for materializing a constant right operand, one per temp
+    std::size_t levels = prog.maxDepth + 1;
+    std::size_t need = (levels + prog.numTemps) * BLOCK;
+    if (scratch.size() < need) scratch.resize(need);
+
+    thread_local std::vector<Slot> stack;
+    thread_local std::vector<Slot> temps;
+    if (stack.size() < prog.maxDepth) stack.resize(prog.maxDepth);
+    if (temps.size() < prog.numTemps) temps.resize(prog.numTemps);
+
+    BatchRunner run{calcKernels(), scratch, levels};
+    for (std::size_t row0 = 0; row0 < rows; row0 += BLOCK) {
+        run.m = std::min(BLOCK, rows - row0);
+        std::size_t sp = 0;
+        for (const CalcInstr& in : prog.code) {
+            switch (in.op) {
+            case CalcOp::Const:
+                stack[sp++] = {nullptr, in.value, true};
+                break;
+            case CalcOp::Var: {
+                const CalcColumn& c = columns[in.slot];
+                stack[sp++] = c.data ? Slot{c.data + row0, 0.0, false} : Slot{nullptr, c.scalar, true};
+                break;
+            }
+            case CalcOp::Tee:
+                temps[in.slot] = run.tee(stack[sp-1], in.slot);
+                break;
+            case CalcOp::Load:
+                stack[sp++] = temps[in.slot];
+                break;
+            case CalcOp::Neg:
+            case CalcOp::Call:
+                run.unary(in, stack[sp-1], sp-1);
+                break;
+            default:
+                --sp;
+                run.binary(in, stack[sp-1], stack[sp], sp-1);
+                break;
+            }
+        }
+        const Slot& r = stack[0];
+        if (r.isConst) std::fill(out + row0, out + row0 + run.m, r.k);
+        else std::copy(r.p, r.p + run.m, out + row0);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "CalcProgram.h"
+#include <cstddef>
+
+/*
+ CalcBatch - 按列（structure-of-arrays）批量计算同一个表达式
+ - 每个变量槽位对应一列；列为空指针时把 scalar 广播到所有行
+ - 按块逐条执行字节码，每条指令用向量内核处理整块数据（见 CalcSimd.h）
+ - 出错时抛出与 CalcProgram::eval 相同的异常
+*/
+struct CalcColumn {
+    const double* data = nullptr; // `rows` values, or nullptr to broadcast `scalar`
+    double scalar = 0.0;
+};
+
+// columns[i] supplies prog.vars[i]; out receives `rows` results
+void evalCalcBatch(const CalcProgram& prog, const CalcColumn* columns, std::size_t rows, double* out);
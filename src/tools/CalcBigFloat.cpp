@@ -0,0 +1,415 @@
+#include "CalcBigFloat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - Series run on fixed-point CalcBigInt values scaled by 2^w, where w is the target
+   precision plus guard bits; the result is rounded once when it becomes a CalcBigFloat.
+ - exp: x = k*ln2 + r, r halved s times, Taylor series, then squared s times.
+ - ln: x = y * 2^k with y in [sqrt(1/2), sqrt(2)), ln y = 2 atanh((y-1)/(y+1)).
+ - sin/cos: reduced modulo pi/2 (pi computed with extra bits for large arguments),
+   Taylor series on |r| <= pi/4, quadrant selects the result.
+ - pi (Machin) and ln2 (2 atanh(1/3)) are cached per thread at the largest precision seen.
+*/
+
+namespace {
+
+constexpr std::size_t GUARD_BITS = 32;
+constexpr long long MAX_TRIG_EXPONENT = 1024; // |x| < 2^1024 covers every double
+
+CalcBigInt pow10(unsigned long long k) {
+    return CalcBigInt::pow(CalcBigInt(10), k);
+}
+
+// x * 2^w truncated toward zero
+CalcBigInt to_fixed(const CalcBigFloat& x, std::size_t w) {
+    long long s = x.exponent() + (long long)w;
+    return s >= 0 ? x.mantissa() << (std::size_t)s : x.mantissa() >> (std::size_t)-s;
+}
+
+// atan(1/n) * 2^w, or atanh(1/n) * 2^w when hyperbolic
+CalcBigInt arctan_inv(long long n, std::size_t w, bool hyperbolic) {
+    CalcBigInt n2(n * n);
+    CalcBigInt x = (CalcBigInt(1) << w) / CalcBigInt(n), sum = x;
+    for (long long k = 1;; ++k) {
+        x = x / n2;
+        if (x.isZero()) break;
+        CalcBigInt t = x / CalcBigInt(2 * k + 1);
+        sum = (!hyperbolic && (k & 1)) ? sum - t : sum + t;
+    }
+    return sum;
+}
+
+struct ConstantCache {
+    CalcBigInt value;
+    std::size_t bits = 0;
+};
+
+CalcBigInt pi_fixed(std::size_t w) {
+    thread_local ConstantCache cache;
+    if (w > cache.bits) {
+        std::size_t g = w + GUARD_BITS;
+        cache.value = (CalcBigInt(16) * arctan_inv(5, g, false) - CalcBigInt(4) * arctan_inv(239, g, false)) >> GUARD_BITS;
+        cache.bits = w;
+    }
+    return cache.value >> (cache.bits - w);
+}
+
+CalcBigInt ln2_fixed(std::size_t w) {
+    thread_local ConstantCache cache;
+    if (w > cache.bits) {
+        std::size_t g = w + GUARD_BITS;
+        cache.value = (arctan_inv(3, g, true) << 1) >> GUARD_BITS;
+        cache.bits = w;
+    }
+    return cache.value >> (cache.bits - w);
+}
+
+// position of the leading bit: |x| is in [2^(top-1), 2^top)
+long long top_bit(const CalcBigFloat& x) {
+    return x.exponent() + (long long)x.mantissa().bitLength();
+}
+
+CalcBigFloat with_precision(const CalcBigFloat& x, std::size_t bits) {
+    return CalcBigFloat(x.mantissa(), x.exponent(), bits);
+}
+
+// sin and cos of x as fixed-point values scaled by 2^w
+void sin_cos_fixed(const CalcBigFloat& x, std::size_t w, CalcBigInt* s, CalcBigInt* c) {
+    long long top = top_bit(x);
+    if (top > MAX_TRIG_EXPONENT) throw std::runtime_error("Argument out of range");
+    std::size_t wr = w + (std::size_t)std::max(0LL, top) + 8;
+    CalcBigInt X = to_fixed(x, wr);
+    CalcBigInt half_pi = pi_fixed(wr) >> 1;
+
+    // q = round(x / (pi/2)), r = x - q*pi/2
+    CalcBigInt q = (X.abs() * CalcBigInt(2) + half_pi) / (half_pi * CalcBigInt(2));
+    if (X.isNegative()) q = -q;
+    CalcBigInt r = (X - q * half_pi) >> (wr - w);
+
+    CalcBigInt one = CalcBigInt(1) << w;
+    CalcBigInt r2 = r * r >> w;
+    CalcBigInt sn = r, cs = one, term = r;
+    for (long long n = 1;; ++n) {
+        term = -(term * r2 >> w) / CalcBigInt((2 * n) * (2 * n + 1));
+        if (term.isZero()) break;
+        sn = sn + term;
+    }
+    term = one;
+    for (long long n = 1;; ++n) {
+        term = -(term * r2 >> w) / CalcBigInt((2 * n - 1) * (2 * n));
+        if (term.isZero()) break;
+        cs = cs + term;
+    }
+
+    long long quadrant = 0;
+    (q % CalcBigInt(4)).toInt64(&quadrant);
+    switch ((quadrant + 4) % 4) {
+    case 0: *s = sn; *c = cs; break;
+    case 1: *s = cs; *c = -sn; break;
+    case 2: *s = -sn; *c = -cs; break;
+    default: *s = -cs; *c = sn; break;
+    }
+}
+
+} // namespace
+
+CalcBigFloat::CalcBigFloat(CalcBigInt m, long long exp2, std::size_t bits)
+    : mant(std::move(m)), expo(exp2), prec(bits) {
+    round();
+}
+
+void CalcBigFloat::round() {
+    if (mant.isZero()) {
+        expo = 0;
+        return;
+    }
+    std::size_t len = mant.bitLength();
+    if (len > prec) {
+        // round half away from zero
+        std::size_t shift = len - prec;
+        bool up = mant.testBit(shift - 1);
+        mant = mant >> shift;
+        if (up) mant = mant.isNegative() ? mant - CalcBigInt(1) : mant + CalcBigInt(1);
+        expo += (long long)shift;
+        if (mant.bitLength() > prec) { // carried into a new bit: the dropped bit is zero
+            mant = mant >> 1;
+            expo += 1;
+        }
+    }
+    long long top = expo + (long long)mant.bitLength();
+    if (top > MAX_EXPONENT || top < -MAX_EXPONENT) throw std::runtime_error("Result out of range");
+}
+
+std::size_t CalcBigFloat::bitsForDigits(std::size_t digits) {
+    return (std::size_t)std::ceil((double)digits * 3.3219280948873623) + 8;
+}
+
+CalcBigFloat CalcBigFloat::fromRational(const CalcRational& r, std::size_t bits) {
+    if (r.isZero()) return CalcBigFloat(CalcBigInt(), 0, bits);
+    long long shift = (long long)bits + 2 + (long long)r.den().bitLength() - (long long)r.num().bitLength();
+    shift = std::max(0LL, shift);
+    return CalcBigFloat((r.num() << (std::size_t)shift) / r.den(), -shift, bits);
+}
+
+bool CalcBigFloat::isInteger() const {
+    if (mant.isZero() || expo >= 0) return true;
+    if ((std::size_t)-expo >= mant.bitLength()) return false;
+    std::size_t k = (std::size_t)-expo;
+    return (mant >> k) << k == mant;
+}
+
+CalcBigInt CalcBigFloat::toInteger() const {
+    return expo >= 0 ? mant << (std::size_t)expo : mant >> (std::size_t)-expo;
+}
+
+CalcBigFloat CalcBigFloat::operator-() const {
+    CalcBigFloat r = *this;
+    r.mant = -r.mant;
+    return r;
+}
+
+CalcBigFloat CalcBigFloat::abs() const {
+    CalcBigFloat r = *this;
+    r.mant = r.mant.abs();
+    return r;
+}
+
+CalcBigFloat operator+(const CalcBigFloat& a, const CalcBigFloat& b) {
+    std::size_t p = std::max(a.prec, b.prec);
+    if (a.isZero()) return with_precision(b, p);
+    if (b.isZero()) return with_precision(a, p);
+    // an operand entirely below the other's last bit cannot change the rounded sum
+    long long ta = top_bit(a), tb = top_bit(b);
+    if (ta - tb > (long long)p + 2) return with_precision(a, p);
+    if (tb - ta > (long long)p + 2) return with_precision(b, p);
+    if (a.expo >= b.expo) return CalcBigFloat((a.mant << (std::size_t)(a.expo - b.expo)) + b.mant, b.expo, p);
+    return CalcBigFloat(a.mant + (b.mant << (std::size_t)(b.expo - a.expo)), a.expo, p);
+}
+
+CalcBigFloat operator-(const CalcBigFloat& a, const CalcBigFloat& b) {
+    return a + (-b);
+}
+
+CalcBigFloat operator*(const CalcBigFloat& a, const CalcBigFloat& b) {
+    return CalcBigFloat(a.mant * b.mant, a.expo + b.expo, std::max(a.prec, b.prec));
+}
+
+CalcBigFloat operator/(const CalcBigFloat& a, const CalcBigFloat& b) {
+    if (b.isZero()) throw std::runtime_error("Division by zero");
+    std::size_t p = std::max(a.prec, b.prec);
+    if (a.isZero()) return CalcBigFloat(CalcBigInt(), 0, p);
+    long long shift = (long long)p + 2 + (long long)b.mant.bitLength() - (long long)a.mant.bitLength();
+    shift = std::max(0LL, shift);
+    return CalcBigFloat((a.mant << (std::size_t)shift) / b.mant, a.expo - shift - b.expo, p);
+}
+
+int CalcBigFloat::compare(const CalcBigFloat& a, const CalcBigFloat& b) {
+    return (a - b).sign();
+}
+
+CalcBigFloat CalcBigFloat::sqrt() const {
+    if (mant.isZero()) return *this;
+    // scale the mantissa to at least 2*prec bits with an even exponent, then take the integer root
+    std::size_t want = 2 * prec + 4, len = mant.bitLength();
+    long long t = len < want ? (long long)(want - len) : 0;
+    if ((expo - t) % 2 != 0) ++t;
+    return CalcBigFloat((mant << (std::size_t)t).isqrt(), (expo - t) / 2, prec);
+}
+
+CalcBigFloat CalcBigFloat::exp() const {
+    if (mant.isZero()) return CalcBigFloat(CalcBigInt(1), 0, prec);
+    long long top = top_bit(*this);
+    if (top > 24) throw std::runtime_error("Result out of range");
+
+    std::size_t s = (std::size_t)std::sqrt((double)prec) / 2 + 1;
+    std::size_t w = prec + GUARD_BITS + s;
+    std::size_t wr = w + (std::size_t)std::max(0LL, top) + 8;
+    CalcBigInt X = to_fixed(*this, wr), L = ln2_fixed(wr);
+    CalcBigInt k = X / L;
+    CalcBigInt r = (X - k * L) >> (wr - w + s);
+
+    CalcBigInt sum = CalcBigInt(1) << w, term = sum;
+    for (long long n = 1;; ++n) {
+        term = (term * r >> w) / CalcBigInt(n);
+        if (term.isZero()) break;
+        sum = sum + term;
+    }
+    for (std::size_t i = 0; i < s; ++i) sum = sum * sum >> w;
+
+    long long kk = 0;
+    k.toInt64(&kk);
+    return CalcBigFloat(sum, kk - (long long)w, prec);
+}
+
+CalcBigFloat CalcBigFloat::ln() const {
+    // x = y * 2^k with y = mant / 2^len in [1/2, 1)
+    std::size_t len = mant.bitLength();
+    long long k = expo + (long long)len;
+    std::size_t w = prec + GUARD_BITS + 64;
+    CalcBigInt one = CalcBigInt(1) << w;
+    CalcBigInt Y = w >= len ? mant << (w - len) : mant >> (len - w);
+    if (CalcBigInt::compare(Y * Y * CalcBigInt(2), one * one) < 0) {
+        Y = Y << 1;
+        --k;
+    }
+
+    CalcBigInt z = ((Y - one) << w) / (Y + one);
+    CalcBigInt z2 = z * z >> w, power = z, sum = z;
+    for (long long n = 3;; n += 2) {
+        power = power * z2 >> w;
+        if (power.isZero()) break;
+        sum = sum + power / CalcBigInt(n);
+    }
+    return CalcBigFloat((sum << 1) + CalcBigInt(k) * ln2_fixed(w), -(long long)w, prec);
+}
+
+CalcBigFloat CalcBigFloat::log10() const {
+    std::size_t w = prec + 16;
+    CalcBigFloat r = with_precision(*this, w).ln() / CalcBigFloat(CalcBigInt(10), 0, w).ln();
+    return with_precision(r, prec);
+}
+
+CalcBigFloat CalcBigFloat::sin() const {
+    std::size_t w = prec + GUARD_BITS;
+    CalcBigInt s, c;
+    sin_cos_fixed(*this, w, &s, &c);
+    return CalcBigFloat(s, -(long long)w, prec);
+}
+
+CalcBigFloat CalcBigFloat::cos() const {
+    std::size_t w = prec + GUARD_BITS;
+    CalcBigInt s, c;
+    sin_cos_fixed(*this, w, &s, &c);
+    return CalcBigFloat(c, -(long long)w, prec);
+}
+
+CalcBigFloat CalcBigFloat::tan() const {
+    std::size_t w = prec + GUARD_BITS;
+    CalcBigInt s, c;
+    sin_cos_fixed(*this, w, &s, &c);
+    CalcBigFloat r = CalcBigFloat(s, -(long long)w, w) / CalcBigFloat(c, -(long long)w, w);
+    return with_precision(r, prec);
+}
+
+CalcBigFloat CalcBigFloat::pi(std::size_t bits) {
+    return CalcBigFloat(pi_fixed(bits + GUARD_BITS), -(long long)(bits + GUARD_BITS), bits);
+}
+
+CalcBigFloat CalcBigFloat::pow(const CalcBigFloat& base, const CalcBigFloat& e) {
+    std::size_t p = std::max(base.prec, e.prec);
+    if (e.isZero()) return CalcBigFloat(CalcBigInt(1), 0, p);
+
+    bool integer = e.isInteger();
+    if (integer) {
+        long long n = 0;
+        if (e.toInteger().toInt64(&n) && n > -(1LL << 40) && n < (1LL << 40)) {
+            if (base.isZero()) {
+                if (n < 0) throw std::runtime_error("Division by zero");
+                return CalcBigFloat(CalcBigInt(), 0, p);
+            }
+            // square-and-multiply loses at most one bit per step
+            std::size_t w = p + 16 + 64;
+            unsigned long long k = (unsigned long long)(n < 0 ? -n : n);
+            CalcBigFloat r(CalcBigInt(1), 0, w), b = with_precision(base, w);
+            while (k) {
+                if (k & 1) r = r * b;
+                k >>= 1;
+                if (k) b = b * b;
+            }
+            if (n < 0) r = CalcBigFloat(CalcBigInt(1), 0, w) / r;
+            return with_precision(r, p);
+        }
+    }
+
+    if (base.isZero()) {
+        if (e.sign() < 0) throw std::runtime_error("Division by zero");
+        return CalcBigFloat(CalcBigInt(), 0, p);
+    }
+    bool negate = false;
+    if (base.sign() < 0) {
+        if (!integer) throw std::runtime_error("Negative base with non-integer exponent");
+        negate = e.toInteger().isOdd();
+    }
+    // a^b = exp(b ln|a|); |b ln a| < 2^24 so 24 extra bits absorb the error amplification of exp
+    std::size_t w = p + GUARD_BITS + 24;
+    CalcBigFloat y = with_precision(e, w) * with_precision(base.abs(), w).ln();
+    CalcBigFloat r = with_precision(y.exp(), p);
+    return negate ? -r : r;
+}
+
+std::string CalcBigFloat::toString(std::size_t digits) const {
+    if (mant.isZero()) return "0";
+    if (digits == 0) digits = 1;
+
+    // decimal exponent of the leading digit; the estimate may be off by one
+    long long k = (long long)std::floor((double)(top_bit(*this) - 1) * 0.30102999566398120);
+    CalcBigInt m = mant.abs();
+    std::string s;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        // s = round(|x| * 10^(digits-1-k)) must have exactly `digits` digits
+        long long p = (long long)digits - 1 - k;
+        CalcBigInt num = m, den(1);
+        if (p >= 0) num = num * pow10((unsigned long long)p);
+        else den = pow10((unsigned long long)-p);
+        if (expo >= 0) num = num << (std::size_t)expo;
+        else den = den << (std::size_t)-expo;
+        s = ((num * CalcBigInt(2) + den) / (den * CalcBigInt(2))).toString();
+        if (s.size() > digits) ++k;
+        else if (s.size() < digits) --k;
+        else break;
+    }
+    while (s.size() > 1 && s.back() == '0') s.pop_back();
+
+    std::string out = mant.isNegative() ? "-" : "";
+    if (k >= -7 && k < (long long)digits) {
+        if (k < 0) {
+            out += "0.";
+            out.append((std::size_t)(-k - 1), '0');
+            out += s;
+        } else if (s.size() <= (std::size_t)k + 1) {
+            out += s;
+            out.append((std::size_t)k + 1 - s.size(), '0');
+        } else {
+            out += s.substr(0, (std::size_t)k + 1);
+            out += '.';
+            out += s.substr((std::size_t)k + 1);
+        }
+        return out;
+    }
+    out += s[0];
+    if (s.size() > 1) {
+        out += '.';
+        out += s.substr(1);
+    }
+    char e[32];
+    std::snprintf(e, sizeof e, "e%c%02lld", k < 0 ? '-' : '+', k < 0 ? -k : k);
+    return out + e;
+}
+
+CalcBigFloat CalcBigFloatOps::constant(const CalcInstr& in) const {
+    return CalcBigFloat::fromDecimal(calcLiteralAt(source.substr(in.slot)), bits);
+}
+
+CalcBigFloat CalcBigFloatOps::call(const CalcInstr& in, const CalcBigFloat& a) const {
+    // same domain errors as the double builtins
+    switch ((CalcFunc)in.slot) {
+    case CalcFunc::Sin: return a.sin();
+    case CalcFunc::Cos: return a.cos();
+    case CalcFunc::Tan: return a.tan();
+    case CalcFunc::Sqrt:
+        if (a.sign() < 0) throw std::runtime_error("sqrt of negative");
+        return a.sqrt();
+    case CalcFunc::Abs: return a.abs();
+    case CalcFunc::Log:
+        if (a.sign() <= 0) throw std::runtime_error("log of non-positive");
+        return a.log10();
+    case CalcFunc::Ln:
+        if (a.sign() <= 0) throw std::runtime_error("ln of non-positive");
+        return a.ln();
+    }
+    throw std::runtime_error("Unexpected instruction");
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "CalcBigInt.h"
+#include "CalcProgram.h"
+#include "CalcRational.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ CalcBigFloat - 任意精度二进制浮点数 mant * 2^exp（计算器的高精度模式）
+ - 尾数是 CalcBigInt，每次运算后舍入到 prec 位（就近舍入）；乘法在大精度下走 Karatsuba
+ - 超越函数（exp ln sin cos tan sqrt log 和非整数次幂）在定点整数上用级数计算，
+   内部多留保护位，π 和 ln2 按线程缓存
+ - 指数超出 ±MAX_EXPONENT 位时报 "Result out of range"，而不是得到 inf/0
+*/
+class CalcBigFloat {
+public:
+    static constexpr long long MAX_EXPONENT = 1LL << 20;
+
+    CalcBigFloat() = default;
+    // mant * 2^exp2 rounded to `bits` bits
+    CalcBigFloat(CalcBigInt mant, long long exp2, std::size_t bits);
+
+    // bits of mantissa needed for `digits` significant decimal digits (plus guard bits)
+    static std::size_t bitsForDigits(std::size_t digits);
+    static CalcBigFloat fromRational(const CalcRational& r, std::size_t bits);
+    static CalcBigFloat fromDecimal(std::string_view text, std::size_t bits) {
+        return fromRational(CalcRational::fromDecimal(text), bits);
+    }
+
+    const CalcBigInt& mantissa() const { return mant; }
+    long long exponent() const { return expo; }
+    std::size_t precision() const { return prec; }
+    bool isZero() const { return mant.isZero(); }
+    int sign() const { return mant.sign(); }
+    bool isInteger() const;
+    // truncated toward zero
+    CalcBigInt toInteger() const;
+
+    CalcBigFloat operator-() const;
+    CalcBigFloat abs() const;
+    friend CalcBigFloat operator+(const CalcBigFloat& a, const CalcBigFloat& b);
+    friend CalcBigFloat operator-(const CalcBigFloat& a, const CalcBigFloat& b);
+    friend CalcBigFloat operator*(const CalcBigFloat& a, const CalcBigFloat& b);
+    // throws "Division by zero"
+    friend CalcBigFloat operator/(const CalcBigFloat& a, const CalcBigFloat& b);
+    static int compare(const CalcBigFloat& a, const CalcBigFloat& b);
+
+    // callers check the domain (x >= 0 for sqrt, x > 0 for ln/log10)
+    CalcBigFloat sqrt() const;
+    CalcBigFloat exp() const;
+    CalcBigFloat ln() const;
+    CalcBigFloat log10() const;
+    CalcBigFloat sin() const;
+    CalcBigFloat cos() const;
+    CalcBigFloat tan() const;
+    static CalcBigFloat pow(const CalcBigFloat& base, const CalcBigFloat& exp);
+    static CalcBigFloat pi(std::size_t bits);
+
+    // `digits` significant digits, trailing zeros removed; scientific notation for large/small values
+    std::string toString(std::size_t digits) const;
+
+private:
+    CalcBigInt mant;
+    long long expo = 0;
+    std::size_t prec = 64;
+
+    void round();
+};
+
+// CalcEval backend for the high-precision mode; literals are re-read from source at `bits` precision
+struct CalcBigFloatOps {
+    using Number = CalcBigFloat;
+    std::string_view source;
+    std::size_t bits = 64;
+
+    CalcBigFloat constant(const CalcInstr& in) const;
+    CalcBigFloat add(const CalcBigFloat& a, const CalcBigFloat& b) const { return a + b; }
+    CalcBigFloat sub(const CalcBigFloat& a, const CalcBigFloat& b) const { return a - b; }
+    CalcBigFloat mul(const CalcBigFloat& a, const CalcBigFloat& b) const { return a * b; }
+    CalcBigFloat div(const CalcBigFloat& a, const CalcBigFloat& b) const { return a / b; }
+    CalcBigFloat pow(const CalcBigFloat& a, const CalcBigFloat& b) const { return CalcBigFloat::pow(a, b); }
+    CalcBigFloat neg(const CalcBigFloat& a) const { return -a; }
+    CalcBigFloat call(const CalcInstr& in, const CalcBigFloat& a) const;
+};
@@ -0,0 +1,456 @@
+#include "CalcBigInt.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - Magnitude helpers work on raw limb ranges so Karatsuba can recurse without
+   copying its halves; only the (a0+a1)(b0+b1) middle product needs scratch space.
+ - Unbalanced products (one side at least twice as long) are cut into pieces of
+   the shorter length, so Karatsuba always sees operands of similar size.
+ - Decimal conversion goes through base 10^9 chunks.
+*/
+
+namespace {
+
+using Limb = std::uint32_t;
+using Mag = std::vector<Limb>;
+
+constexpr Limb DEC_BASE = 1000000000; // 10^9
+constexpr int DEC_DIGITS = 9;
+
+void trim_mag(Mag& m) {
+    while (!m.empty() && m.back() == 0) m.pop_back();
+}
+
+int cmp_mag(const Mag& a, const Mag& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;)
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    return 0;
+}
+
+// acc[0..nacc) += x[0..nx); the sum must fit in nacc limbs
+void add_into(Limb* acc, size_t nacc, const Limb* x, size_t nx) {
+    std::uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < nx; ++i) {
+        std::uint64_t t = (std::uint64_t)acc[i] + x[i] + carry;
+        acc[i] = (Limb)t;
+        carry = t >> 32;
+    }
+    for (; carry && i < nacc; ++i) {
+        std::uint64_t t = (std::uint64_t)acc[i] + carry;
+        acc[i] = (Limb)t;
+        carry = t >> 32;
+    }
+}
+
+// acc[0..nacc) -= x[0..nx); requires acc >= x
+void sub_into(Limb* acc, size_t nacc, const Limb* x, size_t nx) {
+    std::int64_t borrow = 0;
+    size_t i = 0;
+    for (; i < nx; ++i) {
+        std::int64_t t = (std::int64_t)acc[i] - x[i] - borrow;
+        acc[i] = (Limb)t;
+        borrow = t < 0;
+    }
+    for (; borrow && i < nacc; ++i) {
+        std::int64_t t = (std::int64_t)acc[i] - borrow;
+        acc[i] = (Limb)t;
+        borrow = t < 0;
+    }
+}
+
+Mag add_mag(const Mag& a, const Mag& b) {
+    const Mag& big = a.size() >= b.size() ? a : b;
+    const Mag& small = a.size() >= b.size() ? b : a;
+    Mag out(big.size() + 1, 0);
+    std::copy(big.begin(), big.end(), out.begin());
+    add_into(out.data(), out.size(), small.data(), small.size());
+    trim_mag(out);
+    return out;
+}
+
+// |a| >= |b|
+Mag sub_mag(const Mag& a, const Mag& b) {
+    Mag out = a;
+    sub_into(out.data(), out.size(), b.data(), b.size());
+    trim_mag(out);
+    return out;
+}
+
+// out[0..na+nb) = a * b; out must be zeroed
+void mul_school(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* out) {
+    for (size_t i = 0; i < na; ++i) {
+        std::uint64_t ai = a[i], carry = 0;
+        if (ai == 0) continue;
+        for (size_t j = 0; j < nb; ++j) {
+            std::uint64_t t = ai * b[j] + out[i + j] + carry;
+            out[i + j] = (Limb)t;
+            carry = t >> 32;
+        }
+        out[i + nb] = (Limb)carry;
+    }
+}
+
+// out[0..na+nb) = a * b, overwriting out
+void mul_into(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* out) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    std::fill(out, out + na + nb, 0);
+    if (nb == 0) return;
+    if (nb < CalcBigInt::KARATSUBA_THRESHOLD) {
+        mul_school(a, na, b, nb, out);
+        return;
+    }
+    if (na >= 2 * nb) {
+        Mag piece(2 * nb);
+        for (size_t off = 0; off < na; off += nb) {
+            size_t len = std::min(nb, na - off);
+            mul_into(a + off, len, b, nb, piece.data());
+            add_into(out + off, na + nb - off, piece.data(), len + nb);
+        }
+        return;
+    }
+
+    // a = a1*B^m + a0, b = b1*B^m + b0 with nb > m
+    size_t m = na / 2;
+    size_t na1 = na - m, nb1 = nb - m;
+    mul_into(a, m, b, m, out);                   // z0
+    mul_into(a + m, na1, b + m, nb1, out + 2 * m); // z2
+
+    Mag sa(na1 + 1, 0), sb(std::max(m, nb1) + 1, 0);
+    std::copy(a + m, a + na, sa.begin());
+    add_into(sa.data(), sa.size(), a, m);
+    std::copy(b, b + m, sb.begin());
+    add_into(sb.data(), sb.size(), b + m, nb1);
+
+    // z1 = (a0+a1)(b0+b1) - z0 - z2
+    Mag z1(sa.size() + sb.size());
+    mul_into(sa.data(), sa.size(), sb.data(), sb.size(), z1.data());
+    sub_into(z1.data(), z1.size(), out, 2 * m);
+    sub_into(z1.data(), z1.size(), out + 2 * m, na + nb - 2 * m);
+    trim_mag(z1);
+    add_into(out + m, na + nb - m, z1.data(), z1.size());
+}
+
+// q = u / v, r = u % v (Knuth, TAOCP vol. 2, 4.3.1, algorithm D)
+void divmod_mag(const Mag& u, const Mag& v, Mag& q, Mag& r) {
+    if (cmp_mag(u, v) < 0) {
+        q.clear();
+        r = u;
+        return;
+    }
+    size_t n = v.size(), m = u.size();
+    if (n == 1) {
+        std::uint64_t d = v[0], rem = 0;
+        q.assign(m, 0);
+        for (size_t i = m; i-- > 0;) {
+            std::uint64_t cur = (rem << 32) | u[i];
+            q[i] = (Limb)(cur / d);
+            rem = cur % d;
+        }
+        trim_mag(q);
+        r.clear();
+        if (rem) r.push_back((Limb)rem);
+        return;
+    }
+
+    // normalize so the divisor's top limb has its high bit set
+    int s = __builtin_clz(v[n - 1]);
+    Mag vn(n), un(m + 1);
+    for (size_t i = n - 1; i > 0; --i)
+        vn[i] = (v[i] << s) | (s ? (Limb)((std::uint64_t)v[i - 1] >> (32 - s)) : 0);
+    vn[0] = v[0] << s;
+    un[m] = s ? (Limb)((std::uint64_t)u[m - 1] >> (32 - s)) : 0;
+    for (size_t i = m - 1; i > 0; --i)
+        un[i] = (u[i] << s) | (s ? (Limb)((std::uint64_t)u[i - 1] >> (32 - s)) : 0);
+    un[0] = u[0] << s;
+
+    const std::uint64_t B = 1ull << 32;
+    q.assign(m - n + 1, 0);
+    for (size_t j = m - n + 1; j-- > 0;) {
+        std::uint64_t num = ((std::uint64_t)un[j + n] << 32) | un[j + n - 1];
+        std::uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+        while (qhat >= B || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >= B) break;
+        }
+
+        // un[j..j+n] -= qhat * vn
+        std::int64_t k = 0, t;
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t p = qhat * vn[i];
+            t = (std::int64_t)un[i + j] - k - (std::int64_t)(p & 0xFFFFFFFFull);
+            un[i + j] = (Limb)t;
+            k = (std::int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (std::int64_t)un[j + n] - k;
+        un[j + n] = (Limb)t;
+
+        q[j] = (Limb)qhat;
+        if (t < 0) {
+            // qhat was one too large: add the divisor back
+            --q[j];
+            std::uint64_t c = 0;
+            for (size_t i = 0; i < n; ++i) {
+                std::uint64_t sum = (std::uint64_t)un[i + j] + vn[i] + c;
+                un[i + j] = (Limb)sum;
+                c = sum >> 32;
+            }
+            un[j + n] += (Limb)c;
+        }
+    }
+
+    r.assign(n, 0);
+    for (size_t i = 0; i + 1 < n; ++i)
+        r[i] = (un[i] >> s) | (s ? (Limb)((std::uint64_t)un[i + 1] << (32 - s)) : 0);
+    r[n - 1] = un[n - 1] >> s;
+    trim_mag(q);
+    trim_mag(r);
+}
+
+// m = m * mul + add
+void mul_add_small(Mag& m, Limb mul, Limb add) {
+    std::uint64_t carry = add;
+    for (Limb& l : m) {
+        std::uint64_t t = (std::uint64_t)l * mul + carry;
+        l = (Limb)t;
+        carry = t >> 32;
+    }
+    if (carry) m.push_back((Limb)carry);
+}
+
+} // namespace
+
+CalcBigInt::CalcBigInt(long long v) {
+    neg = v < 0;
+    std::uint64_t u = neg ? 0 - (std::uint64_t)v : (std::uint64_t)v;
+    while (u) {
+        mag.push_back((Limb)u);
+        u >>= 32;
+    }
+}
+
+void CalcBigInt::trim() {
+    trim_mag(mag);
+    if (mag.empty()) neg = false;
+}
+
+CalcBigInt CalcBigInt::fromDecimal(std::string_view digits) {
+    if (digits.empty()) throw std::runtime_error("Invalid number: empty");
+    CalcBigInt r;
+    size_t i = 0;
+    size_t first = digits.size() % DEC_DIGITS;
+    if (first == 0) first = DEC_DIGITS;
+    while (i < digits.size()) {
+        size_t len = i == 0 ? first : DEC_DIGITS;
+        Limb chunk = 0, scale = 1;
+        for (size_t k = i; k < i + len; ++k) {
+            char c = digits[k];
+            if (c < '0' || c > '9') throw std::runtime_error("Invalid number: " + std::string(digits));
+            chunk = chunk * 10 + (Limb)(c - '0');
+            scale *= 10;
+        }
+        mul_add_small(r.mag, scale, chunk);
+        i += len;
+    }
+    r.trim();
+    return r;
+}
+
+std::string CalcBigInt::toString() const {
+    if (mag.empty()) return "0";
+    Mag cur = mag;
+    std::vector<Limb> chunks; // base 10^9, least significant first
+    while (!cur.empty()) {
+        std::uint64_t rem = 0;
+        for (size_t i = cur.size(); i-- > 0;) {
+            std::uint64_t v = (rem << 32) | cur[i];
+            cur[i] = (Limb)(v / DEC_BASE);
+            rem = v % DEC_BASE;
+        }
+        trim_mag(cur);
+        chunks.push_back((Limb)rem);
+    }
+    std::string s = neg ? "-" : "";
+    s += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string part = std::to_string(chunks[i]);
+        s.append(DEC_DIGITS - part.size(), '0');
+        s += part;
+    }
+    return s;
+}
+
+std::size_t CalcBigInt::bitLength() const {
+    if (mag.empty()) return 0;
+    return (mag.size() - 1) * 32 + (32 - __builtin_clz(mag.back()));
+}
+
+bool CalcBigInt::testBit(std::size_t i) const {
+    size_t limb = i / 32;
+    return limb < mag.size() && ((mag[limb] >> (i % 32)) & 1);
+}
+
+bool CalcBigInt::toInt64(long long* out) const {
+    if (mag.size() > 2) return false;
+    std::uint64_t u = 0;
+    for (size_t i = mag.size(); i-- > 0;) u = (u << 32) | mag[i];
+    if (neg) {
+        if (u > (std::uint64_t)1 << 63) return false;
+        *out = (long long)(0 - u);
+    } else {
+        if (u > (std::uint64_t)INT64_MAX) return false;
+        *out = (long long)u;
+    }
+    return true;
+}
+
+double CalcBigInt::toDouble() const {
+    // the top three limbs carry more than the 53 significant bits of a double
+    double d = 0.0;
+    size_t top = mag.size() > 3 ? mag.size() - 3 : 0;
+    for (size_t i = mag.size(); i-- > top;) d = d * 4294967296.0 + mag[i];
+    d = std::ldexp(d, (int)std::min<size_t>(top * 32, 1 << 20));
+    return neg ? -d : d;
+}
+
+CalcBigInt CalcBigInt::operator-() const {
+    CalcBigInt r = *this;
+    if (!r.mag.empty()) r.neg = !r.neg;
+    return r;
+}
+
+CalcBigInt CalcBigInt::abs() const {
+    CalcBigInt r = *this;
+    r.neg = false;
+    return r;
+}
+
+CalcBigInt operator+(const CalcBigInt& a, const CalcBigInt& b) {
+    CalcBigInt r;
+    if (a.neg == b.neg) {
+        r.mag = add_mag(a.mag, b.mag);
+        r.neg = a.neg;
+    } else if (cmp_mag(a.mag, b.mag) >= 0) {
+        r.mag = sub_mag(a.mag, b.mag);
+        r.neg = a.neg;
+    } else {
+        r.mag = sub_mag(b.mag, a.mag);
+        r.neg = b.neg;
+    }
+    r.trim();
+    return r;
+}
+
+CalcBigInt operator-(const CalcBigInt& a, const CalcBigInt& b) {
+    return a + (-b);
+}
+
+CalcBigInt operator*(const CalcBigInt& a, const CalcBigInt& b) {
+    CalcBigInt r;
+    if (a.mag.empty() || b.mag.empty()) return r;
+    r.mag.resize(a.mag.size() + b.mag.size());
+    mul_into(a.mag.data(), a.mag.size(), b.mag.data(), b.mag.size(), r.mag.data());
+    r.neg = a.neg != b.neg;
+    r.trim();
+    return r;
+}
+
+void CalcBigInt::divMod(const CalcBigInt& a, const CalcBigInt& b, CalcBigInt& q, CalcBigInt& r) {
+    if (b.mag.empty()) throw std::runtime_error("Division by zero");
+    Mag qm, rm;
+    divmod_mag(a.mag, b.mag, qm, rm);
+    q.mag = std::move(qm);
+    q.neg = a.neg != b.neg;
+    q.trim();
+    r.mag = std::move(rm);
+    r.neg = a.neg;
+    r.trim();
+}
+
+CalcBigInt operator/(const CalcBigInt& a, const CalcBigInt& b) {
+    CalcBigInt q, r;
+    CalcBigInt::divMod(a, b, q, r);
+    return q;
+}
+
+CalcBigInt operator%(const CalcBigInt& a, const CalcBigInt& b) {
+    CalcBigInt q, r;
+    CalcBigInt::divMod(a, b, q, r);
+    return r;
+}
+
+CalcBigInt CalcBigInt::operator<<(std::size_t bits) const {
+    if (mag.empty() || bits == 0) return *this;
+    size_t limbs = bits / 32, s = bits % 32;
+    CalcBigInt r;
+    r.neg = neg;
+    r.mag.assign(mag.size() + limbs + 1, 0);
+    for (size_t i = 0; i < mag.size(); ++i) {
+        std::uint64_t v = (std::uint64_t)mag[i] << s;
+        r.mag[i + limbs] |= (Limb)v;
+        r.mag[i + limbs + 1] |= (Limb)(v >> 32);
+    }
+    r.trim();
+    return r;
+}
+
+CalcBigInt CalcBigInt::operator>>(std::size_t bits) const {
+    size_t limbs = bits / 32, s = bits % 32;
+    CalcBigInt r;
+    if (limbs >= mag.size()) return r;
+    r.neg = neg;
+    r.mag.assign(mag.size() - limbs, 0);
+    for (size_t i = limbs; i < mag.size(); ++i) {
+        std::uint64_t v = mag[i];
+        if (i + 1 < mag.size()) v |= (std::uint64_t)mag[i + 1] << 32;
+        r.mag[i - limbs] = (Limb)(v >> s);
+    }
+    r.trim();
+    return r;
+}
+
+CalcBigInt CalcBigInt::gcd(CalcBigInt a, CalcBigInt b) {
+    a.neg = b.neg = false;
+    while (!b.isZero()) {
+        CalcBigInt r = a % b;
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
+
+CalcBigInt CalcBigInt::pow(const CalcBigInt& base, unsigned long long exp) {
+    CalcBigInt result(1), b = base;
+    while (exp) {
+        if (exp & 1) result = result * b;
+        exp >>= 1;
+        if (exp) b = b * b;
+    }
+    return result;
+}
+
+CalcBigInt CalcBigInt::isqrt() const {
+    if (mag.empty()) return CalcBigInt();
+    CalcBigInt n = abs();
+    // Newton from above: x0 >= sqrt(n), the sequence decreases until it stops at floor(sqrt(n))
+    CalcBigInt x = CalcBigInt(1) << ((n.bitLength() + 1) / 2);
+    while (true) {
+        CalcBigInt y = (x + n / x) >> 1;
+        if (compare(y, x) >= 0) return x;
+        x = std::move(y);
+    }
+}
+
+int CalcBigInt::compare(const CalcBigInt& a, const CalcBigInt& b) {
+    if (a.neg != b.neg) return a.neg ? -1 : 1;
+    int c = cmp_mag(a.mag, b.mag);
+    return a.neg ? -c : c;
+}
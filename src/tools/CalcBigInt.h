@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ CalcBigInt - 任意精度有符号整数（精确模式和高精度模式的基础）
+ - 绝对值按 32 位 limb 小端存放，没有前导零；零的 limb 数组为空
+ - 乘法：小规模用竖式，两边都超过 KARATSUBA_THRESHOLD 个 limb 时用 Karatsuba
+ - 除法：Knuth 算法 D，商向零取整，余数与被除数同号
+ - 移位作用在绝对值上（负数右移向零取整）
+*/
+class CalcBigInt {
+public:
+    static constexpr std::size_t KARATSUBA_THRESHOLD = 32; // limbs
+
+    CalcBigInt() = default;
+    CalcBigInt(long long v);
+
+    // digits only, no sign; throws runtime_error on anything else
+    static CalcBigInt fromDecimal(std::string_view digits);
+    std::string toString() const;
+
+    bool isZero() const { return mag.empty(); }
+    bool isNegative() const { return neg; }
+    bool isOdd() const { return !mag.empty() && (mag[0] & 1); }
+    int sign() const { return mag.empty() ? 0 : (neg ? -1 : 1); }
+    std::size_t bitLength() const;
+    bool testBit(std::size_t i) const; // bit i of the magnitude
+
+    // true and *out set when the value fits in a long long
+    bool toInt64(long long* out) const;
+    double toDouble() const;
+
+    CalcBigInt operator-() const;
+    CalcBigInt abs() const;
+
+    friend CalcBigInt operator+(const CalcBigInt& a, const CalcBigInt& b);
+    friend CalcBigInt operator-(const CalcBigInt& a, const CalcBigInt& b);
+    friend CalcBigInt operator*(const CalcBigInt& a, const CalcBigInt& b);
+    friend CalcBigInt operator/(const CalcBigInt& a, const CalcBigInt& b);
+    friend CalcBigInt operator%(const CalcBigInt& a, const CalcBigInt& b);
+    CalcBigInt operator<<(std::size_t bits) const;
+    CalcBigInt operator>>(std::size_t bits) const;
+
+    // q = a / b, r = a % b; throws "Division by zero"
+    static void divMod(const CalcBigInt& a, const CalcBigInt& b, CalcBigInt& q, CalcBigInt& r);
+    static CalcBigInt gcd(CalcBigInt a, CalcBigInt b);
+    static CalcBigInt pow(const CalcBigInt& base, unsigned long long exp);
+    // floor(sqrt(|this|))
+    CalcBigInt isqrt() const;
+
+    // -1, 0, 1
+    static int compare(const CalcBigInt& a, const CalcBigInt& b);
+    friend bool operator==(const CalcBigInt& a, const CalcBigInt& b) { return a.neg == b.neg && a.mag == b.mag; }
+    friend bool operator!=(const CalcBigInt& a, const CalcBigInt& b) { return !(a == b); }
+    friend bool operator<(const CalcBigInt& a, const CalcBigInt& b) { return compare(a, b) < 0; }
+
+private:
+    std::vector<std::uint32_t> mag; // little-endian limbs
+    bool neg = false;
+
+    void trim();
+};
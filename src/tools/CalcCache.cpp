@@ -0,0 +1,41 @@
+#include "CalcCache.h"
+#include "CalcJit.h"
+
+CalcProgramCache::CalcProgramCache(std::size_t capacity, std::size_t jitThreshold)
+    : cap(capacity ? capacity : 1), jitThreshold(CalcJitCode::supported() ? jitThreshold : 0) {
+    index.reserve(cap);
+}
+
+const CalcProgram& CalcProgramCache::get(std::string_view expr) {
+    auto it = index.find(expr);
+    if (it != index.end()) {
+        ++hitCount;
+        if (it->second != lru.begin()) lru.splice(lru.begin(), lru, it->second);
+        Entry& e = *it->second;
+        if (++e.hits == jitThreshold && !e.prog.jit) {
+            e.prog.jit = CalcJitCode::compile(e.prog);
+            if (e.prog.jit) ++jitCount;
+        }
+        return e.prog;
+    }
+
+    ++missCount;
+    std::string key(expr);
+    CalcProgram prog = CalcProgram::compile(key);
+    lru.push_front(Entry{std::move(key), std::move(prog)});
+    index.emplace(std::string_view(lru.front().expr), lru.begin());
+
+    if (lru.size() > cap) {
+        index.erase(std::string_view(lru.back().expr));
+        lru.pop_back();
+    }
+    return lru.front().prog;
+}
+
+void CalcProgramCache::clear() {
+    index.clear();
+    lru.clear();
+    hitCount = 0;
+    missCount = 0;
+    jitCount = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "CalcProgram.h"
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ CalcProgramCache - 以表达式原文为键的有界 LRU 编译缓存
+ - 命中时不再解析，也不做内存分配
+ - 记录命中/未命中次数
+ - 同一条表达式命中次数达到 jitThreshold 后编译为本机代码（平台不支持时继续解释执行）
+ - get() 返回的引用在下一次 get()/clear() 之前有效
+*/
+class CalcProgramCache {
+public:
+    // jitThreshold == 0 disables the JIT tier
+    explicit CalcProgramCache(std::size_t capacity = 256, std::size_t jitThreshold = 64);
+
+    // compiles on miss; compile errors propagate and nothing is cached
+    const CalcProgram& get(std::string_view expr);
+
+    void clear();
+
+    std::size_t size() const { return lru.size(); }
+    std::size_t capacity() const { return cap; }
+    std::size_t hits() const { return hitCount; }
+    std::size_t misses() const { return missCount; }
+    std::size_t jitCompiled() const { return jitCount; }
+
+private:
+    struct Entry {
+        std::string expr;
+        CalcProgram prog;
+        std::size_t hits = 0;
+    };
+
+    std::size_t cap;
+    std::size_t jitThreshold;
+    std::size_t hitCount = 0;
+    std::size_t missCount = 0;
+    std::size_t jitCount = 0;
+    std::list<Entry> lru; // most recently used first
+    // keys view the strings owned by the list nodes
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "CalcProgram.h"
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/*
+ CalcEval - 与数值类型无关的字节码求值器
+ - calcEvaluate<Ops> 按 Ops::Number 执行同一份字节码，Ops 提供常量和各运算的实现：
+     Number constant(const CalcInstr&)       Const 指令
+     Number add/sub/mul/div/pow(a, b)        二元运算（div 负责除零检查）
+     Number neg(a), call(const CalcInstr&, a) 一元运算和内置函数
+ - CalcDoubleOps 是默认的 double 后端，CalcProgram::interpret 就是它的实例化，
+   所有调用都内联，生成的代码与手写的 double 解释器相同
+ - 精确模式（CalcRational）和高精度模式（CalcBigFloat）用同一个求值器
+*/
+
+struct CalcDoubleOps {
+    using Number = double;
+
+    double constant(const CalcInstr& in) const { return in.value; }
+    double add(double a, double b) const { return a + b; }
+    double sub(double a, double b) const { return a - b; }
+    double mul(double a, double b) const { return a * b; }
+    double div(double a, double b) const {
+        if (b == 0.0) throw std::runtime_error("Division by zero");
+        return a / b;
+    }
+    double pow(double a, double b) const { return std::pow(a, b); }
+    double neg(double a) const { return -a; }
+    double call(const CalcInstr& in, double a) const { return in.fn(a); }
+};
+
+namespace calc_detail {
+
+// st holds maxDepth stack slots followed by numTemps temporaries
+template <class Ops>
+typename Ops::Number run(const CalcProgram& prog, const typename Ops::Number* vars, const Ops& ops,
+                         typename Ops::Number* st) {
+    auto* temps = st + prog.maxDepth;
+    std::size_t sp = 0;
+    for (const CalcInstr& in : prog.code) {
+        switch (in.op) {
+        case CalcOp::Const: st[sp++] = ops.constant(in); break;
+        case CalcOp::Var: st[sp++] = vars[in.slot]; break;
+        case CalcOp::Add: --sp; st[sp-1] = ops.add(st[sp-1], st[sp]); break;
+        case CalcOp::Sub: --sp; st[sp-1] = ops.sub(st[sp-1], st[sp]); break;
+        case CalcOp::Mul: --sp; st[sp-1] = ops.mul(st[sp-1], st[sp]); break;
+        case CalcOp::Div: --sp; st[sp-1] = ops.div(st[sp-1], st[sp]); break;
+        case CalcOp::Pow: --sp; st[sp-1] = ops.pow(st[sp-1], st[sp]); break;
+        case CalcOp::Neg: st[sp-1] = ops.neg(st[sp-1]); break;
+        case CalcOp::Call: st[sp-1] = ops.call(in, st[sp-1]); break;
+        case CalcOp::Tee: temps[in.slot] = st[sp-1]; break;
+        case CalcOp::Load: st[sp++] = temps[in.slot]; break;
+        }
+    }
+    return st[0];
+}
+
+} // namespace calc_detail
+
+// vars[i] is the value of variable slot i; throws runtime_error on domain errors
+template <class Ops>
+typename Ops::Number calcEvaluate(const CalcProgram& prog, const typename Ops::Number* vars, const Ops& ops = Ops()) {
+    using Number = typename Ops::Number;
+    std::size_t need = prog.maxDepth + prog.numTemps;
+    if constexpr (std::is_trivial<Number>::value) {
+        // small expressions run entirely on the native stack
+        constexpr std::size_t INLINE_DEPTH = 64;
+        if (need <= INLINE_DEPTH) {
+            Number inline_stack[INLINE_DEPTH];
+            return calc_detail::run(prog, vars, ops, inline_stack);
+        }
+        thread_local std::vector<Number> big_stack;
+        if (big_stack.size() < need) big_stack.resize(need);
+        return calc_detail::run(prog, vars, ops, big_stack.data());
+    } else {
+        std::vector<Number> stack(need);
+        return calc_detail::run(prog, vars, ops, stack.data());
+    }
+}
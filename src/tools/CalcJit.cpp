@@ -0,0 +1,285 @@
+#include "CalcJit.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CALC_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/*
+ Generated code layout (System V ABI):
+   rdi = vars, rsi = frame, rdx = out
+   rbx = vars, r12 = frame, r13 = out (callee-saved, survive libm calls)
+   stack slot i at [r12 + 8*i], temp t at [r12 + 8*(maxDepth + t)]
+ Three pushes keep rsp 16-byte aligned for the calls into libm.
+*/
+
+namespace {
+
+enum JitError { JIT_OK = 0, JIT_DIV_ZERO, JIT_SQRT_NEG, JIT_LOG_NONPOS, JIT_LN_NONPOS };
+
+#ifdef CALC_JIT_X86_64
+
+class Assembler {
+public:
+    std::vector<std::uint8_t> buf;
+
+    void bytes(std::initializer_list<std::uint8_t> b) { buf.insert(buf.end(), b); }
+    void imm32(std::uint32_t v) { for (int i = 0; i < 4; ++i) buf.push_back((std::uint8_t)(v >> (8 * i))); }
+    void imm64(std::uint64_t v) { for (int i = 0; i < 8; ++i) buf.push_back((std::uint8_t)(v >> (8 * i))); }
+
+    // ModRM + SIB + disp32 for [r12 + disp]
+    void frame_operand(int reg, std::size_t slot) {
+        bytes({(std::uint8_t)(0x80 | (reg << 3) | 0x04), 0x24});
+        imm32((std::uint32_t)(slot * 8));
+    }
+
+    void mov_rax_frame(std::size_t slot) { bytes({0x49, 0x8B}); frame_operand(0, slot); }
+    void mov_frame_rax(std::size_t slot) { bytes({0x49, 0x89}); frame_operand(0, slot); }
+    void mov_rax_var(std::size_t slot) { bytes({0x48, 0x8B, 0x83}); imm32((std::uint32_t)(slot * 8)); }
+    void mov_rax_imm(std::uint64_t v) { bytes({0x48, 0xB8}); imm64(v); }
+    void movsd_xmm_frame(int x, std::size_t slot) { bytes({0xF2, 0x41, 0x0F, 0x10}); frame_operand(x, slot); }
+    void movsd_frame_xmm(std::size_t slot, int x) { bytes({0xF2, 0x41, 0x0F, 0x11}); frame_operand(x, slot); }
+    // addsd 0x58, mulsd 0x59, subsd 0x5C, divsd 0x5E: xmm0 op= [frame]
+    void sse_xmm0_frame(std::uint8_t opcode, std::size_t slot) { bytes({0xF2, 0x41, 0x0F, opcode}); frame_operand(0, slot); }
+    void xorpd_xmm2() { bytes({0x66, 0x0F, 0x57, 0xD2}); }
+    void ucomisd_xmm2(int x) { bytes({0x66, 0x0F, 0x2E, (std::uint8_t)(0xC0 | (x << 3) | 2)}); }
+    void call_rax() { bytes({0xFF, 0xD0}); }
+
+    // jcc rel32 to a label resolved later; returns the fixup position
+    std::size_t jcc(std::uint8_t cc) { bytes({0x0F, cc}); imm32(0); return buf.size() - 4; }
+    std::size_t jmp() { bytes({0xE9}); imm32(0); return buf.size() - 4; }
+    void patch(std::size_t at, std::size_t target) {
+        std::uint32_t rel = (std::uint32_t)(target - (at + 4));
+        std::memcpy(&buf[at], &rel, 4);
+    }
+};
+
+constexpr std::uint8_t CC_JB = 0x82, CC_JE = 0x84, CC_JBE = 0x86, CC_JP = 0x8A;
+
+template <class F>
+std::uint64_t fn_bits(F* f) {
+    std::uint64_t v;
+    static_assert(sizeof(f) == sizeof(v), "function pointer size");
+    std::memcpy(&v, &f, sizeof v);
+    return v;
+}
+
+double jit_pow(double a, double b) { return std::pow(a, b); }
+double jit_log10(double x) { return std::log10(x); }
+double jit_ln(double x) { return std::log(x); }
+
+class JitBuilder {
+public:
+    explicit JitBuilder(const CalcProgram& prog) : prog(prog) {}
+
+    std::vector<std::uint8_t> build() {
+        // prologue: push rbx; push r12; push r13; mov rbx,rdi; mov r12,rsi; mov r13,rdx
+        a.bytes({0x53, 0x41, 0x54, 0x41, 0x55});
+        a.bytes({0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x49, 0x89, 0xD5});
+
+        std::size_t sp = 0;
+        for (const CalcInstr& in : prog.code) emit(in, sp);
+
+        // *out = stack[0]; return 0
+        a.bytes({0xF2, 0x41, 0x0F, 0x10}); a.frame_operand(0, 0);
+        a.bytes({0xF2, 0x41, 0x0F, 0x11, 0x45, 0x00}); // movsd [r13], xmm0
+        a.bytes({0x31, 0xC0});                         // xor eax, eax
+        std::size_t exit = a.buf.size();
+        a.bytes({0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3}); // pop r13; pop r12; pop rbx; ret
+
+        // error exits: mov eax, code; jmp exit
+        for (auto& f : fixups) {
+            a.patch(f.first, a.buf.size());
+            a.bytes({0xB8});
+            a.imm32((std::uint32_t)f.second);
+            a.patch(a.jmp(), exit);
+        }
+        return a.buf;
+    }
+
+private:
+    const CalcProgram& prog;
+    Assembler a;
+    std::vector<std::pair<std::size_t, JitError>> fixups;
+
+    std::size_t temp_slot(std::uint32_t t) const { return prog.maxDepth + t; }
+
+    // jumps to the error exit when the condition holds for an ordered compare;
+    // NaN (parity set) falls through, matching the C++ comparisons in the interpreter
+    void error_if(std::uint8_t cc, JitError err) {
+        a.bytes({0x7A, 0x06}); // jp +6 (over the jcc rel32)
+        fixups.emplace_back(a.jcc(cc), err);
+    }
+
+    void call_unary(std::size_t slot, std::uint64_t fn) {
+        a.movsd_xmm_frame(0, slot);
+        a.mov_rax_imm(fn);
+        a.call_rax();
+        a.movsd_frame_xmm(slot, 0);
+    }
+
+    void emit(const CalcInstr& in, std::size_t& sp) {
+        switch (in.op) {
+        case CalcOp::Const: {
+            std::uint64_t bits;
+            std::memcpy(&bits, &in.value, sizeof bits);
+            a.mov_rax_imm(bits);
+            a.mov_frame_rax(sp++);
+            break;
+        }
+        case CalcOp::Var:
+            a.mov_rax_var(in.slot);
+            a.mov_frame_rax(sp++);
+            break;
+        case CalcOp::Load:
+            a.mov_rax_frame(temp_slot(in.slot));
+            a.mov_frame_rax(sp++);
+            break;
+        case CalcOp::Tee:
+            a.mov_rax_frame(sp - 1);
+            a.mov_frame_rax(temp_slot(in.slot));
+            break;
+        case CalcOp::Add:
+        case CalcOp::Sub:
+        case CalcOp::Mul: {
+            std::uint8_t opc = in.op == CalcOp::Add ? 0x58 : in.op == CalcOp::Sub ? 0x5C : 0x59;
+            --sp;
+            a.movsd_xmm_frame(0, sp - 1);
+            a.sse_xmm0_frame(opc, sp);
+            a.movsd_frame_xmm(sp - 1, 0);
+            break;
+        }
+        case CalcOp::Div:
+            --sp;
+            a.movsd_xmm_frame(1, sp);
+            a.xorpd_xmm2();
+            a.ucomisd_xmm2(1);
+            error_if(CC_JE, JIT_DIV_ZERO);
+            a.movsd_xmm_frame(0, sp - 1);
+            a.bytes({0xF2, 0x0F, 0x5E, 0xC1}); // divsd xmm0, xmm1
+            a.movsd_frame_xmm(sp - 1, 0);
+            break;
+        case CalcOp::Pow:
+            --sp;
+            a.movsd_xmm_frame(0, sp - 1);
+            a.movsd_xmm_frame(1, sp);
+            a.mov_rax_imm(fn_bits(&jit_pow));
+            a.call_rax();
+            a.movsd_frame_xmm(sp - 1, 0);
+            break;
+        case CalcOp::Neg:
+            a.mov_rax_frame(sp - 1);
+            a.bytes({0x48, 0x0F, 0xBA, 0xF8, 0x3F}); // btc rax, 63
+            a.mov_frame_rax(sp - 1);
+            break;
+        case CalcOp::Call:
+            emit_call(in, sp - 1);
+            break;
+        }
+    }
+
+    void emit_call(const CalcInstr& in, std::size_t slot) {
+        switch ((CalcFunc)in.slot) {
+        case CalcFunc::Abs:
+            a.mov_rax_frame(slot);
+            a.bytes({0x48, 0x0F, 0xBA, 0xF0, 0x3F}); // btr rax, 63
+            a.mov_frame_rax(slot);
+            break;
+        case CalcFunc::Sqrt:
+            a.movsd_xmm_frame(0, slot);
+            a.xorpd_xmm2();
+            a.ucomisd_xmm2(0);
+            error_if(CC_JB, JIT_SQRT_NEG);
+            a.bytes({0xF2, 0x0F, 0x51, 0xC0}); // sqrtsd xmm0, xmm0
+            a.movsd_frame_xmm(slot, 0);
+            break;
+        case CalcFunc::Log:
+        case CalcFunc::Ln: {
+            bool ln = (CalcFunc)in.slot == CalcFunc::Ln;
+            a.movsd_xmm_frame(0, slot);
+            a.xorpd_xmm2();
+            a.ucomisd_xmm2(0);
+            error_if(CC_JBE, ln ? JIT_LN_NONPOS : JIT_LOG_NONPOS);
+            a.mov_rax_imm(ln ? fn_bits(&jit_ln) : fn_bits(&jit_log10));
+            a.call_rax();
+            a.movsd_frame_xmm(slot, 0);
+            break;
+        }
+        default:
+            // sin cos tan: the builtin itself does not throw
+            call_unary(slot, fn_bits(in.fn));
+            break;
+        }
+    }
+};
+
+#endif // CALC_JIT_X86_64
+
+} // namespace
+
+bool CalcJitCode::supported() {
+#ifdef CALC_JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<CalcJitCode> CalcJitCode::compile(const CalcProgram& prog) {
+#ifdef CALC_JIT_X86_64
+    std::vector<std::uint8_t> code = JitBuilder(prog).build();
+
+    std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+    std::size_t size = (code.size() + page - 1) / page * page;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    std::memcpy(mem, code.data(), code.size());
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, size);
+        return nullptr;
+    }
+
+    std::unique_ptr<CalcJitCode> jit(new CalcJitCode());
+    jit->mem = mem;
+    jit->size = size;
+    jit->frameSlots = prog.maxDepth + prog.numTemps;
+    jit->fn = reinterpret_cast<Fn>(mem);
+    return jit;
+#else
+    (void)prog;
+    return nullptr;
+#endif
+}
+
+CalcJitCode::~CalcJitCode() {
+#ifdef CALC_JIT_X86_64
+    if (mem) munmap(mem, size);
+#endif
+}
+
+double CalcJitCode::eval(const double* vars) const {
+    constexpr std::size_t INLINE_SLOTS = 64;
+    double inline_frame[INLINE_SLOTS];
+    thread_local std::vector<double> big_frame;
+    double* frame = inline_frame;
+    if (frameSlots > INLINE_SLOTS) {
+        if (big_frame.size() < frameSlots) big_frame.resize(frameSlots);
+        frame = big_frame.data();
+    }
+
+    double out = 0.0;
+    switch (fn(vars, frame, &out)) {
+    case JIT_OK: return out;
+    case JIT_DIV_ZERO: throw std::runtime_error("Division by zero");
+    case JIT_SQRT_NEG: throw std::runtime_error("sqrt of negative");
+    case JIT_LOG_NONPOS: throw std::runtime_error("log of non-positive");
+    case JIT_LN_NONPOS: throw std::runtime_error("ln of non-positive");
+    }
+    throw std::runtime_error("Unexpected JIT result");
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "CalcProgram.h"
+#include <cstddef>
+#include <memory>
+
+/*
+ CalcJitCode - 把 CalcProgram 编译为 x86-64 机器码（不依赖外部库）
+ - 代码写入 mmap 的页面，写完后改为只读可执行（W^X）
+ - 求值栈和临时槽位放在调用方提供的内存里；+ - * / 用 SSE2 标量指令，
+   与解释器逐位一致；sqrt 内联，sin cos tan log ln 和 ^ 调用与解释器相同的 libm 函数
+ - 定义域错误以错误码返回，由 eval() 抛出与解释器相同的异常
+ - 不支持的平台上 compile() 返回空指针，调用方继续使用解释器
+*/
+class CalcJitCode {
+public:
+    // nullptr when the platform is unsupported or code memory cannot be mapped
+    static std::unique_ptr<CalcJitCode> compile(const CalcProgram& prog);
+    static bool supported();
+
+    ~CalcJitCode();
+    CalcJitCode(const CalcJitCode&) = delete;
+    CalcJitCode& operator=(const CalcJitCode&) = delete;
+
+    double eval(const double* vars) const;
+
+    std::size_t codeSize() const { return size; }
+
+private:
+    // returns 0 on success or an error code; the result is stored in *out
+    using Fn = int (*)(const double* vars, double* frame, double* out);
+
+    CalcJitCode() = default;
+
+    void* mem = nullptr;
+    std::size_t size = 0;
+    std::size_t frameSlots = 0;
+    Fn fn = nullptr;
+};
@@ -0,0 +1,292 @@
+#include "CalcOptimizer.h"
+#include "CalcSmallVector.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int MAX_POW_CHAIN = 8;
+constexpr std::size_t INLINE_NODES = 64;
+
+struct Node {
+    CalcInstr in;     // op, slot and payload of this node
+    int a = -1;       // first operand
+    int b = -1;       // second operand (binary ops)
+    bool mayThrow = false;
+};
+
+std::uint64_t payload_bits(const CalcInstr& in) {
+    if (in.op != CalcOp::Const) return 0; // Var/Call are identified by slot
+    std::uint64_t bits;
+    std::memcpy(&bits, &in.value, sizeof bits);
+    return bits;
+}
+
+bool is_binary(CalcOp op) {
+    return op == CalcOp::Add || op == CalcOp::Sub || op == CalcOp::Mul || op == CalcOp::Div || op == CalcOp::Pow;
+}
+
+class Dag {
+public:
+    CalcSmallVector<Node, INLINE_NODES> nodes;
+
+    Dag() { index.assign(2 * INLINE_NODES, -1); }
+
+    int constant(double v) {
+        CalcInstr in;
+        in.op = CalcOp::Const;
+        in.value = v;
+        return make(in, -1, -1);
+    }
+
+    // builds op(a, b) with folding and algebraic simplification
+    int build(const CalcInstr& in, int a, int b = -1) {
+        if (in.op == CalcOp::Const) return constant(in.value); // drops the source offset
+        if (in.op == CalcOp::Var) return make(in, -1, -1);
+
+        bool ca = is_const(a), cb = b >= 0 && is_const(b);
+        if (ca && (b < 0 || cb)) {
+            try {
+                return constant(calcApply(in, value(a), b >= 0 ? value(b) : 0.0));
+            } catch (const std::exception&) {
+                // keep the node so the error is raised when the expression is evaluated
+                return make(in, a, b);
+            }
+        }
+
+        switch (in.op) {
+        case CalcOp::Neg:
+            if (nodes[a].in.op == CalcOp::Neg) return nodes[a].a;
+            break;
+        case CalcOp::Add:
+            // x+0 may turn -0 into +0; both compare and print the same
+            if (is_value(b, 0.0)) return a;
+            if (is_value(a, 0.0)) return b;
+            break;
+        case CalcOp::Sub:
+            if (is_value(b, 0.0)) return a;
+            break;
+        case CalcOp::Mul:
+            if (is_value(b, 1.0)) return a;
+            if (is_value(a, 1.0)) return b;
+            break;
+        case CalcOp::Div:
+            if (is_value(b, 1.0)) return a;
+            break;
+        case CalcOp::Pow:
+            if (cb) {
+                double e = value(b);
+                if (e == 1.0) return a;
+                if (e == 0.0 && !nodes[a].mayThrow) return constant(1.0);
+                if (e >= 2.0 && e <= MAX_POW_CHAIN && e == std::floor(e)) return pow_chain(a, (unsigned)e);
+            }
+            break;
+        default:
+            break;
+        }
+        return make(in, a, b);
+    }
+
+private:
+    // open-addressing table of node indices, kept at most half full
+    CalcSmallVector<int, 2 * INLINE_NODES> index;
+
+    bool is_const(int n) const { return nodes[n].in.op == CalcOp::Const; }
+    double value(int n) const { return nodes[n].in.value; }
+    bool is_value(int n, double v) const { return n >= 0 && is_const(n) && value(n) == v; }
+
+    static bool same(const Node& n, const CalcInstr& in, int a, int b) {
+        return n.in.op == in.op && n.in.slot == in.slot && payload_bits(n.in) == payload_bits(in) &&
+               n.a == a && n.b == b;
+    }
+
+    static std::size_t hash(const CalcInstr& in, int a, int b) {
+        std::uint64_t h = payload_bits(in) ^ ((std::uint64_t)in.op << 56) ^ ((std::uint64_t)in.slot << 40);
+        h ^= (std::uint64_t)(std::uint32_t)a * 0x9E3779B97F4A7C15ull;
+        h ^= (std::uint64_t)(std::uint32_t)b * 0xC2B2AE3D27D4EB4Full;
+        return (std::size_t)(h ^ (h >> 29));
+    }
+
+    // returns the slot holding an equal node, or the empty slot where it belongs
+    std::size_t probe(const CalcInstr& in, int a, int b) const {
+        std::size_t mask = index.size() - 1;
+        std::size_t i = hash(in, a, b) & mask;
+        while (index[i] >= 0 && !same(nodes[index[i]], in, a, b)) i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        CalcSmallVector<int, 2 * INLINE_NODES> old;
+        old.assign(index.size() * 2, -1);
+        std::swap(old, index);
+        for (int n : old)
+            if (n >= 0) index[probe(nodes[n].in, nodes[n].a, nodes[n].b)] = n;
+    }
+
+    // hash-consing: structurally equal nodes share one index
+    int make(const CalcInstr& in, int a, int b) {
+        std::size_t slot = probe(in, a, b);
+        if (index[slot] >= 0) return index[slot];
+
+        Node n;
+        n.in = in;
+        n.a = a;
+        n.b = b;
+        if (in.op == CalcOp::Div) n.mayThrow = !is_const(b) || value(b) == 0.0;
+        if (in.op == CalcOp::Call) {
+            CalcFunc f = (CalcFunc)in.slot;
+            n.mayThrow = f == CalcFunc::Sqrt || f == CalcFunc::Log || f == CalcFunc::Ln;
+        }
+        if (a >= 0 && nodes[a].mayThrow) n.mayThrow = true;
+        if (b >= 0 && nodes[b].mayThrow) n.mayThrow = true;
+
+        nodes.push_back(n);
+        int id = (int)nodes.size() - 1;
+        index[slot] = id;
+        if (nodes.size() * 2 > index.size()) grow();
+        return id;
+    }
+
+    // square-and-multiply from the top bit down: x^n = (x^(n/2))^2 * x^(n&1)
+    int pow_chain(int x, unsigned n) {
+        CalcInstr mul;
+        mul.op = CalcOp::Mul;
+        int top = 31;
+        while (!(n >> top)) --top;
+        int r = x;
+        for (int bit = top - 1; bit >= 0; --bit) {
+            r = build(mul, r, r);
+            if ((n >> bit) & 1) r = build(mul, r, x);
+        }
+        return r;
+    }
+};
+
+class Emitter {
+public:
+    Emitter(const Dag& dag, CalcProgram& out)
+        : dag(dag), out(out) {
+        uses.assign(dag.nodes.size(), 0);
+        temp.assign(dag.nodes.size(), -1);
+    }
+
+    void run(int root) {
+        count(root);
+        emit(root);
+    }
+
+private:
+    const Dag& dag;
+    CalcProgram& out;
+    CalcSmallVector<int, INLINE_NODES> uses;
+    CalcSmallVector<int, INLINE_NODES> temp;
+    std::size_t depth = 0;
+
+    // both walks use an explicit stack: a long chain like x+x+...+x is as deep as it is long
+    void count(int root) {
+        CalcSmallVector<int, INLINE_NODES> todo;
+        todo.push_back(root);
+        while (!todo.empty()) {
+            int n = todo.back();
+            todo.pop_back();
+            if (uses[n]++ > 0) continue;
+            if (dag.nodes[n].b >= 0) todo.push_back(dag.nodes[n].b);
+            if (dag.nodes[n].a >= 0) todo.push_back(dag.nodes[n].a);
+        }
+    }
+
+    void push(const CalcInstr& in) {
+        out.code.push_back(in);
+        if (in.op == CalcOp::Const || in.op == CalcOp::Var || in.op == CalcOp::Load) ++depth;
+        else if (is_binary(in.op)) --depth;
+        if (depth > out.maxDepth) out.maxDepth = depth;
+    }
+
+    // post-order, operands left to right; stage counts the operands already emitted
+    void emit(int root) {
+        struct Frame {
+            int n;
+            int stage;
+        };
+        CalcSmallVector<Frame, INLINE_NODES> todo;
+        todo.push_back({root, 0});
+        while (!todo.empty()) {
+            int n = todo.back().n;
+            const Node& node = dag.nodes[n];
+            int stage = todo.back().stage++;
+            if (stage == 0 && temp[n] >= 0) {
+                CalcInstr load;
+                load.op = CalcOp::Load;
+                load.slot = (std::uint32_t)temp[n];
+                push(load);
+                todo.pop_back();
+                continue;
+            }
+            if (stage == 0 && node.a >= 0) {
+                todo.push_back({node.a, 0});
+                continue;
+            }
+            if (stage <= 1 && node.b >= 0) {
+                todo.back().stage = 2;
+                todo.push_back({node.b, 0});
+                continue;
+            }
+            todo.pop_back();
+            push(node.in);
+
+            // shared non-trivial subexpression: keep the value for later uses
+            bool trivial = node.in.op == CalcOp::Const || node.in.op == CalcOp::Var;
+            if (uses[n] > 1 && !trivial) {
+                temp[n] = (int)out.numTemps++;
+                CalcInstr tee;
+                tee.op = CalcOp::Tee;
+                tee.slot = (std::uint32_t)temp[n];
+                push(tee);
+            }
+        }
+    }
+};
+
+} // namespace
+
+CalcProgram optimizeCalcProgram(CalcProgram prog) {
+    Dag dag;
+    CalcSmallVector<int, INLINE_NODES> stack;
+    CalcSmallVector<int, INLINE_NODES> temps;
+    temps.assign(prog.numTemps, -1);
+    for (const CalcInstr& in : prog.code) {
+        switch (in.op) {
+        case CalcOp::Const:
+        case CalcOp::Var:
+            stack.push_back(dag.build(in, -1));
+            break;
+        case CalcOp::Neg:
+        case CalcOp::Call:
+            stack.back() = dag.build(in, stack.back());
+            break;
+        case CalcOp::Tee:
+            temps[in.slot] = stack.back();
+            break;
+        case CalcOp::Load:
+            stack.push_back(temps[in.slot]);
+            break;
+        default: {
+            int b = stack.back();
+            stack.pop_back();
+            stack.back() = dag.build(in, stack.back(), b);
+            break;
+        }
+        }
+    }
+    if (stack.size() != 1) throw std::runtime_error("Invalid expression");
+
+    CalcProgram out;
+    out.vars = std::move(prog.vars);
+    out.code.reserve(prog.code.size());
+    Emitter(dag, out).run(stack.back());
+    return out;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "CalcProgram.h"
+
+/*
+ CalcOptimizer - 字节码优化（Shunting-Yard 之后、求值之前）
+ - 把后缀字节码还原为表达式 DAG，结构相同的子表达式合并为同一个节点
+ - 常量折叠：会抛异常的常量子树（如 1/0、sqrt(-1)）保留到运行时，错误仍在原位置抛出
+ - 恒等式：x*1、1*x、x/1、x+0、0+x、x-0、neg(neg(x))、x^1；x 不会出错时 x^0 -> 1
+ - 强度削减：x^2 -> x*x，x^n (3 <= n <= 8) -> 乘法链
+ - 公共子表达式只计算一次：第一次出现时 Tee 到临时槽位，之后 Load
+ - 求值顺序保持从左到右，所以运行时错误的先后与未优化时一致
+ - 节点和哈希表放在内联缓冲区里，常见大小的表达式优化时只为结果分配内存
+*/
+CalcProgram optimizeCalcProgram(CalcProgram prog);
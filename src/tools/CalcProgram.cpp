@@ -0,0 +1,327 @@
+#include "CalcProgram.h"
+#include "CalcOptimizer.h"
+#include "CalcJit.h"
+#include "CalcEval.h"
+#include "CalcSmallVector.h"
+#include "Metrics.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+/*
+ Implementation details:
+ - Tokenizer produces numbers, identifiers (functions), variables, operators, parentheses.
+   Tokens are string_view slices of the source; numbers are parsed with from_chars.
+ - Uses Shunting-Yard to produce RPN; operators are CalcOp enums throughout.
+ - Tokens, the operator stack and the RPN queue live in CalcSmallVector, so parsing
+   an expression of up to INLINE_TOKENS tokens does not touch the heap.
+ - RPN is lowered to CalcInstr bytecode; stack depth is checked at compile time.
+ - The bytecode is then rewritten by optimizeCalcProgram (CalcOptimizer).
+ - Throws runtime_error on malformed expressions.
+*/
+
+namespace {
+
+constexpr size_t INLINE_TOKENS = 64;
+
+enum TokenType : std::uint8_t { T_NUMBER, T_OP, T_LPAREN, T_RPAREN, T_FUNC, T_VAR };
+
+struct Token {
+    TokenType type = T_NUMBER;
+    CalcOp op = CalcOp::Const; // T_OP: Add..Pow; T_FUNC: Neg or Call
+    std::string_view text;     // source slice: number literal, function or variable name
+    double value = 0.0;        // when type == T_NUMBER
+};
+
+using TokenList = CalcSmallVector<Token, INLINE_TOKENS>;
+
+bool is_ident_char(char c) {
+    return std::isalpha((unsigned char)c) || c == '_';
+}
+
+bool is_function_name(std::string_view id) {
+    return id == "neg" || findCalcBuiltin(id) != nullptr;
+}
+
+CalcOp binary_op(char c) {
+    switch (c) {
+    case '+': return CalcOp::Add;
+    case '-': return CalcOp::Sub;
+    case '*': return CalcOp::Mul;
+    case '/': return CalcOp::Div;
+    case '^': return CalcOp::Pow;
+    default: return CalcOp::Const;
+    }
+}
+
+void tokenize(std::string_view s, TokenList& out) {
+    size_t i = 0;
+    while (i < s.size()) {
+        char c = s[i];
+        if (std::isspace((unsigned char)c)) { ++i; continue; }
+
+        if (std::isdigit((unsigned char)c) || c == '.') {
+            size_t j = i;
+            while (j < s.size() && (std::isdigit((unsigned char)s[j]) || s[j] == '.')) ++j;
+            // like stod: the longest valid prefix of the digit run is the number ("1.2.3" -> 1.2)
+            Token t;
+            auto r = std::from_chars(s.data() + i, s.data() + j, t.value, std::chars_format::fixed);
+            if (r.ec != std::errc()) throw std::runtime_error("Invalid number: " + std::string(s.substr(i, j - i)));
+            t.text = s.substr(i, (size_t)(r.ptr - (s.data() + i)));
+            out.push_back(t);
+            i = j;
+            continue;
+        }
+
+        if (is_ident_char(c)) {
+            size_t j = i;
+            while (j < s.size() && is_ident_char(s[j])) ++j;
+            Token t;
+            t.text = s.substr(i, j - i);
+            // builtins are always functions; other names are functions only when called
+            size_t k = j;
+            while (k < s.size() && std::isspace((unsigned char)s[k])) ++k;
+            bool called = k < s.size() && s[k] == '(';
+            if (is_function_name(t.text) || called) {
+                t.type = T_FUNC;
+                t.op = t.text == "neg" ? CalcOp::Neg : CalcOp::Call;
+            } else {
+                t.type = T_VAR;
+            }
+            out.push_back(t);
+            i = j;
+            continue;
+        }
+
+        // operators and parentheses
+        CalcOp op = binary_op(c);
+        if (op != CalcOp::Const) {
+            Token t; t.type = T_OP; t.op = op;
+            out.push_back(t);
+            ++i;
+            continue;
+        }
+
+        if (c == '(') { Token t; t.type = T_LPAREN; out.push_back(t); ++i; continue; }
+        if (c == ')') { Token t; t.type = T_RPAREN; out.push_back(t); ++i; continue; }
+
+        throw std::runtime_error(std::string("Unknown character: ") + c);
+    }
+}
+
+int precedence(CalcOp op) {
+    switch (op) {
+    case CalcOp::Pow: return 4;
+    case CalcOp::Mul: case CalcOp::Div: return 3;
+    case CalcOp::Add: case CalcOp::Sub: return 2;
+    default: return 0;
+    }
+}
+
+// right associative?
+bool is_right_associative(CalcOp op) {
+    return op == CalcOp::Pow;
+}
+
+void to_rpn(const TokenList& tokens, TokenList& output) {
+    TokenList ops; // operator stack (ops, funcs and parens)
+    // We need to handle unary minus: when '-' appears at start or after '(' or another operator -> unary
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        if (t.type == T_NUMBER || t.type == T_VAR) {
+            output.push_back(t);
+        } else if (t.type == T_FUNC) {
+            // function identifier -> push to ops
+            ops.push_back(t);
+        } else if (t.type == T_OP) {
+            // handle unary minus: represent as a Neg function
+            if (t.op == CalcOp::Sub && (i == 0 || tokens[i-1].type == T_OP || tokens[i-1].type == T_LPAREN)) {
+                Token neg; neg.type = T_FUNC; neg.op = CalcOp::Neg;
+                ops.push_back(neg);
+                continue;
+            }
+
+            while (!ops.empty()) {
+                const Token& top = ops.back();
+                if (top.type == T_FUNC) {
+                    // functions have higher precedence; pop to output
+                    output.push_back(top);
+                    ops.pop_back();
+                } else if (top.type == T_OP) {
+                    if ((is_right_associative(t.op) && precedence(t.op) < precedence(top.op)) ||
+                        (!is_right_associative(t.op) && precedence(t.op) <= precedence(top.op))) {
+                        output.push_back(top);
+                        ops.pop_back();
+                    } else break;
+                } else break;
+            }
+            ops.push_back(t);
+        } else if (t.type == T_LPAREN) {
+            ops.push_back(t);
+        } else if (t.type == T_RPAREN) {
+            bool foundLeft = false;
+            while (!ops.empty()) {
+                Token top = ops.back();
+                ops.pop_back();
+                if (top.type == T_LPAREN) { foundLeft = true; break; }
+                output.push_back(top);
+            }
+            if (!foundLeft) throw std::runtime_error("Mismatched parentheses");
+            // if function on top of ops, pop it to output
+            if (!ops.empty() && ops.back().type == T_FUNC) {
+                output.push_back(ops.back());
+                ops.pop_back();
+            }
+        }
+    }
+
+    while (!ops.empty()) {
+        Token top = ops.back();
+        ops.pop_back();
+        if (top.type == T_LPAREN || top.type == T_RPAREN) throw std::runtime_error("Mismatched parentheses");
+        output.push_back(top);
+    }
+}
+
+double fn_sin(double x) { return std::sin(x); }
+double fn_cos(double x) { return std::cos(x); }
+double fn_tan(double x) { return std::tan(x); }
+double fn_sqrt(double x) { if (x < 0) throw std::runtime_error("sqrt of negative"); return std::sqrt(x); }
+double fn_abs(double x) { return std::fabs(x); }
+double fn_log(double x) { if (x <= 0) throw std::runtime_error("log of non-positive"); return std::log10(x); }
+double fn_ln(double x) { if (x <= 0) throw std::runtime_error("ln of non-positive"); return std::log(x); }
+
+// indexed by CalcFunc
+const CalcBuiltin BUILTINS[] = {
+    {"sin", fn_sin},
+    {"cos", fn_cos},
+    {"tan", fn_tan},
+    {"sqrt", fn_sqrt},
+    {"abs", fn_abs},
+    {"log", fn_log},
+    {"ln", fn_ln},
+};
+
+std::uint32_t var_slot(CalcProgram& prog, std::string_view name) {
+    for (size_t i = 0; i < prog.vars.size(); ++i)
+        if (prog.vars[i] == name) return (std::uint32_t)i;
+    prog.vars.emplace_back(name);
+    return (std::uint32_t)(prog.vars.size() - 1);
+}
+
+} // namespace
+
+const CalcBuiltin* findCalcBuiltin(std::string_view name) {
+    for (const auto& b : BUILTINS)
+        if (name == b.name) return &b;
+    return nullptr;
+}
+
+const CalcBuiltin& calcBuiltin(CalcFunc f) {
+    return BUILTINS[(size_t)f];
+}
+
+std::string_view calcLiteralAt(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size() && std::isdigit((unsigned char)text[i])) ++i;
+    if (i < text.size() && text[i] == '.') {
+        ++i;
+        while (i < text.size() && std::isdigit((unsigned char)text[i])) ++i;
+    }
+    return text.substr(0, i);
+}
+
+double calcApply(const CalcInstr& in, double a, double b) {
+    switch (in.op) {
+    case CalcOp::Add: return a + b;
+    case CalcOp::Sub: return a - b;
+    case CalcOp::Mul: return a * b;
+    case CalcOp::Div:
+        if (b == 0.0) throw std::runtime_error("Division by zero");
+        return a / b;
+    case CalcOp::Pow: return std::pow(a, b);
+    case CalcOp::Neg: return -a;
+    case CalcOp::Call: return in.fn(a);
+    default: break;
+    }
+    throw std::runtime_error("Unexpected instruction");
+}
+
+// a clock read costs ~40 ns on some VMs, close to 1% of a compile per phase; time 1 in 16
+static MetricTimer& METRIC_TOKENIZE = metricTimer("suite_calc_tokenize", "Calculator: tokenizing an expression", "", 16);
+static MetricTimer& METRIC_RPN = metricTimer("suite_calc_shunting_yard", "Calculator: infix to RPN", "", 16);
+static MetricTimer& METRIC_CODEGEN = metricTimer("suite_calc_codegen", "Calculator: bytecode generation and optimization", "", 16);
+
+CalcProgram CalcProgram::compile(const std::string& expr, bool optimize) {
+    TokenList tokens, rpn;
+    {
+        MetricScope m(METRIC_TOKENIZE);
+        tokenize(expr, tokens);
+    }
+    {
+        MetricScope m(METRIC_RPN);
+        to_rpn(tokens, rpn);
+    }
+
+    MetricScope m(METRIC_CODEGEN);
+    CalcProgram prog;
+    prog.code.reserve(rpn.size());
+    size_t depth = 0;
+    for (const Token& tk : rpn) {
+        CalcInstr in;
+        switch (tk.type) {
+        case T_NUMBER:
+            in.op = CalcOp::Const;
+            in.slot = (std::uint32_t)(tk.text.data() - expr.data());
+            in.value = tk.value;
+            ++depth;
+            break;
+        case T_VAR:
+            in.op = CalcOp::Var;
+            in.slot = var_slot(prog, tk.text);
+            ++depth;
+            break;
+        case T_OP:
+            if (depth < 2) throw std::runtime_error("Invalid expression (binary op)");
+            in.op = tk.op;
+            --depth;
+            break;
+        case T_FUNC:
+            // either function like sin, or unary neg
+            if (tk.op == CalcOp::Neg) {
+                if (depth < 1) throw std::runtime_error("Invalid expression (neg)");
+                in.op = CalcOp::Neg;
+            } else {
+                if (depth < 1) throw std::runtime_error("Invalid expression (func)");
+                const CalcBuiltin* b = findCalcBuiltin(tk.text);
+                if (!b) throw std::runtime_error("Unknown function: " + std::string(tk.text));
+                in.op = CalcOp::Call;
+                in.slot = (std::uint32_t)(b - BUILTINS);
+                in.fn = b->fn;
+            }
+            break;
+        default:
+            throw std::runtime_error("Unexpected token in RPN eval");
+        }
+        prog.code.push_back(in);
+        if (depth > prog.maxDepth) prog.maxDepth = depth;
+    }
+
+    if (depth == 0) throw std::runtime_error("Empty expression");
+    if (depth > 1) throw std::runtime_error("Invalid expression (extra values)");
+    return optimize ? optimizeCalcProgram(std::move(prog)) : prog;
+}
+
+double CalcProgram::eval(const double* vars) const {
+    if (jit) return jit->eval(vars);
+    return interpret(vars);
+}
+
+double CalcProgram::interpret(const double* vars) const {
+    return calcEvaluate<CalcDoubleOps>(*this, vars);
+}
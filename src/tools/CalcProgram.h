@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ CalcProgram - 表达式的编译形式（字节码）
+ - 表达式只解析一次：分词 -> Shunting-Yard -> 紧凑的后缀字节码
+ - 常量直接打包在指令里，函数调用保存预先解析好的函数指针
+ - 非函数名的标识符是变量，按出现顺序编号为槽位（见 vars）
+ - 编译时检查栈平衡并记录最大栈深度，eval() 不做任何内存分配
+ - 热点表达式可以挂上 JIT 生成的机器码（见 CalcJit.h），eval() 会优先使用
+ - 默认经过 CalcOptimizer：常量折叠、恒等式消除、幂运算强度削减、公共子表达式消除
+*/
+
+enum class CalcOp : std::uint8_t {
+    Const, // push value; slot = offset of the literal in the source (unoptimized programs)
+    Var,   // push vars[slot]
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    Neg,
+    Call,  // apply fn to top of stack; slot = CalcFunc
+    Tee,   // temps[slot] = top of stack (no pop)
+    Load,  // push temps[slot]
+};
+
+enum class CalcFunc : std::uint8_t { Sin, Cos, Tan, Sqrt, Abs, Log, Ln };
+
+using CalcFn = double (*)(double);
+
+struct CalcInstr {
+    CalcOp op;
+    std::uint32_t slot = 0;
+    union {
+        double value;
+        CalcFn fn;
+    };
+
+    CalcInstr() : op(CalcOp::Const), value(0.0) {}
+};
+
+struct CalcBuiltin {
+    const char* name;
+    CalcFn fn;
+};
+
+// built-in functions (sin cos tan sqrt abs log ln); returns nullptr if unknown
+const CalcBuiltin* findCalcBuiltin(std::string_view name);
+const CalcBuiltin& calcBuiltin(CalcFunc f);
+
+// the numeric literal starting at text, as the tokenizer reads it ("1.2.3" -> "1.2");
+// exact backends use it to re-read Const instructions from the source
+std::string_view calcLiteralAt(std::string_view text);
+
+// applies an arithmetic instruction (Add..Call) to operands a (and b for binary ops);
+// throws the same errors as CalcProgram::eval
+double calcApply(const CalcInstr& in, double a, double b = 0.0);
+
+class CalcJitCode;
+
+struct CalcProgram {
+    std::vector<CalcInstr> code;
+    std::vector<std::string> vars; // variable names by slot
+    std::size_t maxDepth = 0;
+    std::size_t numTemps = 0; // slots used by Tee/Load
+    std::shared_ptr<const CalcJitCode> jit; // native code, attached once the program is hot
+
+    // throws runtime_error on malformed expressions
+    static CalcProgram compile(const std::string& expr, bool optimize = true);
+
+    // vars[i] is the value of variable slot i (may be null if the program has no variables);
+    // throws runtime_error on domain errors (division by zero, sqrt of negative...)
+    double eval(const double* vars = nullptr) const;
+
+    // bytecode interpreter, ignoring any attached native code
+    double interpret(const double* vars = nullptr) const;
+};
@@ -0,0 +1,210 @@
+#include "CalcRational.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - The (num, den) constructor reduces by the gcd and makes the denominator positive,
+   so equal values always have equal representations.
+ - pow() refuses results larger than MAX_EXACT_BITS instead of running out of memory.
+*/
+
+namespace {
+
+constexpr std::size_t MAX_EXACT_BITS = 1 << 22;
+constexpr long long MAX_DECIMAL_EXPONENT = 100000;
+
+CalcBigInt pow10(unsigned long long k) {
+    return CalcBigInt::pow(CalcBigInt(10), k);
+}
+
+} // namespace
+
+CalcRational::CalcRational(CalcBigInt num, CalcBigInt den) : n(std::move(num)), d(std::move(den)) {
+    if (d.isZero()) throw std::runtime_error("Division by zero");
+    if (d.isNegative()) {
+        n = -n;
+        d = -d;
+    }
+    if (n.isZero()) {
+        d = CalcBigInt(1);
+        return;
+    }
+    CalcBigInt g = CalcBigInt::gcd(n, d);
+    if (g != CalcBigInt(1)) {
+        n = n / g;
+        d = d / g;
+    }
+}
+
+CalcRational CalcRational::fromDecimal(std::string_view text) {
+    std::string_view s = text;
+    bool negative = !s.empty() && s[0] == '-';
+    if (negative) s.remove_prefix(1);
+
+    std::string digits;
+    long long exp10 = 0;
+    size_t i = 0;
+    bool seenDot = false;
+    for (; i < s.size(); ++i) {
+        char c = s[i];
+        if (c >= '0' && c <= '9') {
+            digits.push_back(c);
+            if (seenDot) --exp10;
+        } else if (c == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            break;
+        }
+    }
+    if (digits.empty()) throw std::runtime_error("Invalid number: " + std::string(text));
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+        long long e = 0;
+        const char* first = s.data() + i + 1;
+        if (first < s.data() + s.size() && *first == '+') ++first;
+        auto r = std::from_chars(first, s.data() + s.size(), e);
+        if (r.ec != std::errc() || r.ptr != s.data() + s.size() || e > MAX_DECIMAL_EXPONENT || e < -MAX_DECIMAL_EXPONENT)
+            throw std::runtime_error("Invalid number: " + std::string(text));
+        exp10 += e;
+        i = s.size();
+    }
+    if (i != s.size()) throw std::runtime_error("Invalid number: " + std::string(text));
+
+    CalcBigInt num = CalcBigInt::fromDecimal(digits);
+    if (negative) num = -num;
+    if (exp10 >= 0) return CalcRational(num * pow10((unsigned long long)exp10));
+    return CalcRational(num, pow10((unsigned long long)-exp10));
+}
+
+CalcRational CalcRational::fromDouble(double v) {
+    if (!std::isfinite(v)) throw std::runtime_error("Value is not finite");
+    char buf[64];
+    auto r = std::to_chars(buf, buf + sizeof buf, v);
+    return fromDecimal(std::string_view(buf, (size_t)(r.ptr - buf)));
+}
+
+CalcRational operator+(const CalcRational& a, const CalcRational& b) {
+    if (a.d == b.d) return CalcRational(a.n + b.n, a.d);
+    return CalcRational(a.n * b.d + b.n * a.d, a.d * b.d);
+}
+
+CalcRational operator-(const CalcRational& a, const CalcRational& b) {
+    if (a.d == b.d) return CalcRational(a.n - b.n, a.d);
+    return CalcRational(a.n * b.d - b.n * a.d, a.d * b.d);
+}
+
+CalcRational operator*(const CalcRational& a, const CalcRational& b) {
+    return CalcRational(a.n * b.n, a.d * b.d);
+}
+
+CalcRational operator/(const CalcRational& a, const CalcRational& b) {
+    if (b.isZero()) throw std::runtime_error("Division by zero");
+    return CalcRational(a.n * b.d, a.d * b.n);
+}
+
+CalcRational CalcRational::pow(const CalcRational& base, const CalcRational& exp) {
+    if (!exp.isInteger()) throw std::runtime_error("Non-integer exponent in exact mode (use 'mode big')");
+    if (exp.isZero()) return CalcRational(1);
+    // 0, 1 and -1 stay small for any exponent
+    if (base.isZero()) {
+        if (exp.sign() < 0) throw std::runtime_error("Division by zero");
+        return CalcRational();
+    }
+    if (base.d == CalcBigInt(1) && base.n.abs() == CalcBigInt(1)) {
+        bool odd = exp.n.isOdd();
+        return CalcRational(odd ? base.n : CalcBigInt(1));
+    }
+
+    long long e = 0;
+    size_t bits = std::max(base.n.bitLength(), base.d.bitLength());
+    if (!exp.n.toInt64(&e) || e > (long long)MAX_EXACT_BITS || e < -(long long)MAX_EXACT_BITS ||
+        (size_t)std::llabs(e) > MAX_EXACT_BITS / bits)
+        throw std::runtime_error("Result too large for exact mode");
+    unsigned long long k = (unsigned long long)std::llabs(e);
+    CalcBigInt pn = CalcBigInt::pow(base.n, k), pd = CalcBigInt::pow(base.d, k);
+    // already in lowest terms: powers of coprime numbers are coprime
+    CalcRational r;
+    if (e > 0) {
+        r.n = std::move(pn);
+        r.d = std::move(pd);
+    } else {
+        r.n = std::move(pd);
+        r.d = std::move(pn);
+        if (r.d.isNegative()) {
+            r.n = -r.n;
+            r.d = -r.d;
+        }
+    }
+    return r;
+}
+
+bool CalcRational::sqrt(CalcRational* out) const {
+    if (n.isNegative()) throw std::runtime_error("sqrt of negative");
+    CalcBigInt rn = n.isqrt(), rd = d.isqrt();
+    if (rn * rn != n || rd * rd != d) return false;
+    *out = CalcRational(rn, rd);
+    return true;
+}
+
+int CalcRational::compare(const CalcRational& a, const CalcRational& b) {
+    return CalcBigInt::compare(a.n * b.d, b.n * a.d);
+}
+
+double CalcRational::toDouble() const {
+    // scale so the integer quotient carries 64 significant bits
+    long long shift = 64 - (long long)n.bitLength() + (long long)d.bitLength();
+    CalcBigInt q = shift >= 0 ? (n << (size_t)shift) / d : n / (d << (size_t)-shift);
+    return std::ldexp(q.toDouble(), (int)std::max(-100000LL, std::min(100000LL, -shift)));
+}
+
+bool CalcRational::toDecimal(std::string* out) const {
+    // 1/d terminates iff d = 2^a * 5^b; the expansion then has max(a, b) decimals
+    CalcBigInt rest = d;
+    size_t twos = 0, fives = 0;
+    while (!rest.isOdd()) {
+        rest = rest >> 1;
+        ++twos;
+    }
+    CalcBigInt q, r, five(5);
+    while (true) {
+        CalcBigInt::divMod(rest, five, q, r);
+        if (!r.isZero()) break;
+        rest = std::move(q);
+        ++fives;
+    }
+    if (rest != CalcBigInt(1)) return false;
+
+    size_t places = std::max(twos, fives);
+    std::string digits = (n.abs() * pow10(places) / d).toString();
+    if (places > 0) {
+        if (digits.size() <= places) digits.insert(0, places - digits.size() + 1, '0');
+        digits.insert(digits.size() - places, ".");
+    }
+    *out = (n.isNegative() ? "-" : "") + digits;
+    return true;
+}
+
+std::string CalcRational::toString() const {
+    std::string s;
+    if (toDecimal(&s)) return s;
+    return n.toString() + "/" + d.toString();
+}
+
+CalcRational CalcRationalOps::constant(const CalcInstr& in) const {
+    return CalcRational::fromDecimal(calcLiteralAt(source.substr(in.slot)));
+}
+
+CalcRational CalcRationalOps::call(const CalcInstr& in, const CalcRational& a) const {
+    CalcFunc f = (CalcFunc)in.slot;
+    if (f == CalcFunc::Abs) return a.abs();
+    if (f == CalcFunc::Sqrt) {
+        CalcRational r;
+        if (a.sqrt(&r)) return r;
+    }
+    // keep the double path's domain errors
+    if (f == CalcFunc::Log && a.sign() <= 0) throw std::runtime_error("log of non-positive");
+    if (f == CalcFunc::Ln && a.sign() <= 0) throw std::runtime_error("ln of non-positive");
+    throw std::runtime_error(std::string(calcBuiltin(f).name) + " is not exact (use 'mode big')");
+}
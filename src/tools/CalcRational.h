@@ -0,0 +1,69 @@
+#pragma once
+#include "CalcBigInt.h"
+#include "CalcProgram.h"
+#include <string>
+#include <string_view>
+
+/*
+ CalcRational - 精确有理数 num/den（计算器的精确模式）
+ - 始终约分，分母为正；+ - * / 和整数次幂没有任何舍入
+ - 十进制字面量按原文解析（0.1 就是 1/10，不经过 double）
+ - toString：整数和有限小数按十进制输出，其余输出为 p/q
+*/
+class CalcRational {
+public:
+    CalcRational() = default;
+    CalcRational(CalcBigInt num, CalcBigInt den = CalcBigInt(1));
+
+    // "12.5", "1.", ".5", optionally with an exponent ("1e-07"); an optional leading '-'
+    static CalcRational fromDecimal(std::string_view text);
+    // exact value of the shortest decimal that round-trips to v; throws for inf/nan
+    static CalcRational fromDouble(double v);
+
+    const CalcBigInt& num() const { return n; }
+    const CalcBigInt& den() const { return d; }
+    bool isZero() const { return n.isZero(); }
+    bool isInteger() const { return d == CalcBigInt(1); }
+    int sign() const { return n.sign(); }
+
+    CalcRational operator-() const { return CalcRational(-n, d); }
+    CalcRational abs() const { return CalcRational(n.abs(), d); }
+    friend CalcRational operator+(const CalcRational& a, const CalcRational& b);
+    friend CalcRational operator-(const CalcRational& a, const CalcRational& b);
+    friend CalcRational operator*(const CalcRational& a, const CalcRational& b);
+    // throws "Division by zero"
+    friend CalcRational operator/(const CalcRational& a, const CalcRational& b);
+
+    // integer exponents only; throws when the exponent is not an integer or the result is too large
+    static CalcRational pow(const CalcRational& base, const CalcRational& exp);
+    // exact square root of a perfect square; false if the root is irrational
+    bool sqrt(CalcRational* out) const;
+
+    static int compare(const CalcRational& a, const CalcRational& b);
+    double toDouble() const;
+    // exact: "42", "-0.125" or "1/3"
+    std::string toString() const;
+    // the terminating decimal expansion, if the denominator only has factors 2 and 5
+    bool toDecimal(std::string* out) const;
+
+private:
+    CalcBigInt n;
+    CalcBigInt d = CalcBigInt(1);
+};
+
+// CalcEval backend for the exact mode; source is the text the program was compiled from
+// (with optimization off, so Const instructions still point at their literals)
+struct CalcRationalOps {
+    using Number = CalcRational;
+    std::string_view source;
+
+    CalcRational constant(const CalcInstr& in) const;
+    CalcRational add(const CalcRational& a, const CalcRational& b) const { return a + b; }
+    CalcRational sub(const CalcRational& a, const CalcRational& b) const { return a - b; }
+    CalcRational mul(const CalcRational& a, const CalcRational& b) const { return a * b; }
+    CalcRational div(const CalcRational& a, const CalcRational& b) const { return a / b; }
+    CalcRational pow(const CalcRational& a, const CalcRational& b) const { return CalcRational::pow(a, b); }
+    CalcRational neg(const CalcRational& a) const { return -a; }
+    // abs is exact, sqrt only for perfect squares; other functions throw
+    CalcRational call(const CalcInstr& in, const CalcRational& a) const;
+};
@@ -0,0 +1,201 @@
+#include "CalcSheet.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t PARALLEL_MIN_LEVEL = 256; // narrower levels are not worth the hand-off
+constexpr std::size_t PARALLEL_CHUNK = 64;
+
+} // namespace
+
+CalcSheet::CalcSheet() = default;
+CalcSheet::~CalcSheet() = default;
+
+int CalcSheet::node_id(const std::string& name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    nodes.emplace_back();
+    nodes.back().name = name;
+    ids.emplace(name, (int)nodes.size() - 1);
+    return (int)nodes.size() - 1;
+}
+
+std::size_t CalcSheet::define(const std::string& name, const std::string& expr) {
+    CalcProgram prog = CalcProgram::compile(expr);
+    return install(name, std::move(prog), expr);
+}
+
+std::size_t CalcSheet::setValue(const std::string& name, double value) {
+    CalcProgram prog;
+    CalcInstr c;
+    c.op = CalcOp::Const;
+    c.value = value;
+    prog.code.push_back(c);
+    prog.maxDepth = 1;
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.17g", value);
+    return install(name, std::move(prog), buf);
+}
+
+void CalcSheet::check_cycle(int id, const std::vector<int>& deps) {
+    // everything downstream of id (including id) would become its own ancestor; the walk only
+    // touches that subgraph, so defining a cell nothing references costs O(1)
+    ++epoch;
+    std::vector<int> queue{id};
+    nodes[id].mark = epoch;
+    nodes[id].parent = -1;
+    for (std::size_t qi = 0; qi < queue.size(); ++qi) {
+        for (int d : nodes[queue[qi]].dependents) {
+            if (nodes[d].mark == epoch) continue;
+            nodes[d].mark = epoch;
+            nodes[d].parent = queue[qi];
+            queue.push_back(d);
+        }
+    }
+    for (int d : deps) {
+        if (nodes[d].mark != epoch) continue;
+        // id -> d -> ... -> id, reading "->" as "references"
+        std::string path = nodes[id].name;
+        for (int n = d; n != -1; n = nodes[n].parent) path += " -> " + nodes[n].name;
+        throw std::runtime_error("Circular reference: " + path);
+    }
+}
+
+std::size_t CalcSheet::install(const std::string& name, CalcProgram prog, const std::string& formula) {
+    // placeholder nodes for new names are only linked in once the definition is accepted,
+    // so a rejected one can drop them again by truncating
+    std::size_t existing = nodes.size();
+    int id = -1;
+    std::vector<int> deps;
+    try {
+        id = node_id(name);
+        deps.reserve(prog.vars.size());
+        for (const std::string& v : prog.vars) deps.push_back(node_id(v));
+        check_cycle(id, deps);
+    } catch (...) {
+        for (std::size_t i = existing; i < nodes.size(); ++i) ids.erase(nodes[i].name);
+        nodes.resize(existing);
+        throw;
+    }
+
+    Node& n = nodes[id];
+    for (int d : n.deps) {
+        auto& ds = nodes[d].dependents;
+        ds.erase(std::remove(ds.begin(), ds.end(), id), ds.end());
+    }
+    n.deps = deps;
+    for (int d : deps) nodes[d].dependents.push_back(id);
+    n.prog = std::move(prog);
+    n.formula = formula;
+    n.defined = true;
+    return recompute_from(id);
+}
+
+void CalcSheet::compute(Node& n) {
+    n.error.clear();
+    constexpr std::size_t INLINE_VARS = 16;
+    double inline_vals[INLINE_VARS];
+    std::vector<double> many;
+    double* vals = inline_vals;
+    if (n.deps.size() > INLINE_VARS) {
+        many.resize(n.deps.size());
+        vals = many.data();
+    }
+    for (std::size_t i = 0; i < n.deps.size(); ++i) {
+        const Node& d = nodes[n.deps[i]];
+        if (!d.defined) {
+            n.error = "Unknown variable: " + d.name;
+            return;
+        }
+        if (!d.error.empty()) {
+            n.error = d.error;
+            return;
+        }
+        vals[i] = d.value;
+    }
+    try {
+        n.value = n.prog.eval(vals);
+    } catch (const std::exception& e) {
+        n.error = e.what();
+    }
+}
+
+std::size_t CalcSheet::recompute_from(int id) {
+    // affected subgraph: id and everything downstream of it
+    ++epoch;
+    std::vector<int> affected{id};
+    nodes[id].mark = epoch;
+    for (std::size_t i = 0; i < affected.size(); ++i) {
+        for (int d : nodes[affected[i]].dependents) {
+            if (nodes[d].mark == epoch) continue;
+            nodes[d].mark = epoch;
+            affected.push_back(d);
+        }
+    }
+    for (int a : affected) {
+        Node& n = nodes[a];
+        n.pendingDeps = 0;
+        for (int d : n.deps)
+            if (nodes[d].mark == epoch) ++n.pendingDeps;
+    }
+
+    // Kahn's algorithm, one topological level at a time
+    std::vector<int> level{id}, next;
+    while (!level.empty()) {
+        if (level.size() >= PARALLEL_MIN_LEVEL && std::thread::hardware_concurrency() > 1) {
+            if (!pool) pool = std::make_unique<ThreadPool>();
+            for (std::size_t b = 0; b < level.size(); b += PARALLEL_CHUNK) {
+                std::size_t e = std::min(level.size(), b + PARALLEL_CHUNK);
+                pool->submit([this, &level, b, e] {
+                    for (std::size_t i = b; i < e; ++i) compute(nodes[level[i]]);
+                });
+            }
+            pool->wait();
+        } else {
+            for (int n : level) compute(nodes[n]);
+        }
+
+        next.clear();
+        for (int n : level)
+            for (int d : nodes[n].dependents)
+                if (nodes[d].mark == epoch && --nodes[d].pendingDeps == 0) next.push_back(d);
+        level.swap(next);
+    }
+
+    recomputed = affected.size();
+    return recomputed;
+}
+
+bool CalcSheet::has(const std::string& name) const {
+    auto it = ids.find(name);
+    return it != ids.end() && nodes[it->second].defined;
+}
+
+double CalcSheet::value(const std::string& name) const {
+    auto it = ids.find(name);
+    if (it == ids.end() || !nodes[it->second].defined) throw std::runtime_error("Unknown variable: " + name);
+    const Node& n = nodes[it->second];
+    if (!n.error.empty()) throw std::runtime_error(n.error);
+    return n.value;
+}
+
+bool CalcSheet::lookup(const std::string& name, double& out) const {
+    auto it = ids.find(name);
+    if (it == ids.end()) return false;
+    const Node& n = nodes[it->second];
+    if (!n.defined || !n.error.empty()) return false;
+    out = n.value;
+    return true;
+}
+
+std::vector<CalcSheet::Cell> CalcSheet::cells() const {
+    std::vector<Cell> out;
+    for (const Node& n : nodes)
+        if (n.defined) out.push_back({n.name, n.formula, n.value, n.error});
+    std::sort(out.begin(), out.end(), [](const Cell& a, const Cell& b) { return a.name < b.name; });
+    return out;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "CalcProgram.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+/*
+ CalcSheet - 相互引用的具名公式（类似电子表格）
+ - 每个名字是一个单元：公式编译一次，引用的变量就是它的依赖
+ - 修改一个单元只重算它下游的单元（按拓扑层次），其余单元不动
+ - 同一层互不依赖的单元较多时并行计算
+ - 定义会形成环时拒绝修改并抛出异常
+ - 引用未定义的名字或计算出错的单元，错误沿依赖向下游传递
+*/
+class CalcSheet {
+public:
+    CalcSheet();
+    ~CalcSheet();
+
+    // defines or redefines a cell; returns the number of cells recomputed.
+    // throws on parse errors or cycles, leaving the sheet unchanged
+    std::size_t define(const std::string& name, const std::string& expr);
+    std::size_t setValue(const std::string& name, double value);
+
+    bool has(const std::string& name) const;
+    // value of a defined cell; throws the cell's error or "Unknown variable: name"
+    double value(const std::string& name) const;
+    // non-throwing lookup for evaluation; false if undefined or in error
+    bool lookup(const std::string& name, double& out) const;
+
+    struct Cell {
+        std::string name;
+        std::string formula;
+        double value;
+        std::string error; // empty when value is valid
+    };
+    std::vector<Cell> cells() const; // defined cells, sorted by name
+
+    std::size_t lastRecomputed() const { return recomputed; }
+
+private:
+    struct Node {
+        std::string name;
+        std::string formula;
+        CalcProgram prog;
+        std::vector<int> deps;       // node per program variable slot
+        std::vector<int> dependents; // nodes whose formula references this one
+        bool defined = false;
+        double value = 0.0;
+        std::string error;
+        // scratch for recomputation and cycle checks, valid when mark == epoch
+        unsigned mark = 0;
+        int pendingDeps = 0;
+        int parent = -1; // check_cycle: the node it was reached from
+    };
+
+    int node_id(const std::string& name);
+    std::size_t install(const std::string& name, CalcProgram prog, const std::string& formula);
+    void check_cycle(int id, const std::vector<int>& deps);
+    std::size_t recompute_from(int id);
+    void compute(Node& n);
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, int> ids;
+    unsigned epoch = 0;
+    std::size_t recomputed = 0;
+    std::unique_ptr<ThreadPool> pool; // created on first wide level
+};
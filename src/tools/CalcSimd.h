@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+
+/*
+ CalcSimd - 按列批量计算用的向量内核
+ - 每个内核处理 n 个连续的 double，输出可以与输入重叠（逐元素原地计算）
+ - 带定义域检查的内核返回 false 表示出现错误（除零、负数开方、非正数取对数），
+   由调用方抛出与标量路径相同的异常
+ - sin/cos/ln/log 是多项式近似（误差在几个 ulp 内），超出范围的元素回退到标量 libm
+*/
+struct CalcKernels {
+    const char* name;
+    void (*add)(const double* a, const double* b, double* out, std::size_t n);
+    void (*sub)(const double* a, const double* b, double* out, std::size_t n);
+    void (*mul)(const double* a, const double* b, double* out, std::size_t n);
+    bool (*div)(const double* a, const double* b, double* out, std::size_t n);
+    void (*neg)(const double* x, double* out, std::size_t n);
+    void (*abs)(const double* x, double* out, std::size_t n);
+    bool (*sqrt)(const double* x, double* out, std::size_t n);
+    void (*sin)(const double* x, double* out, std::size_t n);
+    void (*cos)(const double* x, double* out, std::size_t n);
+    bool (*ln)(const double* x, double* out, std::size_t n);
+    bool (*log10)(const double* x, double* out, std::size_t n);
+    // out = x * mul + add (unit conversion)
+    void (*affine)(const double* x, double mul, double add, double* out, std::size_t n);
+};
+
+const CalcKernels& calcScalarKernels();
+#ifdef SUITE_X86_SIMD
+const CalcKernels& calcSse2Kernels();
+const CalcKernels& calcAvx2Kernels();
+#endif
+
+// best kernel set for the running CPU (see cpuSimdLevel)
+const CalcKernels& calcKernels();
@@ -0,0 +1,50 @@
+// Compiled with -mavx2 (no -mfma, see CMakeLists.txt); only called after runtime CPU detection.
+#include <immintrin.h>
+#include "CalcSimdKernels.inl"
+
+namespace {
+
+struct Avx2 {
+    using V = __m256d;
+    static constexpr std::size_t W = 4;
+
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static V and_(V a, V b) { return _mm256_and_pd(a, b); }
+    static V or_(V a, V b) { return _mm256_or_pd(a, b); }
+    static V xor_(V a, V b) { return _mm256_xor_pd(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_pd(a, b); }
+    static V cmplt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static V cmple(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static V cmpge(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static V cmpeq(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static bool any(V m) { return _mm256_movemask_pd(m) != 0; }
+    static bool all(V m) { return _mm256_movemask_pd(m) == 0xF; }
+    static V select(V m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    // valid for |x| < 2^31
+    static V trunc(V x) { return _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+    // biased exponent of a positive normal double, as a double
+    static V exponent(V x) {
+        __m256i e = _mm256_srli_epi64(_mm256_castpd_si256(x), 52);
+        __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL); // 2^52
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(e, magic)), _mm256_set1_pd(4503599627370496.0));
+    }
+    // mantissa scaled to [0.5, 1)
+    static V mantissa(V x) {
+        __m256i m = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm256_castsi256_pd(_mm256_or_si256(m, _mm256_set1_epi64x(0x3FE0000000000000LL)));
+    }
+};
+
+} // namespace
+
+const CalcKernels& calcAvx2Kernels() {
+    static const CalcKernels k = VecKernels<Avx2>::table("avx2");
+    return k;
+}
@@ -0,0 +1,218 @@
+// Shared vector kernel templates for CalcSimd*.cpp.
+// Each including translation unit provides a traits struct S (SSE2, AVX2...) and is
+// compiled with the matching target flags; everything here has internal linkage so
+// code built for different instruction sets never gets merged by the linker.
+#include "CalcSimd.h"
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+// Cephes sin/cos: reduction by pi/4 in three parts and minimax polynomials on [0, pi/4]
+constexpr double FOPI = 1.27323954473516268615; // 4/pi
+constexpr double DP1 = 7.85398125648498535156E-1;
+constexpr double DP2 = 3.77489470793079817668E-8;
+constexpr double DP3 = 2.69515142907905952645E-15;
+constexpr double TRIG_LIMIT = 1.0e8; // larger arguments lose precision in the reduction
+constexpr double SINCOF[] = {
+    1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+    -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1,
+};
+constexpr double COSCOF[] = {
+    -1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+    2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2,
+};
+
+// Cephes log: log(1+x) = x - x^2/2 + x^3 P(x)/Q(x) on [sqrt(1/2)-1, sqrt(2)-1]
+constexpr double SQRTH = 0.70710678118654752440;
+constexpr double LOG_P[] = {
+    1.01875663804580931796E-4, 4.97494994976747001425E-1, 4.70579119878881725854E0,
+    1.44989225341610930846E1, 1.79368678507819816313E1, 7.70838733755885391666E0,
+};
+constexpr double LOG_Q[] = { // leading coefficient 1 omitted
+    1.12873587189167450590E1, 4.52279145837532221105E1, 8.29875266912776603211E1,
+    7.11544750618563894466E1, 2.31251620126765340583E1,
+};
+constexpr double LN2_HI = 0.693359375;
+constexpr double LN2_LO = -2.121944400546905827679e-4;
+constexpr double LOG10_E = 0.43429448190325182765;
+
+template <class S>
+struct VecKernels {
+    using V = typename S::V;
+    static constexpr std::size_t W = S::W;
+
+    static V polevl(V x, const double* c, int n) {
+        V r = S::set1(c[0]);
+        for (int i = 1; i <= n; ++i) r = S::add(S::mul(r, x), S::set1(c[i]));
+        return r;
+    }
+    static V p1evl(V x, const double* c, int n) {
+        V r = S::add(x, S::set1(c[0]));
+        for (int i = 1; i < n; ++i) r = S::add(S::mul(r, x), S::set1(c[i]));
+        return r;
+    }
+
+    static void add(const double* a, const double* b, double* out, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+        for (; i < n; ++i) out[i] = a[i] + b[i];
+    }
+    static void sub(const double* a, const double* b, double* out, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::sub(S::load(a + i), S::load(b + i)));
+        for (; i < n; ++i) out[i] = a[i] - b[i];
+    }
+    static void mul(const double* a, const double* b, double* out, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::mul(S::load(a + i), S::load(b + i)));
+        for (; i < n; ++i) out[i] = a[i] * b[i];
+    }
+    static bool div(const double* a, const double* b, double* out, std::size_t n) {
+        const V zero = S::set1(0.0);
+        V bad = zero;
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V vb = S::load(b + i);
+            bad = S::or_(bad, S::cmpeq(vb, zero));
+            S::store(out + i, S::div(S::load(a + i), vb));
+        }
+        bool ok = !S::any(bad);
+        for (; i < n; ++i) {
+            if (b[i] == 0.0) ok = false;
+            out[i] = a[i] / b[i];
+        }
+        return ok;
+    }
+    static void neg(const double* x, double* out, std::size_t n) {
+        const V sign = S::set1(-0.0);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::xor_(S::load(x + i), sign));
+        for (; i < n; ++i) out[i] = -x[i];
+    }
+    static void abs(const double* x, double* out, std::size_t n) {
+        const V sign = S::set1(-0.0);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::andnot(sign, S::load(x + i)));
+        for (; i < n; ++i) out[i] = std::fabs(x[i]);
+    }
+    static bool sqrt(const double* x, double* out, std::size_t n) {
+        const V zero = S::set1(0.0);
+        V bad = zero;
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V v = S::load(x + i);
+            bad = S::or_(bad, S::cmplt(v, zero));
+            S::store(out + i, S::sqrt(v));
+        }
+        bool ok = !S::any(bad);
+        for (; i < n; ++i) {
+            if (x[i] < 0) ok = false;
+            out[i] = std::sqrt(x[i]);
+        }
+        return ok;
+    }
+
+    // shared reduction for sin/cos; returns the polynomial for the octant and its sign
+    template <bool Cos>
+    static V sincos(V x) {
+        const V signmask = S::set1(-0.0);
+        V ax = S::andnot(signmask, x);
+        V sign = Cos ? S::set1(0.0) : S::and_(x, signmask);
+
+        V j = S::trunc(S::mul(ax, S::set1(FOPI)));
+        // map zeros to origin: j odd -> j + 1
+        V odd = S::sub(j, S::mul(S::set1(2.0), S::trunc(S::mul(j, S::set1(0.5)))));
+        j = S::add(j, odd);
+        V y = j;
+        V q = S::sub(j, S::mul(S::set1(8.0), S::trunc(S::mul(j, S::set1(0.125))))); // 0,2,4,6
+        V hi = S::cmpge(q, S::set1(4.0));
+        sign = S::xor_(sign, S::and_(hi, signmask));
+        q = S::select(hi, S::sub(q, S::set1(4.0)), q); // 0 or 2
+        V q2 = S::cmpeq(q, S::set1(2.0));
+        if (Cos) sign = S::xor_(sign, S::and_(q2, signmask));
+
+        V z = S::sub(S::sub(S::sub(ax, S::mul(y, S::set1(DP1))), S::mul(y, S::set1(DP2))), S::mul(y, S::set1(DP3)));
+        V zz = S::mul(z, z);
+        V ps = S::add(z, S::mul(z, S::mul(zz, polevl(zz, SINCOF, 5))));
+        V pc = S::add(S::sub(S::set1(1.0), S::mul(S::set1(0.5), zz)), S::mul(S::mul(zz, zz), polevl(zz, COSCOF, 5)));
+        V r = Cos ? S::select(q2, ps, pc) : S::select(q2, pc, ps);
+        return S::xor_(r, sign);
+    }
+
+    template <bool Cos>
+    static void trig(const double* x, double* out, std::size_t n) {
+        const V limit = S::set1(TRIG_LIMIT);
+        const V signmask = S::set1(-0.0);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V v = S::load(x + i);
+            // !(|x| <= limit) also catches NaN
+            V in_range = S::cmple(S::andnot(signmask, v), limit);
+            if (S::all(in_range)) {
+                S::store(out + i, sincos<Cos>(v));
+            } else {
+                for (std::size_t k = i; k < i + W; ++k) out[k] = Cos ? std::cos(x[k]) : std::sin(x[k]);
+            }
+        }
+        for (; i < n; ++i) out[i] = Cos ? std::cos(x[i]) : std::sin(x[i]);
+    }
+    static void sin(const double* x, double* out, std::size_t n) { trig<false>(x, out, n); }
+    static void cos(const double* x, double* out, std::size_t n) { trig<true>(x, out, n); }
+
+    // natural log for positive normal x
+    static V ln_normal(V x) {
+        V e = S::sub(S::exponent(x), S::set1(1022.0));
+        V m = S::mantissa(x); // [0.5, 1)
+        V small = S::cmplt(m, S::set1(SQRTH));
+        e = S::select(small, S::sub(e, S::set1(1.0)), e);
+        V t = S::select(small, S::sub(S::add(m, m), S::set1(1.0)), S::sub(m, S::set1(1.0)));
+        V z = S::mul(t, t);
+        V y = S::mul(t, S::div(S::mul(z, polevl(t, LOG_P, 5)), p1evl(t, LOG_Q, 5)));
+        y = S::add(y, S::mul(e, S::set1(LN2_LO)));
+        y = S::sub(y, S::mul(S::set1(0.5), z));
+        V r = S::add(t, y);
+        return S::add(r, S::mul(e, S::set1(LN2_HI)));
+    }
+
+    template <bool Log10>
+    static bool log(const double* x, double* out, std::size_t n) {
+        const V zero = S::set1(0.0);
+        const V lo = S::set1(DBL_MIN), hi = S::set1(DBL_MAX);
+        V bad = zero;
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V v = S::load(x + i);
+            bad = S::or_(bad, S::cmple(v, zero));
+            V normal = S::and_(S::cmpge(v, lo), S::cmple(v, hi));
+            if (S::all(normal)) {
+                V r = ln_normal(v);
+                S::store(out + i, Log10 ? S::mul(r, S::set1(LOG10_E)) : r);
+            } else {
+                for (std::size_t k = i; k < i + W; ++k) out[k] = Log10 ? std::log10(x[k]) : std::log(x[k]);
+            }
+        }
+        bool ok = !S::any(bad);
+        for (; i < n; ++i) {
+            if (x[i] <= 0) ok = false;
+            out[i] = Log10 ? std::log10(x[i]) : std::log(x[i]);
+        }
+        return ok;
+    }
+    static bool ln(const double* x, double* out, std::size_t n) { return log<false>(x, out, n); }
+    static bool log10(const double* x, double* out, std::size_t n) { return log<true>(x, out, n); }
+
+    static void affine(const double* x, double m, double a, double* out, std::size_t n) {
+        const V vm = S::set1(m), va = S::set1(a);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) S::store(out + i, S::add(S::mul(S::load(x + i), vm), va));
+        for (; i < n; ++i) out[i] = x[i] * m + a;
+    }
+
+    static CalcKernels table(const char* name) {
+        return {name, add, sub, mul, div, neg, abs, sqrt, sin, cos, ln, log10, affine};
+    }
+};
+
+} // namespace
@@ -0,0 +1,49 @@
+#include <emmintrin.h>
+#include "CalcSimdKernels.inl"
+
+namespace {
+
+struct Sse2 {
+    using V = __m128d;
+    static constexpr std::size_t W = 2;
+
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V set1(double x) { return _mm_set1_pd(x); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm_div_pd(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_pd(a); }
+    static V and_(V a, V b) { return _mm_and_pd(a, b); }
+    static V or_(V a, V b) { return _mm_or_pd(a, b); }
+    static V xor_(V a, V b) { return _mm_xor_pd(a, b); }
+    static V andnot(V a, V b) { return _mm_andnot_pd(a, b); }
+    static V cmplt(V a, V b) { return _mm_cmplt_pd(a, b); }
+    static V cmple(V a, V b) { return _mm_cmple_pd(a, b); }
+    static V cmpge(V a, V b) { return _mm_cmpge_pd(a, b); }
+    static V cmpeq(V a, V b) { return _mm_cmpeq_pd(a, b); }
+    static bool any(V m) { return _mm_movemask_pd(m) != 0; }
+    static bool all(V m) { return _mm_movemask_pd(m) == 0x3; }
+    static V select(V m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    // valid for |x| < 2^31
+    static V trunc(V x) { return _mm_cvtepi32_pd(_mm_cvttpd_epi32(x)); }
+    // biased exponent of a positive normal double, as a double
+    static V exponent(V x) {
+        __m128i e = _mm_srli_epi64(_mm_castpd_si128(x), 52);
+        __m128i magic = _mm_set1_epi64x(0x4330000000000000LL); // 2^52
+        return _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(e, magic)), _mm_set1_pd(4503599627370496.0));
+    }
+    // mantissa scaled to [0.5, 1)
+    static V mantissa(V x) {
+        __m128i m = _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm_castsi128_pd(_mm_or_si128(m, _mm_set1_epi64x(0x3FE0000000000000LL)));
+    }
+};
+
+} // namespace
+
+const CalcKernels& calcSse2Kernels() {
+    static const CalcKernels k = VecKernels<Sse2>::table("sse2");
+    return k;
+}
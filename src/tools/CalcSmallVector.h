@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ CalcSmallVector - 前 N 个元素存放在对象内部的栈式容器，超出后才转到堆上
+ - 用于解析和优化过程中的 token、节点等小型可平凡复制类型
+ - 常见大小的表达式因此不需要任何堆分配
+*/
+template <class T, std::size_t N>
+class CalcSmallVector {
+public:
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T* data() { return heap.empty() ? local : heap.data(); }
+    const T* data() const { return heap.empty() ? local : heap.data(); }
+    T* begin() { return data(); }
+    T* end() { return data() + count; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + count; }
+
+    T& operator[](std::size_t i) { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    T& back() { return data()[count - 1]; }
+    const T& back() const { return data()[count - 1]; }
+
+    void push_back(const T& v) {
+        if (heap.empty() && count < N) {
+            local[count++] = v;
+            return;
+        }
+        if (heap.empty()) heap.assign(local, local + count); // spill once
+        heap.push_back(v);
+        ++count;
+    }
+    void assign(std::size_t n, const T& v) {
+        heap.clear();
+        count = 0;
+        if (n > N) heap.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) push_back(v);
+    }
+    void pop_back() {
+        --count;
+        if (!heap.empty()) heap.pop_back();
+    }
+
+private:
+    T local[N];
+    std::vector<T> heap;
+    std::size_t count = 0;
+};
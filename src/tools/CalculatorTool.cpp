@@ -1,233 +1,230 @@
 #include "CalculatorTool.h"
+#include "CalcBatch.h"
+#include "CalcBigFloat.h"
+#include "CalcEval.h"
+#include "CalcRational.h"
+#include "Metrics.h"
+#include "ThreadPool.h"
+#include <charconv>
 #include <iostream>
 #include <sstream>
-#include <stack>
-#include <vector>
 #include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <chrono>
 #include <cctype>
 #include <cmath>
+#include <cstdio>
 #include <stdexcept>
-#include <unordered_map>
-#include <functional>
-#include <limits>
 
 /*
  Implementation details:
- - Tokenizer produces numbers, identifiers (functions), operators, parentheses.
- - Uses Shunting-Yard to produce RPN.
- - Evaluates RPN.
- - Throws runtime_error on malformed expressions.
+ - Parsing and bytecode generation live in CalcProgram.
+ - evalExpr looks the expression up in the LRU cache, compiling it on a miss,
+   then binds variable slots from the formula sheet.
+ - evalBatch runs the same bytecode column-wise (CalcBatch).
+ - evalFormatted in the exact modes compiles without optimization (literals are re-read
+   from the source text) and runs calcEvaluate with the rational or big-float backend;
+   variables enter through the shortest decimal form of their double value.
+ - execute() evaluates in the current mode against the sheet without changing either; the
+   double path uses the per-thread program cache, so concurrent requests never share one.
+   The interactive loop handles definitions and the session commands itself and passes
+   every other line to execute().
+ - runBatch reads chunks of lines, evaluates them on a work-stealing pool with
+   per-thread program caches and writes the chunks back in input order.
 */
 
 namespace {
 
-enum TokenType { T_NUMBER, T_OP, T_LPAREN, T_RPAREN, T_IDENT };
-
-struct Token {
-    TokenType type;
-    std::string text; // for number: textual form; for op/ident: symbol/name
-    double value{};   // when type == T_NUMBER
-};
-
-std::vector<Token> tokenize(const std::string& s) {
-    std::vector<Token> out;
-    size_t i = 0;
-    while (i < s.size()) {
-        char c = s[i];
-        if (std::isspace((unsigned char)c)) { ++i; continue; }
-
-        if (std::isdigit((unsigned char)c) || c == '.') {
-            size_t j = i;
-            while (j < s.size() && (std::isdigit((unsigned char)s[j]) || s[j] == '.')) ++j;
-            std::string num = s.substr(i, j - i);
-            Token t; t.type = T_NUMBER; t.text = num;
-            try {
-                t.value = std::stod(num);
-            } catch (...) { throw std::runtime_error("Invalid number: " + num); }
-            out.push_back(std::move(t));
-            i = j;
-            continue;
-        }
-
-        if (std::isalpha((unsigned char)c)) {
-            size_t j = i;
-            while (j < s.size() && std::isalpha((unsigned char)s[j])) ++j;
-            std::string id = s.substr(i, j - i);
-            Token t; t.type = T_IDENT; t.text = id;
-            out.push_back(std::move(t));
-            i = j;
-            continue;
-        }
+std::string_view trim(std::string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace((unsigned char)s[b])) ++b;
+    while (e > b && std::isspace((unsigned char)s[e-1])) --e;
+    return s.substr(b, e - b);
+}
 
-        // operators and parentheses
-        if (c == '+' || c == '-' || c == '*' || c == '/' || c == '^') {
-            Token t; t.type = T_OP; t.text = std::string(1, c);
-            out.push_back(std::move(t));
-            ++i;
-            continue;
-        }
+bool is_variable_name(const std::string& s) {
+    if (s.empty() || s == "neg" || findCalcBuiltin(s)) return false;
+    for (char c : s)
+        if (!std::isalpha((unsigned char)c) && c != '_') return false;
+    return true;
+}
 
-        if (c == '(') { out.push_back({T_LPAREN, "("}); ++i; continue; }
-        if (c == ')') { out.push_back({T_RPAREN, ")"}); ++i; continue; }
+constexpr size_t BATCH_CHUNK_LINES = 4096;
+// digits of the approximation printed next to a non-terminating fraction
+constexpr size_t APPROX_DIGITS = 20;
+constexpr size_t MAX_BIG_DIGITS = 10000;
 
-        throw std::runtime_error(std::string("Unknown character: ") + c);
-    }
-    return out;
+// print with good precision; if integer-like show without decimal; returns the length
+size_t format_result(double res, char (&buf)[64]) {
+    int n;
+    if (std::fabs(res - std::round(res)) < 1e-12) n = std::snprintf(buf, sizeof buf, "%lld", (long long)std::llround(res));
+    else n = std::snprintf(buf, sizeof buf, "%g", res);
+    return (size_t)n;
 }
 
-int precedence(const std::string& op) {
-    if (op == "^") return 4;
-    if (op == "*" || op == "/") return 3;
-    if (op == "+" || op == "-") return 2;
-    return 0;
-}
+// evaluation takes ~100 ns, so only one call in 64 is timed
+MetricTimer& METRIC_EVAL = metricTimer("suite_calc_eval", "Calculator: RPN bytecode evaluation", "", 64);
+MetricTimer& METRIC_BATCH = metricTimer("suite_calc_batch", "Calculator: column-wise batch evaluation");
 
-// right associative?
-bool is_right_associative(const std::string& op) {
-    return op == "^";
+CalcProgramCache& worker_cache() {
+    thread_local CalcProgramCache cache;
+    return cache;
 }
 
-double apply_binary(const std::string& op, double a, double b) {
-    if (op == "+") return a + b;
-    if (op == "-") return a - b;
-    if (op == "*") return a * b;
-    if (op == "/") {
-        if (b == 0.0) throw std::runtime_error("Division by zero");
-        return a / b;
-    }
-    if (op == "^") return std::pow(a, b);
-    throw std::runtime_error("Unknown binary op: " + op);
-}
+// binds variable slots through lookup(name), which throws for unknown names
+template <class Lookup>
+double eval_bound(const CalcProgram& prog, Lookup&& lookup) {
+    MetricScope m(METRIC_EVAL);
+    if (prog.vars.empty()) return prog.eval();
 
-double apply_function(const std::string& name, double v) {
-    static const std::unordered_map<std::string, std::function<double(double)>> funcs = {
-        {"sin", [](double x){ return std::sin(x); }},
-        {"cos", [](double x){ return std::cos(x); }},
-        {"tan", [](double x){ return std::tan(x); }},
-        {"sqrt", [](double x){ if (x < 0) throw std::runtime_error("sqrt of negative"); return std::sqrt(x); }},
-        {"abs",  [](double x){ return std::fabs(x); }},
-        {"log",  [](double x){ if (x <= 0) throw std::runtime_error("log of non-positive"); return std::log10(x); }},
-        {"ln",   [](double x){ if (x <= 0) throw std::runtime_error("ln of non-positive"); return std::log(x); }}
-    };
-    auto it = funcs.find(name);
-    if (it == funcs.end()) throw std::runtime_error("Unknown function: " + name);
-    return it->second(v);
+    constexpr size_t INLINE_VARS = 16;
+    double inline_vals[INLINE_VARS];
+    std::vector<double> many;
+    double* vals = inline_vals;
+    if (prog.vars.size() > INLINE_VARS) {
+        many.resize(prog.vars.size());
+        vals = many.data();
+    }
+    for (size_t i = 0; i < prog.vars.size(); ++i) vals[i] = lookup(prog.vars[i]);
+    return prog.eval(vals);
 }
 
 } // namespace
 
+std::string CalculatorTool::formatResult(double res) {
+    char buf[64];
+    return std::string(buf, format_result(res, buf));
+}
+
 double CalculatorTool::evalExpr(const std::string& expr) {
-    auto tokens = tokenize(expr);
-    // Shunting-yard -> output queue (as tokens)
-    std::vector<Token> output;
-    std::vector<Token> ops; // operator stack (store tokens for ops and funcs and paren)
-    // We need to handle unary minus: when '-' appears at start or after '(' or another operator -> unary
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        Token t = tokens[i];
-        if (t.type == T_NUMBER) {
-            output.push_back(t);
-        } else if (t.type == T_IDENT) {
-            // function identifier -> push to ops
-            ops.push_back(t);
-        } else if (t.type == T_OP) {
-            std::string op = t.text;
-            // handle unary minus: represent as "u-" and handle as function (unary negation)
-            bool is_unary = false;
-            if (op == "-") {
-                if (i == 0) is_unary = true;
-                else {
-                    Token prev = tokens[i-1];
-                    if (prev.type == T_OP || prev.type == T_LPAREN) is_unary = true;
-                    if (prev.type == T_IDENT) {
-                        // e.g., sin -2 (should be treated as binary? usually unary)
-                    }
-                }
-            }
-            if (is_unary) {
-                // treat as function "neg"
-                ops.push_back({T_IDENT, "neg"});
-                continue;
-            }
+    return eval_bound(cache.get(expr), [this](const std::string& n) { return sheet.value(n); });
+}
 
-            while (!ops.empty()) {
-                Token top = ops.back();
-                if (top.type == T_IDENT) {
-                    // functions have higher precedence; pop to output
-                    output.push_back(top);
-                    ops.pop_back();
-                } else if (top.type == T_OP) {
-                    std::string topop = top.text;
-                    if ((is_right_associative(op) && precedence(op) < precedence(topop)) ||
-                        (!is_right_associative(op) && precedence(op) <= precedence(topop))) {
-                        output.push_back(top);
-                        ops.pop_back();
-                    } else break;
-                } else break;
-            }
-            ops.push_back(t);
-        } else if (t.type == T_LPAREN) {
-            ops.push_back(t);
-        } else if (t.type == T_RPAREN) {
-            bool foundLeft = false;
-            while (!ops.empty()) {
-                Token top = ops.back();
-                ops.pop_back();
-                if (top.type == T_LPAREN) { foundLeft = true; break; }
-                output.push_back(top);
-            }
-            if (!foundLeft) throw std::runtime_error("Mismatched parentheses");
-            // if function on top of ops, pop it to output
-            if (!ops.empty() && ops.back().type == T_IDENT) {
-                output.push_back(ops.back());
-                ops.pop_back();
-            }
+std::string CalculatorTool::evalFormatted(const std::string& expr, NumberMode m, std::size_t digits) {
+    if (m == NumberMode::Double) return formatResult(evalExpr(expr));
+
+    CalcProgram prog = CalcProgram::compile(expr, false);
+    if (m == NumberMode::Exact) {
+        std::vector<CalcRational> vals;
+        vals.reserve(prog.vars.size());
+        for (const auto& v : prog.vars) vals.push_back(CalcRational::fromDouble(sheet.value(v)));
+        CalcRational r = calcEvaluate(prog, vals.data(), CalcRationalOps{expr});
+        std::string s;
+        if (r.toDecimal(&s)) return s;
+        CalcBigFloat approx = CalcBigFloat::fromRational(r, CalcBigFloat::bitsForDigits(APPROX_DIGITS));
+        return r.toString() + " ≈ " + approx.toString(APPROX_DIGITS);
+    }
+
+    size_t bits = CalcBigFloat::bitsForDigits(digits);
+    std::vector<CalcBigFloat> vals;
+    vals.reserve(prog.vars.size());
+    for (const auto& v : prog.vars)
+        vals.push_back(CalcBigFloat::fromRational(CalcRational::fromDouble(sheet.value(v)), bits));
+    return calcEvaluate(prog, vals.data(), CalcBigFloatOps{expr, bits}).toString(digits);
+}
+
+void CalculatorTool::evalBatch(const std::string& expr,
+                               const std::unordered_map<std::string, const double*>& columns,
+                               std::size_t rows, double* out) {
+    const CalcProgram& prog = cache.get(expr);
+    std::vector<CalcColumn> cols(prog.vars.size());
+    for (size_t i = 0; i < prog.vars.size(); ++i) {
+        auto c = columns.find(prog.vars[i]);
+        if (c != columns.end()) {
+            cols[i].data = c->second;
+            continue;
         }
+        cols[i].scalar = sheet.value(prog.vars[i]);
     }
+    MetricScope m(METRIC_BATCH);
+    evalCalcBatch(prog, cols.data(), rows, out);
+}
 
-    while (!ops.empty()) {
-        Token top = ops.back();
-        ops.pop_back();
-        if (top.type == T_LPAREN || top.type == T_RPAREN) throw std::runtime_error("Mismatched parentheses");
-        output.push_back(top);
+void CalculatorTool::setVariable(const std::string& name, double value) {
+    if (!is_variable_name(name)) throw std::runtime_error("Invalid variable name: " + name);
+    sheet.setValue(name, value);
+}
+
+void CalculatorTool::execute(const ToolArgs& args, ToolOutput& out) {
+    std::string_view expr = trim(args.text());
+    if (expr.find('=') != std::string_view::npos) throw std::runtime_error("Variables cannot be defined in requests");
+    if (mode != NumberMode::Double) {
+        out << evalFormatted(std::string(expr), mode, bigDigits) << '\n';
+        return;
     }
+    double res = eval_bound(worker_cache().get(expr), [this](const std::string& n) { return sheet.value(n); });
+    char buf[64];
+    out << std::string_view(buf, format_result(res, buf)) << '\n';
+}
+
+CalculatorTool::BatchStats CalculatorTool::runBatch(std::istream& in, std::ostream& out, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    // read-only snapshot of the sheet for the workers
+    std::unordered_map<std::string, double> vars;
+    for (const auto& c : sheet.cells())
+        if (c.error.empty()) vars.emplace(c.name, c.value);
+    auto lookup = [&vars](const std::string& n) {
+        auto it = vars.find(n);
+        if (it == vars.end()) throw std::runtime_error("Unknown variable: " + n);
+        return it->second;
+    };
+
+    // bounded number of chunks in flight keeps memory flat on arbitrarily long inputs
+    const size_t max_in_flight = (size_t)pool.size() * 4;
+    std::deque<std::future<std::string>> in_flight;
+    auto write_oldest = [&] {
+        std::string res = in_flight.front().get();
+        out.write(res.data(), (std::streamsize)res.size());
+        in_flight.pop_front();
+    };
+
+    BatchStats stats;
+    stats.threads = pool.size();
+    std::string line;
+    while (true) {
+        std::vector<std::string> chunk;
+        chunk.reserve(BATCH_CHUNK_LINES);
+        while (chunk.size() < BATCH_CHUNK_LINES && std::getline(in, line)) chunk.push_back(line);
+        if (chunk.empty()) break;
+        stats.lines += chunk.size();
 
-    // Evaluate RPN
-    std::stack<double> st;
-    for (auto &tk : output) {
-        if (tk.type == T_NUMBER) st.push(tk.value);
-        else if (tk.type == T_OP) {
-            if (st.size() < 2) throw std::runtime_error("Invalid expression (binary op)");
-            double b = st.top(); st.pop();
-            double a = st.top(); st.pop();
-            st.push(apply_binary(tk.text, a, b));
-        } else if (tk.type == T_IDENT) {
-            // either function like sin, or unary neg "neg"
-            if (tk.text == "neg") {
-                if (st.empty()) throw std::runtime_error("Invalid expression (neg)");
-                double v = st.top(); st.pop();
-                st.push(-v);
-            } else {
-                if (st.empty()) throw std::runtime_error("Invalid expression (func)");
-                double v = st.top(); st.pop();
-                st.push(apply_function(tk.text, v));
+        in_flight.push_back(pool.async([chunk = std::move(chunk), &lookup] {
+            CalcProgramCache& cache = worker_cache();
+            std::string res;
+            res.reserve(chunk.size() * 16);
+            for (const std::string& expr : chunk) {
+                // empty lines stay empty so output lines match input lines
+                if (!expr.empty()) {
+                    try {
+                        res += formatResult(eval_bound(cache.get(expr), lookup));
+                    } catch (const std::exception& e) {
+                        res += "错误: ";
+                        res += e.what();
+                    }
+                }
+                res.push_back('\n');
             }
-        } else {
-            throw std::runtime_error("Unexpected token in RPN eval");
-        }
+            return res;
+        }));
+        if (in_flight.size() >= max_in_flight) write_oldest();
     }
+    while (!in_flight.empty()) write_oldest();
+    out.flush();
 
-    if (st.empty()) throw std::runtime_error("Empty expression");
-    double result = st.top(); st.pop();
-    if (!st.empty()) throw std::runtime_error("Invalid expression (extra values)");
-    return result;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
 }
 
 void CalculatorTool::run() {
     std::cout << "\n=== Calculator ===\n";
     std::cout << "支持运算：+ - * / ^ 以及函数 sin cos tan sqrt log ln abs\n";
-    std::cout << "示例: 3+4*2/(1-5)^2  或 sin(3.14/2)  或 -2^2\n";
-    std::cout << "命令: help, quit\n";
+    std::cout << "示例: 3+4*2/(1-5)^2  或 sin(3.14/2)  或 -2^2  或 r = 2 后 3.14*r^2\n";
+    std::cout << "命令: help, vars, stats, mode, quit\n";
 
+    ToolOutput out;
     while (true) {
         std::cout << "> ";
         std::string line;
@@ -236,16 +233,78 @@ void CalculatorTool::run() {
         if (line == "quit") break;
         if (line == "help") {
             std::cout << "输入表达式后回车计算。支持: + - * / ^, 函数: sin cos tan sqrt log ln abs\n";
+            std::cout << "name = expr: 定义公式（可引用其他变量，依赖变化时自动重算）; vars: 列出变量\n";
+            std::cout << "stats: 显示编译缓存命中/未命中次数和 JIT 编译数\n";
+            std::cout << "mode double | mode exact | mode big [位数]: 切换数值模式（double / 精确有理数 / 高精度）\n";
+            continue;
+        }
+        if (line == "mode" || line.rfind("mode ", 0) == 0) {
+            std::istringstream args(line.substr(4));
+            std::string which;
+            args >> which;
+            if (which == "double") mode = NumberMode::Double;
+            else if (which == "exact") mode = NumberMode::Exact;
+            else if (which == "big") {
+                // no argument keeps the current precision; anything else must be a number in range
+                size_t digits = bigDigits;
+                std::string arg;
+                if (args >> arg) {
+                    const char* end = arg.data() + arg.size();
+                    auto [p, ec] = std::from_chars(arg.data(), end, digits);
+                    if (ec != std::errc() || p != end || digits == 0 || digits > MAX_BIG_DIGITS) {
+                        std::cout << "错误: 位数必须在 1 到 " << MAX_BIG_DIGITS << " 之间\n";
+                        continue;
+                    }
+                }
+                mode = NumberMode::Big;
+                bigDigits = digits;
+            } else if (!which.empty()) {
+                std::cout << "错误: 未知模式 " << which << "（可选 double, exact, big）\n";
+                continue;
+            }
+            std::cout << "当前模式: ";
+            if (mode == NumberMode::Double) std::cout << "double\n";
+            else if (mode == NumberMode::Exact) std::cout << "exact（精确有理数）\n";
+            else std::cout << "big（" << bigDigits << " 位有效数字）\n";
+            continue;
+        }
+        if (line == "vars") {
+            auto cells = sheet.cells();
+            if (cells.empty()) std::cout << "(没有变量)\n";
+            for (auto& c : cells) {
+                std::cout << c.name << " = ";
+                if (c.error.empty()) std::cout << formatResult(c.value);
+                else std::cout << "错误: " << c.error;
+                std::cout << "    [" << c.formula << "]\n";
+            }
+            continue;
+        }
+        if (line == "stats") {
+            const CalcProgramCache& cache = worker_cache();
+            std::cout << "缓存: " << cache.size() << "/" << cache.capacity()
+                      << " 条, 命中 " << cache.hits() << ", 未命中 " << cache.misses()
+                      << ", JIT 编译 " << cache.jitCompiled() << " 条\n";
             continue;
         }
         try {
-            double res = evalExpr(line);
-            // print with good precision; if integer-like show without decimal?
-            if (std::fabs(res - std::round(res)) < 1e-12) std::cout << (long long)std::llround(res) << "\n";
-            else std::cout << res << "\n";
+            size_t eq = line.find('=');
+            if (eq != std::string::npos) {
+                std::string target(trim(std::string_view(line).substr(0, eq)));
+                if (!is_variable_name(target)) throw std::runtime_error("Invalid variable name: " + target);
+                // the formula is kept even if it cannot be evaluated yet
+                size_t n = sheet.define(target, std::string(trim(std::string_view(line).substr(eq + 1))));
+                double res = sheet.value(target);
+                std::cout << target << " = " << formatResult(res);
+                if (n > 1) std::cout << "  (重算了 " << n - 1 << " 个依赖公式)";
+                std::cout << "\n";
+                continue;
+            }
         } catch (const std::exception& e) {
             std::cout << "错误: " << e.what() << "\n";
+            continue;
         }
+        out.clear();
+        respond(ToolArgs(line), out, "错误: ");
+        std::cout << out.view();
     }
 }
-
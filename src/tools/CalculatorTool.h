@@ -1,23 +1,71 @@
 #pragma once
 #include "Tool.h"
+#include "CalcCache.h"
+#include "CalcSheet.h"
+#include <cstddef>
+#include <iosfwd>
 #include <string>
+#include <unordered_map>
 
 /*
  CalculatorTool - enhanced version
  - 支持自动分词（无需空格）
  - 支持 + - * / ^、括号、函数（sin cos tan log ln sqrt abs）
  - 支持一元负号
- - 支持命令: help, quit
+ - 支持变量：name = expr 定义公式，表达式中直接引用 name；
+   公式之间的依赖关系会被记录，修改一个变量只重算依赖它的公式（CalcSheet）
+ - 表达式编译为字节码后缓存（LRU），重复计算不再解析
+ - evalBatch: 按列批量计算（SIMD 内核）
+ - runBatch: 非交互批处理，每行一个表达式，多线程计算并按输入顺序输出
+ - 数值模式（mode 命令）：double（默认）、exact（精确有理数）、big N（N 位有效数字的高精度浮点）；
+   三种模式共用同一个模板求值器（CalcEval.h），公式变量仍按 double 保存
+ - 支持命令: help, vars, stats, mode, quit
 */
 class CalculatorTool : public Tool {
 public:
     std::string name() const override { return "Calculator"; }
-    std::string description() const override { return "Expression calculator (+ - * / ^, funcs: sin cos tan log ln sqrt abs)"; }
+    static constexpr const char* DESCRIPTION = "Expression calculator (+ - * / ^, funcs: sin cos tan log ln sqrt abs)";
+    std::string description() const override { return DESCRIPTION; }
     void run() override;
+    // one expression in the current mode, reading the sheet's variables; "name = expr" is
+    // rejected (definitions and mode changes belong to the interactive loop)
+    void execute(const ToolArgs& args, ToolOutput& out) override;
 
-private:
     double evalExpr(const std::string& expr);
 
-    // helper: convert infix -> RPN (tokens), then eval RPN
-};
+    enum class NumberMode { Double, Exact, Big };
+
+    // evaluates expr in the given mode and formats the result: Double as formatResult,
+    // Exact as an exact decimal or fraction, Big with `digits` significant digits
+    std::string evalFormatted(const std::string& expr, NumberMode mode, std::size_t digits = 50);
+
+    // evaluates expr for `rows` rows; columns maps variable names to arrays of `rows` values,
+    // variables without a column use their current value in the sheet
+    void evalBatch(const std::string& expr,
+                   const std::unordered_map<std::string, const double*>& columns,
+                   std::size_t rows, double* out);
+
+    void setVariable(const std::string& name, double value);
 
+    struct BatchStats {
+        std::size_t lines = 0;
+        double seconds = 0.0;
+        unsigned threads = 0;
+    };
+
+    // one expression per line -> one result (or error) per line, in input order;
+    // threads == 0 uses all cores
+    BatchStats runBatch(std::istream& in, std::ostream& out, unsigned threads = 0);
+
+    // same formatting as the interactive loop: integer-like values without decimals
+    static std::string formatResult(double value);
+
+private:
+    // compiled programs keyed by expression text
+    CalcProgramCache cache;
+    // named formulas and their current values
+    CalcSheet sheet;
+    // numeric backend of the interactive loop
+    NumberMode mode = NumberMode::Double;
+    std::size_t bigDigits = 50;
+};
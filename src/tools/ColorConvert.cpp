@@ -0,0 +1,496 @@
+#include "ColorConvert.h"
+#include "ColorSimdKernels.inl"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+/*
+ Implementation details:
+ - Forward conversions work on blocks of 256 pixels: the 8-bit channels are gathered from
+   their planes through a 256-entry table (v / 255, or the decoded sRGB value for Lab), the
+   kernel runs over the block rounded up to COLOR_KERNEL_PAD, and the results are scattered
+   to the output planes. The per-thread block buffers are zero-initialized, so the padding
+   lanes never hold garbage that could raise floating point exceptions.
+ - The scalar kernels are the ColorSimdKernels.inl templates instantiated with plain floats,
+   so every kernel level performs the same operations in the same order.
+ - Inverse conversions are scalar doubles: they are not on any bulk path of the tool, and
+   rounding back to 8 bits hides the cost.
+ - Work is split into tiles of 64K pixels; with threads > 1 each tile becomes a ThreadPool
+   task. Tiles touch disjoint output ranges, so no synchronization is needed beyond wait().
+ - The palette k-d tree is stored implicitly: the node of the range [lo, hi) sits at
+   (lo + hi) / 2 after sorting that range on the axis with the largest spread. A search
+   descends into the near half first and visits the far half only if the splitting plane
+   is within the best distance so far. Equal distances prefer the lower palette index, so
+   results do not depend on tree shape.
+ - The tree descent is branchy (about 20 nodes for the CSS palette, most of them
+   mispredicted), so palettes up to ColorKernels::nearestScanMax colors are matched by the
+   `nearest` kernel instead: a compare-and-select scan over every color, vectorized across
+   pixels. Both give the same index, since distances are computed with the same operations
+   and ties go to the lower index either way.
+ - Bulk lookups keep a 4096-entry direct-mapped cache of rgb -> index per tile. Real images
+   repeat colors heavily; only cache misses go through the Lab kernel and the tree.
+*/
+
+namespace {
+
+constexpr std::size_t BLOCK = 256;    // pixels per kernel call
+constexpr std::size_t TILE = 1 << 16; // pixels per thread task
+constexpr std::size_t CACHE_BITS = 12;
+
+static_assert(BLOCK % COLOR_KERNEL_PAD == 0, "blocks must be padded");
+
+// ---- scalar fallback kernels ----
+
+struct Scalar {
+    using V = float;
+    static constexpr std::size_t W = 1;
+
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V set1(float x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    // same operand order as minps / maxps
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static bool cmpeq(V a, V b) { return a == b; }
+    static bool cmplt(V a, V b) { return a < b; }
+    static bool cmpgt(V a, V b) { return a > b; }
+    static V select(bool m, V a, V b) { return m ? a : b; }
+    static V cbrtSeed(V x) {
+        std::int32_t bits;
+        std::memcpy(&bits, &x, sizeof bits);
+        std::int32_t seed = (std::int32_t)((float)bits * (1.0f / 3.0f) + 709921077.0f);
+        float y;
+        std::memcpy(&y, &seed, sizeof y);
+        return y;
+    }
+};
+
+// ---- 8-bit <-> float ----
+
+struct GammaTables {
+    float unit[256];   // v / 255
+    float linear[256]; // sRGB-decoded v / 255
+
+    GammaTables() {
+        for (int v = 0; v < 256; ++v) {
+            double c = v / 255.0;
+            unit[v] = (float)c;
+            linear[v] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+    }
+};
+
+const GammaTables& gammaTables() {
+    static const GammaTables t;
+    return t;
+}
+
+std::uint8_t to8(double x) {
+    x = std::min(1.0, std::max(0.0, x));
+    return (std::uint8_t)(x * 255.0 + 0.5);
+}
+
+double srgbEncode(double l) {
+    return l <= 0.0031308 ? 12.92 * l : 1.055 * std::pow(l, 1 / 2.4) - 0.055;
+}
+
+struct BlockBuffers {
+    alignas(32) float in[3][BLOCK] = {};
+    alignas(32) float out[3][BLOCK] = {};
+};
+
+// gathers pixels [begin, begin + m) into bufs.in through `lut`
+void gather(const Rgb8In& in, std::size_t begin, std::size_t m, const float* lut, BlockBuffers& bufs) {
+    for (int ch = 0; ch < 3; ++ch) {
+        const std::uint8_t* p = in.c[ch] + begin * in.step;
+        float* d = bufs.in[ch];
+        for (std::size_t i = 0; i < m; ++i) d[i] = lut[p[i * in.step]];
+    }
+}
+
+std::size_t padded(std::size_t m) { return (m + COLOR_KERNEL_PAD - 1) / COLOR_KERNEL_PAD * COLOR_KERNEL_PAD; }
+
+template <class F>
+void forTiles(std::size_t n, unsigned threads, F&& fn) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t tiles = (n + TILE - 1) / TILE;
+    if (threads <= 1 || tiles <= 1) {
+        fn(std::size_t(0), n);
+        return;
+    }
+    ThreadPool pool((unsigned)std::min<std::size_t>(threads, tiles));
+    for (std::size_t b = 0; b < n; b += TILE) {
+        std::size_t e = std::min(n, b + TILE);
+        pool.submit([&fn, b, e] { fn(b, e); });
+    }
+    pool.wait();
+}
+
+void forwardRange(ColorSpace space, const Rgb8In& in, const Float3Out& out, std::size_t begin, std::size_t end,
+                  const ColorKernels& k) {
+    thread_local BlockBuffers bufs;
+    const GammaTables& g = gammaTables();
+    const float* lut = space == ColorSpace::Lab ? g.linear : g.unit;
+    auto kernel = space == ColorSpace::Hsv ? k.rgbToHsv : space == ColorSpace::Hsl ? k.rgbToHsl : k.linearToLab;
+
+    for (std::size_t b = begin; b < end; b += BLOCK) {
+        std::size_t m = std::min(BLOCK, end - b);
+        gather(in, b, m, lut, bufs);
+        kernel(bufs.in[0], bufs.in[1], bufs.in[2], bufs.out[0], bufs.out[1], bufs.out[2], padded(m));
+        for (int ch = 0; ch < 3; ++ch) {
+            float* p = out.c[ch] + b * out.step;
+            for (std::size_t i = 0; i < m; ++i) p[i * out.step] = bufs.out[ch][i];
+        }
+    }
+}
+
+// ---- inverse conversions ----
+
+// chroma c spread over the hue sector, plus m
+void hueToRgb(double h, double c, double m, std::uint8_t rgb[3]) {
+    h = std::fmod(h, 360.0);
+    if (h < 0) h += 360.0;
+    double hp = h / 60.0;
+    double x = c * (1 - std::fabs(std::fmod(hp, 2.0) - 1));
+    double r = 0, g = 0, b = 0;
+    switch (std::min(5, (int)hp)) {
+    case 0: r = c, g = x; break;
+    case 1: r = x, g = c; break;
+    case 2: g = c, b = x; break;
+    case 3: g = x, b = c; break;
+    case 4: r = x, b = c; break;
+    default: r = c, b = x; break;
+    }
+    rgb[0] = to8(r + m);
+    rgb[1] = to8(g + m);
+    rgb[2] = to8(b + m);
+}
+
+double labInv(double t) {
+    constexpr double d = 6.0 / 29.0;
+    return t > d ? t * t * t : 3 * d * d * (t - 4.0 / 29.0);
+}
+
+void labToRgb(double L, double a, double b, std::uint8_t rgb[3]) {
+    double fy = (L + 16) / 116;
+    double x = 0.95047 * labInv(fy + a / 500), y = labInv(fy), z = 1.08883 * labInv(fy - b / 200);
+    double lr = 3.2404542 * x - 1.5371385 * y - 0.4985314 * z;
+    double lg = -0.9692660 * x + 1.8760108 * y + 0.0415560 * z;
+    double lb = 0.0556434 * x - 0.2040259 * y + 1.0572252 * z;
+    rgb[0] = to8(srgbEncode(std::max(0.0, lr)));
+    rgb[1] = to8(srgbEncode(std::max(0.0, lg)));
+    rgb[2] = to8(srgbEncode(std::max(0.0, lb)));
+}
+
+void inverseRange(ColorSpace space, const Float3In& in, const Rgb8Out& out, std::size_t begin, std::size_t end) {
+    std::uint8_t rgb[3];
+    for (std::size_t i = begin; i < end; ++i) {
+        double x = in.c[0][i * in.step], y = in.c[1][i * in.step], z = in.c[2][i * in.step];
+        switch (space) {
+        case ColorSpace::Hsv:
+            hueToRgb(x, z * y, z - z * y, rgb);
+            break;
+        case ColorSpace::Hsl: {
+            double c = (1 - std::fabs(2 * z - 1)) * y;
+            hueToRgb(x, c, z - c / 2, rgb);
+            break;
+        }
+        case ColorSpace::Lab:
+            labToRgb(x, y, z, rgb);
+            break;
+        }
+        for (int ch = 0; ch < 3; ++ch) out.c[ch][i * out.step] = rgb[ch];
+    }
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)std::tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i])) return false;
+    return true;
+}
+
+float dist2(const float a[3], const float b[3]) {
+    float d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+struct CssColor {
+    const char* name;
+    std::uint32_t rgb;
+};
+
+constexpr CssColor CSS_COLORS[] = {
+    {"aliceblue", 0xF0F8FF}, {"antiquewhite", 0xFAEBD7}, {"aqua", 0x00FFFF}, {"aquamarine", 0x7FFFD4},
+    {"azure", 0xF0FFFF}, {"beige", 0xF5F5DC}, {"bisque", 0xFFE4C4}, {"black", 0x000000},
+    {"blanchedalmond", 0xFFEBCD}, {"blue", 0x0000FF}, {"blueviolet", 0x8A2BE2}, {"brown", 0xA52A2A},
+    {"burlywood", 0xDEB887}, {"cadetblue", 0x5F9EA0}, {"chartreuse", 0x7FFF00}, {"chocolate", 0xD2691E},
+    {"coral", 0xFF7F50}, {"cornflowerblue", 0x6495ED}, {"cornsilk", 0xFFF8DC}, {"crimson", 0xDC143C},
+    {"cyan", 0x00FFFF}, {"darkblue", 0x00008B}, {"darkcyan", 0x008B8B}, {"darkgoldenrod", 0xB8860B},
+    {"darkgray", 0xA9A9A9}, {"darkgreen", 0x006400}, {"darkgrey", 0xA9A9A9}, {"darkkhaki", 0xBDB76B},
+    {"darkmagenta", 0x8B008B}, {"darkolivegreen", 0x556B2F}, {"darkorange", 0xFF8C00}, {"darkorchid", 0x9932CC},
+    {"darkred", 0x8B0000}, {"darksalmon", 0xE9967A}, {"darkseagreen", 0x8FBC8F}, {"darkslateblue", 0x483D8B},
+    {"darkslategray", 0x2F4F4F}, {"darkslategrey", 0x2F4F4F}, {"darkturquoise", 0x00CED1}, {"darkviolet", 0x9400D3},
+    {"deeppink", 0xFF1493}, {"deepskyblue", 0x00BFFF}, {"dimgray", 0x696969}, {"dimgrey", 0x696969},
+    {"dodgerblue", 0x1E90FF}, {"firebrick", 0xB22222}, {"floralwhite", 0xFFFAF0}, {"forestgreen", 0x228B22},
+    {"fuchsia", 0xFF00FF}, {"gainsboro", 0xDCDCDC}, {"ghostwhite", 0xF8F8FF}, {"gold", 0xFFD700},
+    {"goldenrod", 0xDAA520}, {"gray", 0x808080}, {"green", 0x008000}, {"greenyellow", 0xADFF2F},
+    {"grey", 0x808080}, {"honeydew", 0xF0FFF0}, {"hotpink", 0xFF69B4}, {"indianred", 0xCD5C5C},
+    {"indigo", 0x4B0082}, {"ivory", 0xFFFFF0}, {"khaki", 0xF0E68C}, {"lavender", 0xE6E6FA},
+    {"lavenderblush", 0xFFF0F5}, {"lawngreen", 0x7CFC00}, {"lemonchiffon", 0xFFFACD}, {"lightblue", 0xADD8E6},
+    {"lightcoral", 0xF08080}, {"lightcyan", 0xE0FFFF}, {"lightgoldenrodyellow", 0xFAFAD2}, {"lightgray", 0xD3D3D3},
+    {"lightgreen", 0x90EE90}, {"lightgrey", 0xD3D3D3}, {"lightpink", 0xFFB6C1}, {"lightsalmon", 0xFFA07A},
+    {"lightseagreen", 0x20B2AA}, {"lightskyblue", 0x87CEFA}, {"lightslategray", 0x778899}, {"lightslategrey", 0x778899},
+    {"lightsteelblue", 0xB0C4DE}, {"lightyellow", 0xFFFFE0}, {"lime", 0x00FF00}, {"limegreen", 0x32CD32},
+    {"linen", 0xFAF0E6}, {"magenta", 0xFF00FF}, {"maroon", 0x800000}, {"mediumaquamarine", 0x66CDAA},
+    {"mediumblue", 0x0000CD}, {"mediumorchid", 0xBA55D3}, {"mediumpurple", 0x9370DB}, {"mediumseagreen", 0x3CB371},
+    {"mediumslateblue", 0x7B68EE}, {"mediumspringgreen", 0x00FA9A}, {"mediumturquoise", 0x48D1CC}, {"mediumvioletred", 0xC71585},
+    {"midnightblue", 0x191970}, {"mintcream", 0xF5FFFA}, {"mistyrose", 0xFFE4E1}, {"moccasin", 0xFFE4B5},
+    {"navajowhite", 0xFFDEAD}, {"navy", 0x000080}, {"oldlace", 0xFDF5E6}, {"olive", 0x808000},
+    {"olivedrab", 0x6B8E23}, {"orange", 0xFFA500}, {"orangered", 0xFF4500}, {"orchid", 0xDA70D6},
+    {"palegoldenrod", 0xEEE8AA}, {"palegreen", 0x98FB98}, {"paleturquoise", 0xAFEEEE}, {"palevioletred", 0xDB7093},
+    {"papayawhip", 0xFFEFD5}, {"peachpuff", 0xFFDAB9}, {"peru", 0xCD853F}, {"pink", 0xFFC0CB},
+    {"plum", 0xDDA0DD}, {"powderblue", 0xB0E0E6}, {"purple", 0x800080}, {"rebeccapurple", 0x663399},
+    {"red", 0xFF0000}, {"rosybrown", 0xBC8F8F}, {"royalblue", 0x4169E1}, {"saddlebrown", 0x8B4513},
+    {"salmon", 0xFA8072}, {"sandybrown", 0xF4A460}, {"seagreen", 0x2E8B57}, {"seashell", 0xFFF5EE},
+    {"sienna", 0xA0522D}, {"silver", 0xC0C0C0}, {"skyblue", 0x87CEEB}, {"slateblue", 0x6A5ACD},
+    {"slategray", 0x708090}, {"slategrey", 0x708090}, {"snow", 0xFFFAFA}, {"springgreen", 0x00FF7F},
+    {"steelblue", 0x4682B4}, {"tan", 0xD2B48C}, {"teal", 0x008080}, {"thistle", 0xD8BFD8},
+    {"tomato", 0xFF6347}, {"turquoise", 0x40E0D0}, {"violet", 0xEE82EE}, {"wheat", 0xF5DEB3},
+    {"white", 0xFFFFFF}, {"whitesmoke", 0xF5F5F5}, {"yellow", 0xFFFF00}, {"yellowgreen", 0x9ACD32},
+};
+
+} // namespace
+
+const ColorKernels& colorScalarKernels() {
+    static const ColorKernels k = ColorVecKernels<Scalar>::table("scalar", 128);
+    return k;
+}
+
+const ColorKernels& colorKernels() {
+    static const ColorKernels& k = [] () -> const ColorKernels& {
+#ifdef SUITE_X86_SIMD
+        SimdLevel level = cpuSimdLevel();
+        if (level >= SimdLevel::Avx2) return colorAvx2Kernels();
+        if (level >= SimdLevel::Sse2) return colorSse2Kernels();
+#endif
+        return colorScalarKernels();
+    }();
+    return k;
+}
+
+void rgbToColorSpace(ColorSpace space, const Rgb8In& in, const Float3Out& out, std::size_t n,
+                     const ColorConvertOptions& opt) {
+    const ColorKernels& k = opt.kernels ? *opt.kernels : colorKernels();
+    forTiles(n, opt.threads, [&](std::size_t b, std::size_t e) { forwardRange(space, in, out, b, e, k); });
+}
+
+void colorSpaceToRgb(ColorSpace space, const Float3In& in, const Rgb8Out& out, std::size_t n,
+                     const ColorConvertOptions& opt) {
+    forTiles(n, opt.threads, [&](std::size_t b, std::size_t e) { inverseRange(space, in, out, b, e); });
+}
+
+void rgbToHex(const Rgb8In& in, char* out, std::size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    for (std::size_t i = 0; i < n; ++i, out += 7) {
+        out[0] = '#';
+        for (int ch = 0; ch < 3; ++ch) {
+            std::uint8_t v = in.c[ch][i * in.step];
+            out[1 + 2 * ch] = digits[v >> 4];
+            out[2 + 2 * ch] = digits[v & 15];
+        }
+    }
+}
+
+bool parseHexColor(std::string_view text, std::uint8_t rgb[3]) {
+    if (!text.empty() && text[0] == '#') text.remove_prefix(1);
+    if (text.size() != 6 && text.size() != 3) return false;
+    int d[6];
+    for (std::size_t i = 0; i < text.size(); ++i)
+        if ((d[i] = hexDigit(text[i])) < 0) return false;
+    for (int ch = 0; ch < 3; ++ch)
+        rgb[ch] = (std::uint8_t)(text.size() == 6 ? d[2 * ch] * 16 + d[2 * ch + 1] : d[ch] * 17);
+    return true;
+}
+
+ColorPalette::ColorPalette(std::vector<NamedColor> list) : colors(std::move(list)) {
+    if (colors.empty()) throw std::runtime_error("Empty color palette");
+    if (colors.size() > 0xFFFF) throw std::runtime_error("Color palette too large");
+
+    std::size_t n = colors.size(), np = padded(n);
+    std::vector<float> rgb(3 * np, 0.0f), lab(3 * np);
+    const float* lin = gammaTables().linear;
+    for (std::size_t i = 0; i < n; ++i)
+        for (int ch = 0; ch < 3; ++ch) rgb[ch * np + i] = lin[colors[i].rgb[ch]];
+    colorKernels().linearToLab(&rgb[0], &rgb[np], &rgb[2 * np], &lab[0], &lab[np], &lab[2 * np], np);
+
+    labs.resize(3 * n);
+    for (std::size_t i = 0; i < n; ++i)
+        for (int a = 0; a < 3; ++a) labs[3 * i + a] = lab[a * np + i];
+
+    tree.resize(n);
+    for (std::size_t i = 0; i < n; ++i) tree[i] = {{labs[3 * i], labs[3 * i + 1], labs[3 * i + 2]}, (std::uint16_t)i, 0};
+    build(0, n);
+}
+
+void ColorPalette::build(std::size_t lo, std::size_t hi) {
+    if (hi - lo <= 1) return;
+    float mn[3] = {tree[lo].lab[0], tree[lo].lab[1], tree[lo].lab[2]}, mx[3] = {mn[0], mn[1], mn[2]};
+    for (std::size_t i = lo + 1; i < hi; ++i)
+        for (int a = 0; a < 3; ++a) {
+            mn[a] = std::min(mn[a], tree[i].lab[a]);
+            mx[a] = std::max(mx[a], tree[i].lab[a]);
+        }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+        if (mx[a] - mn[a] > mx[axis] - mn[axis]) axis = a;
+
+    std::size_t mid = (lo + hi) / 2;
+    std::nth_element(tree.begin() + lo, tree.begin() + mid, tree.begin() + hi,
+                     [axis](const Node& x, const Node& y) { return x.lab[axis] < y.lab[axis]; });
+    tree[mid].axis = (std::uint8_t)axis;
+    build(lo, mid);
+    build(mid + 1, hi);
+}
+
+void ColorPalette::search(const float q[3], std::size_t lo, std::size_t hi, float& best, std::size_t& bestIndex) const {
+    if (lo >= hi) return;
+    std::size_t mid = (lo + hi) / 2;
+    const Node& node = tree[mid];
+    float d = dist2(q, node.lab);
+    if (d < best || (d == best && node.index < bestIndex)) {
+        best = d;
+        bestIndex = node.index;
+    }
+    float diff = q[node.axis] - node.lab[node.axis];
+    if (diff < 0) {
+        search(q, lo, mid, best, bestIndex);
+        if (diff * diff <= best) search(q, mid + 1, hi, best, bestIndex);
+    } else {
+        search(q, mid + 1, hi, best, bestIndex);
+        if (diff * diff <= best) search(q, lo, mid, best, bestIndex);
+    }
+}
+
+void ColorPalette::lookup(const float* L, const float* A, const float* B, std::size_t n, const ColorKernels& k,
+                          float* index, float* dist2) const {
+    if (colors.size() <= k.nearestScanMax) {
+        k.nearest(L, A, B, labs.data(), colors.size(), index, dist2, n);
+        return;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        float q[3] = {L[i], A[i], B[i]}, best = std::numeric_limits<float>::infinity();
+        std::size_t found = 0;
+        search(q, 0, tree.size(), best, found);
+        index[i] = (float)found;
+        dist2[i] = best;
+    }
+}
+
+const NamedColor* ColorPalette::find(std::string_view name) const {
+    for (const NamedColor& c : colors)
+        if (equalsIgnoreCase(c.name, name)) return &c;
+    return nullptr;
+}
+
+std::size_t ColorPalette::nearest(const std::uint8_t rgb[3], float* deltaE) const {
+    alignas(32) float in[3][COLOR_KERNEL_PAD] = {}, lab[3][COLOR_KERNEL_PAD];
+    const ColorKernels& k = colorKernels();
+    const float* lin = gammaTables().linear;
+    for (int ch = 0; ch < 3; ++ch) in[ch][0] = lin[rgb[ch]];
+    k.linearToLab(in[0], in[1], in[2], lab[0], lab[1], lab[2], COLOR_KERNEL_PAD);
+
+    // one query leaves the scan kernel's lanes empty; the tree gives the same answer sooner
+    float q[3] = {lab[0][0], lab[1][0], lab[2][0]}, best = std::numeric_limits<float>::infinity();
+    std::size_t index = 0;
+    search(q, 0, tree.size(), best, index);
+    if (deltaE) *deltaE = std::sqrt(best);
+    return index;
+}
+
+void ColorPalette::nearestRange(const Rgb8In& in, std::uint16_t* index, std::size_t begin, std::size_t end,
+                                const ColorKernels& k, std::vector<std::uint64_t>& cache) const {
+    thread_local BlockBuffers bufs;
+    std::size_t miss[BLOCK];
+    const float* lin = gammaTables().linear;
+    auto keyAt = [&](std::size_t i) {
+        std::size_t p = i * in.step;
+        return std::uint64_t(1) << 24 | in.c[0][p] << 16 | in.c[1][p] << 8 | in.c[2][p];
+    };
+    auto slot = [&](std::uint64_t key) -> std::uint64_t& {
+        return cache[((std::uint32_t)key * 2654435761u) >> (32 - CACHE_BITS)];
+    };
+
+    for (std::size_t b = begin; b < end; b += BLOCK) {
+        std::size_t m = std::min(BLOCK, end - b), misses = 0;
+        for (std::size_t i = 0; i < m; ++i) {
+            std::uint64_t key = keyAt(b + i), e = slot(key);
+            if (e >> 16 == key) {
+                index[b - begin + i] = (std::uint16_t)e;
+                continue;
+            }
+            for (int ch = 0; ch < 3; ++ch) bufs.in[ch][misses] = lin[in.c[ch][(b + i) * in.step]];
+            miss[misses++] = i;
+        }
+        if (misses == 0) continue;
+
+        k.linearToLab(bufs.in[0], bufs.in[1], bufs.in[2], bufs.out[0], bufs.out[1], bufs.out[2], padded(misses));
+        // the linear values are not needed anymore: bufs.in[0] takes the indexes
+        lookup(bufs.out[0], bufs.out[1], bufs.out[2], padded(misses), k, bufs.in[0], bufs.in[1]);
+        for (std::size_t j = 0; j < misses; ++j) {
+            std::size_t found = (std::size_t)bufs.in[0][j];
+            std::uint64_t key = keyAt(b + miss[j]);
+            slot(key) = key << 16 | found;
+            index[b - begin + miss[j]] = (std::uint16_t)found;
+        }
+    }
+}
+
+void ColorPalette::nearest(const Rgb8In& in, std::uint16_t* index, std::size_t n, const ColorConvertOptions& opt) const {
+    const ColorKernels& k = opt.kernels ? *opt.kernels : colorKernels();
+    forTiles(n, opt.threads, [&](std::size_t b, std::size_t e) {
+        std::vector<std::uint64_t> cache(std::size_t(1) << CACHE_BITS, 0);
+        nearestRange(in, index + b, b, e, k, cache);
+    });
+}
+
+void ColorPalette::quantize(const Rgb8In& in, const Rgb8Out& out, std::size_t n, const ColorConvertOptions& opt) const {
+    const ColorKernels& k = opt.kernels ? *opt.kernels : colorKernels();
+    forTiles(n, opt.threads, [&](std::size_t b, std::size_t e) {
+        std::vector<std::uint64_t> cache(std::size_t(1) << CACHE_BITS, 0);
+        std::uint16_t index[BLOCK];
+        for (std::size_t t = b; t < e; t += BLOCK) {
+            std::size_t m = std::min(BLOCK, e - t);
+            nearestRange(in, index, t, t + m, k, cache);
+            for (std::size_t i = 0; i < m; ++i)
+                for (int ch = 0; ch < 3; ++ch) out.c[ch][(t + i) * out.step] = colors[index[i]].rgb[ch];
+        }
+    });
+}
+
+const ColorPalette& cssPalette() {
+    static const ColorPalette palette = [] {
+        std::vector<NamedColor> list;
+        for (const CssColor& c : CSS_COLORS)
+            list.push_back({c.name, {(std::uint8_t)(c.rgb >> 16), (std::uint8_t)(c.rgb >> 8), (std::uint8_t)c.rgb}});
+        return ColorPalette(std::move(list));
+    }();
+    return palette;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "ColorSimd.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ ColorConvert - 8 位 RGB 像素与 HSV / HSL / Lab / 十六进制之间的批量转换，以及最近命名颜色查找
+ - ColorPlanes 描述三个通道的位置：交错存储（RGBRGB...）是 interleaved(p)，平面存储是
+   planar(r, g, b)；浮点结果同样可以交错或分平面写出
+ - RGB → HSV / HSL / Lab：按 256 像素一块拆包成 float（sRGB gamma 用 256 项查表），
+   再交给按 CPU 选择的向量内核（ColorSimd.h）；反方向是标量实现，结果四舍五入并截断到 0..255
+ - 大缓冲区按 64K 像素分片，threads > 1 时用线程池并行；threads == 0 表示每个核一个线程
+ - ColorPalette 在 Lab 空间（CIE76 色差）找最近的颜色：小调色板用向量内核逐个比较，
+   大调色板用 k-d 树；批量查找时重复出现的像素命中一个小缓存，不再重新查找。
+   cssPalette() 是 CSS 的 148 个命名颜色
+*/
+template <class T>
+struct ColorPlanes {
+    T* c[3];
+    std::size_t step; // elements between two pixels of one channel
+
+    static ColorPlanes interleaved(T* p) { return {{p, p + 1, p + 2}, 3}; }
+    static ColorPlanes planar(T* a, T* b, T* c) { return {{a, b, c}, 1}; }
+};
+
+using Rgb8In = ColorPlanes<const std::uint8_t>;
+using Rgb8Out = ColorPlanes<std::uint8_t>;
+using Float3In = ColorPlanes<const float>;
+using Float3Out = ColorPlanes<float>;
+
+enum class ColorSpace { Hsv, Hsl, Lab };
+
+struct ColorConvertOptions {
+    unsigned threads = 1;                // 0: one per core
+    const ColorKernels* kernels = nullptr; // nullptr: colorKernels()
+};
+
+// HSV / HSL as (degrees, 0..1, 0..1); Lab as (L 0..100, a, b)
+void rgbToColorSpace(ColorSpace space, const Rgb8In& in, const Float3Out& out, std::size_t n,
+                     const ColorConvertOptions& opt = {});
+void colorSpaceToRgb(ColorSpace space, const Float3In& in, const Rgb8Out& out, std::size_t n,
+                     const ColorConvertOptions& opt = {});
+
+// 7 chars per pixel ("#rrggbb"), no terminator
+void rgbToHex(const Rgb8In& in, char* out, std::size_t n);
+// "#rrggbb", "rrggbb" or "#rgb"; false if malformed
+bool parseHexColor(std::string_view text, std::uint8_t rgb[3]);
+
+struct NamedColor {
+    std::string name;
+    std::uint8_t rgb[3];
+};
+
+class ColorPalette {
+public:
+    explicit ColorPalette(std::vector<NamedColor> colors);
+
+    std::size_t size() const { return colors.size(); }
+    const NamedColor& operator[](std::size_t i) const { return colors[i]; }
+    // case-insensitive; nullptr if there is no such color
+    const NamedColor* find(std::string_view name) const;
+
+    // index of the closest color; ties go to the lower index
+    std::size_t nearest(const std::uint8_t rgb[3], float* deltaE = nullptr) const;
+    void nearest(const Rgb8In& in, std::uint16_t* index, std::size_t n, const ColorConvertOptions& opt = {}) const;
+    // every pixel replaced by its closest palette color; out may equal in
+    void quantize(const Rgb8In& in, const Rgb8Out& out, std::size_t n, const ColorConvertOptions& opt = {}) const;
+
+private:
+    struct Node {
+        float lab[3];
+        std::uint16_t index;
+        std::uint8_t axis;
+    };
+
+    std::vector<NamedColor> colors;
+    std::vector<Node> tree; // node for [lo, hi) sits at (lo + hi) / 2
+    std::vector<float> labs; // 3 per color, in palette order
+
+    void build(std::size_t lo, std::size_t hi);
+    void search(const float q[3], std::size_t lo, std::size_t hi, float& best, std::size_t& bestIndex) const;
+    // closest colors of n (padded) Lab pixels: a kernel scan for small palettes, the tree for large ones
+    void lookup(const float* L, const float* A, const float* B, std::size_t n, const ColorKernels& k,
+                float* index, float* dist2) const;
+    // index[i - begin] for pixels [begin, end); cache entries are (rgb | 1 << 24) << 16 | index
+    void nearestRange(const Rgb8In& in, std::uint16_t* index, std::size_t begin, std::size_t end,
+                      const ColorKernels& k, std::vector<std::uint64_t>& cache) const;
+};
+
+const ColorPalette& cssPalette();
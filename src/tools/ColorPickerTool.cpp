@@ -1,12 +1,120 @@
 #include "ColorPickerTool.h"
+#include "ColorConvert.h"
+#include "CpuFeatures.h"
+#include "PpmImage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// channels 0..1 as percentages, hue in degrees
+void write_hue(ToolOutput& out, const char* label, const float* v) {
+    char buf[64];
+    int n = std::snprintf(buf, sizeof buf, "%s: %.1f, %.1f%%, %.1f%%\n", label, v[0], v[1] * 100, v[2] * 100);
+    out << std::string_view(buf, (std::size_t)n);
+}
+
+} // namespace
 
 void ColorPickerTool::run() {
-    int r, g, b;
-    std::cout << "Enter RGB (0-255): ";
-    std::cin >> r >> g >> b;
-    std::cin.ignore();
+    std::cout << "Enter RGB (0-255), #rrggbb or a color name: ";
+    std::string line;
+    std::getline(std::cin, line);
+
+    ToolOutput out;
+    respond(ToolArgs(line), out, "Error: ");
+    std::cout << out.view();
+}
+
+void ColorPickerTool::execute(const ToolArgs& args, ToolOutput& out) {
+    const ColorPalette& css = cssPalette();
+    std::uint8_t rgb[3];
+    if (args.size() == 3) {
+        for (int ch = 0; ch < 3; ++ch) {
+            long long v;
+            if (!args.toInt(ch, &v) || v < 0 || v > 255) throw std::runtime_error("Expected three integers 0-255: r g b");
+            rgb[ch] = (std::uint8_t)v;
+        }
+    } else if (args.size() == 1 && !parseHexColor(args[0], rgb)) {
+        const NamedColor* named = css.find(args[0]);
+        if (!named) throw std::runtime_error("Unknown color: " + std::string(args[0]));
+        for (int ch = 0; ch < 3; ++ch) rgb[ch] = named->rgb[ch];
+    } else if (args.size() != 1) {
+        throw std::runtime_error("Expected r g b, #rrggbb or a color name");
+    }
 
-    std::cout << "Color: RGB(" << r << "," << g << "," << b << ")\n";
+    Rgb8In in = Rgb8In::interleaved(rgb);
+    float hsv[3], hsl[3], lab[3];
+    rgbToColorSpace(ColorSpace::Hsv, in, Float3Out::interleaved(hsv), 1);
+    rgbToColorSpace(ColorSpace::Hsl, in, Float3Out::interleaved(hsl), 1);
+    rgbToColorSpace(ColorSpace::Lab, in, Float3Out::interleaved(lab), 1);
+    char hex[7];
+    rgbToHex(in, hex, 1);
+    float deltaE;
+    const NamedColor& near = css[css.nearest(rgb, &deltaE)];
+
+    out << "Color: RGB(" << (int)rgb[0] << ',' << (int)rgb[1] << ',' << (int)rgb[2] << ")\n";
+    out << "Hex: " << std::string_view(hex, 7) << '\n';
+    write_hue(out, "HSV", hsv);
+    write_hue(out, "HSL", hsl);
+    char buf[96];
+    int n = std::snprintf(buf, sizeof buf, "Lab: %.2f, %.2f, %.2f\nNearest: %s (dE %.2f)\n", lab[0], lab[1], lab[2],
+                          near.name.c_str(), deltaE);
+    out << std::string_view(buf, (std::size_t)n);
 }
 
+void ColorPickerTool::benchmark(std::ostream& out, const PpmImage& image, unsigned threads) {
+    constexpr int PASSES = 4;
+    std::size_t n = image.size();
+    Rgb8In in = Rgb8In::interleaved(image.pixels.data());
+    std::vector<float> planes(n * 3);
+    Float3Out dst = Float3Out::planar(planes.data(), planes.data() + n, planes.data() + 2 * n);
+
+    std::vector<const ColorKernels*> sets = {&colorScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    SimdLevel level = cpuSimdLevel();
+    if (level >= SimdLevel::Sse2) sets.push_back(&colorSse2Kernels());
+    if (level >= SimdLevel::Avx2) sets.push_back(&colorAvx2Kernels());
+#endif
+
+    auto best_of = [&](auto&& fn) {
+        double best = 0;
+        for (int p = 0; p < PASSES; ++p) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            best = std::max(best, (double)n / dt / 1e6);
+        }
+        return best;
+    };
+
+    out << image.width << 'x' << image.height << " pixels, " << (threads ? std::to_string(threads) : "all")
+        << " threads, best of " << PASSES << " passes (MPix/s)\n";
+    for (const ColorKernels* k : sets) {
+        ColorConvertOptions opt;
+        opt.threads = threads;
+        opt.kernels = k;
+        out << "  " << std::left << std::setw(8) << k->name << std::right << std::fixed << std::setprecision(1);
+        for (ColorSpace s : {ColorSpace::Hsv, ColorSpace::Hsl, ColorSpace::Lab}) {
+            double mpix = best_of([&] { rgbToColorSpace(s, in, dst, n, opt); });
+            out << (s == ColorSpace::Hsv ? " hsv " : s == ColorSpace::Hsl ? "  hsl " : "  lab ") << mpix;
+        }
+        std::vector<std::uint16_t> index(n);
+        out << "  nearest " << best_of([&] { cssPalette().nearest(in, index.data(), n, opt); }) << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+std::size_t ColorPickerTool::quantizeFile(const std::string& in, const std::string& out, unsigned threads) {
+    PpmImage img = readPpm(in);
+    ColorConvertOptions opt;
+    opt.threads = threads;
+    cssPalette().quantize(Rgb8In::interleaved(img.pixels.data()), Rgb8Out::interleaved(img.pixels.data()), img.size(), opt);
+    writePpm(out, img);
+    return img.size();
+}
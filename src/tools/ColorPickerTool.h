@@ -1,11 +1,23 @@
 #pragma once
 #include "Tool.h"
+#include <cstddef>
 #include <iostream>
+#include <string>
+
+struct PpmImage;
 
 class ColorPickerTool : public Tool {
 public:
     std::string name() const override { return "Color Picker"; }
-    std::string description() const override { return "Pick RGB values"; }
+    static constexpr const char* DESCRIPTION = "Convert a color to hex, HSV, HSL and Lab";
+    std::string description() const override { return DESCRIPTION; }
     void run() override;
-};
+    // "r g b" (0-255), "#rrggbb" or a CSS color name -> "Color: RGB(r,g,b)", then
+    // the hex, HSV, HSL and Lab forms and the nearest CSS named color
+    void execute(const ToolArgs& args, ToolOutput& out) override;
 
+    // HSV / HSL / Lab conversion and palette matching throughput of every kernel level on `image`
+    static void benchmark(std::ostream& out, const PpmImage& image, unsigned threads);
+    // maps every pixel of a PPM to its nearest CSS named color; returns the pixel count
+    static std::size_t quantizeFile(const std::string& in, const std::string& out, unsigned threads);
+};
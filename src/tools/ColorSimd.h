@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+
+/*
+ ColorSimd - 批量颜色空间转换的向量内核
+ - 输入输出都是 float 平面（r、g、b 各一个数组），每个内核处理 n 个像素；n 会向上取整到
+   COLOR_KERNEL_PAD 的倍数，缓冲区必须有这么长。8 位像素的拆包与 sRGB gamma 查表由 ColorConvert 完成
+ - HSV / HSL：r, g, b ∈ [0, 1] → h ∈ [0, 360)，s、v / l ∈ [0, 1]
+ - Lab：线性光 r, g, b（sRGB 原色，D65 白点）→ CIE L*a*b*；立方根用位运算初值加两次牛顿迭代
+ - nearest：对每个 Lab 像素按顺序扫描整个调色板（向量化在像素方向），距离相同时取下标小的颜色；
+   适合小调色板，超过 nearestScanMax 种颜色时 ColorPalette 改用 k-d 树（这个界限随向量宽度变化）
+ - 各级内核使用相同的运算顺序（不使用 FMA），结果逐位相同
+*/
+constexpr std::size_t COLOR_KERNEL_PAD = 16; // two of the widest vectors, in floats
+
+struct ColorKernels {
+    const char* name;
+    void (*rgbToHsv)(const float* r, const float* g, const float* b, float* h, float* s, float* v, std::size_t n);
+    void (*rgbToHsl)(const float* r, const float* g, const float* b, float* h, float* s, float* l, std::size_t n);
+    void (*linearToLab)(const float* r, const float* g, const float* b, float* L, float* A, float* B, std::size_t n);
+    // palette: L, a, b of each color; writes the closest index (as a float, exact) and its squared distance
+    void (*nearest)(const float* L, const float* A, const float* B, const float* palette, std::size_t colors,
+                    float* index, float* dist2, std::size_t n);
+    std::size_t nearestScanMax; // largest palette for which `nearest` beats a k-d tree search
+};
+
+const ColorKernels& colorScalarKernels();
+#ifdef SUITE_X86_SIMD
+const ColorKernels& colorSse2Kernels();
+const ColorKernels& colorAvx2Kernels();
+#endif
+
+// best kernel set for the running CPU (see cpuSimdLevel)
+const ColorKernels& colorKernels();
@@ -0,0 +1,38 @@
+// Compiled with -mavx2 (no -mfma, so the results match the other levels); only called after
+// runtime CPU detection.
+#include <immintrin.h>
+#include "ColorSimdKernels.inl"
+
+namespace {
+
+struct Avx2 {
+    using V = __m256;
+    static constexpr std::size_t W = 8;
+
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V cmpeq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static V cmplt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V cmpgt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V select(V m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    static V cbrtSeed(V x) {
+        __m256 bits = _mm256_cvtepi32_ps(_mm256_castps_si256(x));
+        __m256i seed = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(bits, _mm256_set1_ps(1.0f / 3.0f)), _mm256_set1_ps(709921077.0f)));
+        return _mm256_castsi256_ps(seed);
+    }
+};
+
+} // namespace
+
+const ColorKernels& colorAvx2Kernels() {
+    static const ColorKernels k = ColorVecKernels<Avx2>::table("avx2", 1024);
+    return k;
+}
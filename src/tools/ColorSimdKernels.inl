@@ -0,0 +1,126 @@
+// Shared vector kernel templates for ColorSimd*.cpp and the scalar kernels in ColorConvert.cpp.
+// Each including translation unit provides a traits struct S (scalar, SSE2, AVX2) and is
+// compiled with the matching target flags; everything here has internal linkage so
+// code built for different instruction sets never gets merged by the linker.
+#include "ColorSimd.h"
+#include <cstddef>
+#include <limits>
+
+namespace {
+
+// linear sRGB -> XYZ (D65), rows divided by the white point so that white maps to (1, 1, 1)
+constexpr float LAB_M[3][3] = {
+    {0.4124564f / 0.95047f, 0.3575761f / 0.95047f, 0.1804375f / 0.95047f},
+    {0.2126729f, 0.7151522f, 0.0721750f},
+    {0.0193339f / 1.08883f, 0.1191920f / 1.08883f, 0.9503041f / 1.08883f},
+};
+constexpr float LAB_EPS = 216.0f / 24389.0f; // (6/29)^3
+constexpr float LAB_K = 24389.0f / 27.0f / 116.0f; // slope of the linear segment
+constexpr float LAB_C = 16.0f / 116.0f;
+
+template <class S>
+struct ColorVecKernels {
+    using V = typename S::V;
+    static constexpr std::size_t W = S::W;
+
+    static V lab_f(V t) {
+        // cbrt: bit-trick seed (within a few %), then two Newton steps
+        V y = S::cbrtSeed(t);
+        const V third = S::set1(1.0f / 3.0f), two = S::set1(2.0f);
+        y = S::mul(S::add(S::mul(two, y), S::div(t, S::mul(y, y))), third);
+        y = S::mul(S::add(S::mul(two, y), S::div(t, S::mul(y, y))), third);
+        V lin = S::add(S::mul(t, S::set1(LAB_K)), S::set1(LAB_C));
+        return S::select(S::cmpgt(t, S::set1(LAB_EPS)), y, lin);
+    }
+
+    // hue in degrees from the channel that is the max; 0 for grays
+    static V hue(V r, V g, V b, V mx, V d) {
+        const V zero = S::set1(0.0f);
+        auto isR = S::cmpeq(mx, r);
+        auto isG = S::cmpeq(mx, g);
+        V num = S::select(isR, S::sub(g, b), S::select(isG, S::sub(b, r), S::sub(r, g)));
+        V off = S::select(isR, zero, S::select(isG, S::set1(2.0f), S::set1(4.0f)));
+        auto gray = S::cmpeq(d, zero);
+        V h = S::mul(S::add(S::div(num, S::select(gray, S::set1(1.0f), d)), off), S::set1(60.0f));
+        h = S::select(S::cmplt(h, zero), S::add(h, S::set1(360.0f)), h);
+        h = S::select(S::cmplt(h, S::set1(360.0f)), h, zero); // -tiny + 360 rounds to 360
+        return S::select(gray, zero, h);
+    }
+
+    static void rgbToHsv(const float* r, const float* g, const float* b, float* h, float* s, float* v, std::size_t n) {
+        const V zero = S::set1(0.0f), one = S::set1(1.0f);
+        for (std::size_t i = 0; i < n; i += W) {
+            V vr = S::load(r + i), vg = S::load(g + i), vb = S::load(b + i);
+            V mx = S::max(vr, S::max(vg, vb)), mn = S::min(vr, S::min(vg, vb)), d = S::sub(mx, mn);
+            auto black = S::cmpeq(mx, zero);
+            S::store(h + i, hue(vr, vg, vb, mx, d));
+            S::store(s + i, S::select(black, zero, S::div(d, S::select(black, one, mx))));
+            S::store(v + i, mx);
+        }
+    }
+
+    static void rgbToHsl(const float* r, const float* g, const float* b, float* h, float* s, float* l, std::size_t n) {
+        const V zero = S::set1(0.0f), one = S::set1(1.0f);
+        for (std::size_t i = 0; i < n; i += W) {
+            V vr = S::load(r + i), vg = S::load(g + i), vb = S::load(b + i);
+            V mx = S::max(vr, S::max(vg, vb)), mn = S::min(vr, S::min(vg, vb)), d = S::sub(mx, mn);
+            V sum = S::add(mx, mn), t = S::sub(sum, one);
+            V den = S::sub(one, S::max(t, S::sub(zero, t))); // 1 - |2l - 1|
+            auto gray = S::cmpeq(d, zero);
+            S::store(h + i, hue(vr, vg, vb, mx, d));
+            S::store(s + i, S::select(gray, zero, S::div(d, S::select(gray, one, den))));
+            S::store(l + i, S::mul(sum, S::set1(0.5f)));
+        }
+    }
+
+    static void linearToLab(const float* r, const float* g, const float* b, float* L, float* A, float* B, std::size_t n) {
+        for (std::size_t i = 0; i < n; i += W) {
+            V vr = S::load(r + i), vg = S::load(g + i), vb = S::load(b + i);
+            V f[3];
+            for (int row = 0; row < 3; ++row)
+                f[row] = lab_f(S::add(S::add(S::mul(vr, S::set1(LAB_M[row][0])), S::mul(vg, S::set1(LAB_M[row][1]))),
+                                      S::mul(vb, S::set1(LAB_M[row][2]))));
+            S::store(L + i, S::sub(S::mul(f[1], S::set1(116.0f)), S::set1(16.0f)));
+            S::store(A + i, S::mul(S::sub(f[0], f[1]), S::set1(500.0f)));
+            S::store(B + i, S::mul(S::sub(f[1], f[2]), S::set1(200.0f)));
+        }
+    }
+
+    // two independent pixel vectors per pass over the palette: the compare / select chain of
+    // one vector is latency-bound, the second one fills the gaps
+    static void nearest(const float* L, const float* A, const float* B, const float* palette, std::size_t colors,
+                        float* index, float* dist2, std::size_t n) {
+        const V one = S::set1(1.0f);
+        for (std::size_t i = 0; i < n; i += 2 * W) {
+            V l0 = S::load(L + i), a0 = S::load(A + i), b0 = S::load(B + i);
+            V l1 = S::load(L + i + W), a1 = S::load(A + i + W), b1 = S::load(B + i + W);
+            V best0 = S::set1(std::numeric_limits<float>::infinity()), best1 = best0;
+            V found0 = S::set1(0.0f), found1 = found0, id = found0;
+            for (std::size_t c = 0; c < colors; ++c, id = S::add(id, one)) {
+                const float* p = palette + 3 * c;
+                V pl = S::set1(p[0]), pa = S::set1(p[1]), pb = S::set1(p[2]);
+                V d0 = dist2At(l0, a0, b0, pl, pa, pb), d1 = dist2At(l1, a1, b1, pl, pa, pb);
+                auto closer0 = S::cmplt(d0, best0), closer1 = S::cmplt(d1, best1); // strict: ties keep the lower index
+                best0 = S::select(closer0, d0, best0);
+                best1 = S::select(closer1, d1, best1);
+                found0 = S::select(closer0, id, found0);
+                found1 = S::select(closer1, id, found1);
+            }
+            S::store(index + i, found0);
+            S::store(index + i + W, found1);
+            S::store(dist2 + i, best0);
+            S::store(dist2 + i + W, best1);
+        }
+    }
+
+    static V dist2At(V l, V a, V b, V pl, V pa, V pb) {
+        V d0 = S::sub(l, pl), d1 = S::sub(a, pa), d2 = S::sub(b, pb);
+        return S::add(S::add(S::mul(d0, d0), S::mul(d1, d1)), S::mul(d2, d2));
+    }
+
+    static ColorKernels table(const char* name, std::size_t scanMax) {
+        return {name, rgbToHsv, rgbToHsl, linearToLab, nearest, scanMax};
+    }
+};
+
+} // namespace
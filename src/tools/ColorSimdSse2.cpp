@@ -0,0 +1,36 @@
+#include <emmintrin.h>
+#include "ColorSimdKernels.inl"
+
+namespace {
+
+struct Sse2 {
+    using V = __m128;
+    static constexpr std::size_t W = 4;
+
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V set1(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static V cmpeq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    static V cmplt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V cmpgt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V select(V m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    // bits / 3 + magic, with the division done in float (exact enough for a seed)
+    static V cbrtSeed(V x) {
+        __m128 bits = _mm_cvtepi32_ps(_mm_castps_si128(x));
+        __m128i seed = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(bits, _mm_set1_ps(1.0f / 3.0f)), _mm_set1_ps(709921077.0f)));
+        return _mm_castsi128_ps(seed);
+    }
+};
+
+} // namespace
+
+const ColorKernels& colorSse2Kernels() {
+    static const ColorKernels k = ColorVecKernels<Sse2>::table("sse2", 512);
+    return k;
+}
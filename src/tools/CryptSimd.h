@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+/*
+ CryptSimd - TextEncryptTool 的批量字节变换内核
+ - xorPattern：data[i] ^= pattern[(phase + i) % period]，pattern 是预先展开的重复密钥，
+   长度至少 period + 64 字节（period 是密钥长度的倍数且不小于 64），向量加载永远不需要回绕
+ - addByte：data[i] += delta（按 256 取模），Caesar 加密和解密（delta 取反）共用
+ - 都是原地变换，不分配内存
+*/
+struct CryptKernels {
+    const char* name;
+    void (*xorPattern)(char* data, std::size_t n, const char* pattern, std::size_t period, std::size_t phase);
+    void (*addByte)(char* data, std::size_t n, unsigned char delta);
+};
+
+const CryptKernels& cryptScalarKernels();
+#ifdef SUITE_X86_SIMD
+const CryptKernels& cryptSse2Kernels();
+const CryptKernels& cryptAvx2Kernels();
+#endif
+
+// best kernel set for the running CPU (see cpuSimdLevel)
+const CryptKernels& cryptKernels();
@@ -0,0 +1,23 @@
+// Compiled with -mavx2; only called after runtime CPU detection.
+#include <immintrin.h>
+#include "CryptSimdKernels.inl"
+
+namespace {
+
+struct Avx2 {
+    using V = __m256i;
+    static constexpr std::size_t W = 32;
+
+    static V load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(char* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V set1(unsigned char c) { return _mm256_set1_epi8((char)c); }
+    static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V add(V a, V b) { return _mm256_add_epi8(a, b); }
+};
+
+} // namespace
+
+const CryptKernels& cryptAvx2Kernels() {
+    static const CryptKernels k = CryptVecKernels<Avx2>::table("avx2");
+    return k;
+}
@@ -0,0 +1,51 @@
+// Shared byte transform templates for CryptSimd*.cpp.
+// Each including translation unit provides a traits struct S and is compiled with the
+// matching target flags; everything here has internal linkage.
+#include "CryptSimd.h"
+#include <cstddef>
+
+namespace {
+
+template <class S>
+struct CryptVecKernels {
+    using V = typename S::V;
+
+    static void xorPattern(char* d, std::size_t n, const char* pat, std::size_t period, std::size_t phase) {
+        std::size_t i = 0;
+        // four vectors per step; the pattern is readable up to period + 64 bytes
+        for (; i + 4 * S::W <= n; i += 4 * S::W) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                V v = S::xor_(S::load(d + i + k * S::W), S::load(pat + phase));
+                S::store(d + i + k * S::W, v);
+                phase += S::W;
+                if (phase >= period) phase -= period;
+            }
+        }
+        for (; i + S::W <= n; i += S::W) {
+            S::store(d + i, S::xor_(S::load(d + i), S::load(pat + phase)));
+            phase += S::W;
+            if (phase >= period) phase -= period;
+        }
+        for (; i < n; ++i) {
+            d[i] ^= pat[phase];
+            if (++phase == period) phase = 0;
+        }
+    }
+
+    static void addByte(char* d, std::size_t n, unsigned char delta) {
+        V dv = S::set1(delta);
+        std::size_t i = 0;
+        for (; i + 4 * S::W <= n; i += 4 * S::W) {
+            for (std::size_t k = 0; k < 4; ++k)
+                S::store(d + i + k * S::W, S::add(S::load(d + i + k * S::W), dv));
+        }
+        for (; i + S::W <= n; i += S::W) S::store(d + i, S::add(S::load(d + i), dv));
+        for (; i < n; ++i) d[i] = (char)((unsigned char)d[i] + delta);
+    }
+
+    static CryptKernels table(const char* name) {
+        return {name, &xorPattern, &addByte};
+    }
+};
+
+} // namespace
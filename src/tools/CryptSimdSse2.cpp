@@ -0,0 +1,22 @@
+#include <emmintrin.h>
+#include "CryptSimdKernels.inl"
+
+namespace {
+
+struct Sse2 {
+    using V = __m128i;
+    static constexpr std::size_t W = 16;
+
+    static V load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(char* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V set1(unsigned char c) { return _mm_set1_epi8((char)c); }
+    static V xor_(V a, V b) { return _mm_xor_si128(a, b); }
+    static V add(V a, V b) { return _mm_add_epi8(a, b); }
+};
+
+} // namespace
+
+const CryptKernels& cryptSse2Kernels() {
+    static const CryptKernels k = CryptVecKernels<Sse2>::table("sse2");
+    return k;
+}
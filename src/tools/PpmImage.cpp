@@ -0,0 +1,113 @@
+#include "PpmImage.h"
+#include "MappedFile.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - The file is memory-mapped; P6 pixel data is copied out in one memcpy when maxval is 255,
+   otherwise every sample goes through a 256-entry rescaling table.
+ - The header parser follows the netpbm rules: whitespace-separated decimal fields, and a
+   '#' starts a comment up to the end of the line. Exactly one whitespace byte separates
+   the header from P6 binary data. The pixel count is checked against the bytes left in the
+   file before the buffer is allocated, so a forged header cannot ask for a huge allocation.
+ - writePpm builds the header with snprintf and writes header and pixels with two fwrite
+   calls; a short write or a failed fclose is reported.
+*/
+
+namespace {
+
+struct HeaderReader {
+    const char* p;
+    const char* end;
+    const std::string& path;
+
+    void skipSpace() {
+        while (p < end) {
+            if (*p == '#') {
+                while (p < end && *p != '\n') ++p;
+            } else if (std::isspace((unsigned char)*p)) {
+                ++p;
+            } else {
+                break;
+            }
+        }
+    }
+
+    std::size_t number(const char* what) {
+        skipSpace();
+        if (p == end || !std::isdigit((unsigned char)*p)) throw std::runtime_error(path + ": bad PPM " + what);
+        std::size_t v = 0;
+        while (p < end && std::isdigit((unsigned char)*p)) {
+            v = v * 10 + (std::size_t)(*p++ - '0');
+            if (v > ((std::size_t)1 << 32)) throw std::runtime_error(path + ": PPM " + what + " too large");
+        }
+        return v;
+    }
+};
+
+} // namespace
+
+PpmImage readPpm(const std::string& path) {
+    MappedFile file(path);
+    HeaderReader r{file.data(), file.data() + file.size(), path};
+    if (file.size() < 2 || r.p[0] != 'P' || (r.p[1] != '6' && r.p[1] != '3'))
+        throw std::runtime_error(path + ": not a PPM (P6 / P3) file");
+    bool binary = r.p[1] == '6';
+    r.p += 2;
+
+    PpmImage img;
+    img.width = r.number("width");
+    img.height = r.number("height");
+    std::size_t maxval = r.number("maxval");
+    if (maxval == 0 || maxval > 255) throw std::runtime_error(path + ": PPM maxval must be 1..255");
+    if (img.width == 0 || img.height == 0) throw std::runtime_error(path + ": empty PPM image");
+
+    std::uint8_t scale[256];
+    for (std::size_t v = 0; v <= maxval; ++v) scale[v] = (std::uint8_t)((v * 255 + maxval / 2) / maxval);
+
+    if (binary) {
+        if (r.p == r.end || !std::isspace((unsigned char)*r.p)) throw std::runtime_error(path + ": bad PPM header");
+        ++r.p;
+    }
+    // checked before allocating: P6 needs a byte per sample, P3 a digit plus a separator
+    // (but the last sample may end the file). Dividing instead of multiplying cannot overflow
+    std::size_t left = (std::size_t)(r.end - r.p);
+    std::size_t fits = binary ? left : (left + 1) / 2;
+    if (img.width > fits / 3 / img.height) throw std::runtime_error(path + ": truncated PPM data");
+    std::size_t samples = img.size() * 3;
+    img.pixels.resize(samples);
+    if (binary) {
+        if (maxval == 255) {
+            std::memcpy(img.pixels.data(), r.p, samples);
+        } else {
+            for (std::size_t i = 0; i < samples; ++i) {
+                std::uint8_t v = (std::uint8_t)r.p[i];
+                if (v > maxval) throw std::runtime_error(path + ": PPM sample above maxval");
+                img.pixels[i] = scale[v];
+            }
+        }
+    } else {
+        for (std::size_t i = 0; i < samples; ++i) {
+            std::size_t v = r.number("sample");
+            if (v > maxval) throw std::runtime_error(path + ": PPM sample above maxval");
+            img.pixels[i] = scale[v];
+        }
+    }
+    return img;
+}
+
+void writePpm(const std::string& path, const PpmImage& image) {
+    if (image.pixels.size() != image.size() * 3) throw std::runtime_error("PPM pixel buffer does not match its size");
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("Cannot create " + path + ": " + std::strerror(errno));
+    char header[64];
+    int len = std::snprintf(header, sizeof header, "P6\n%zu %zu\n255\n", image.width, image.height);
+    bool ok = std::fwrite(header, 1, (std::size_t)len, f) == (std::size_t)len &&
+              std::fwrite(image.pixels.data(), 1, image.pixels.size(), f) == image.pixels.size();
+    if (std::fclose(f) != 0) ok = false;
+    if (!ok) throw std::runtime_error("Cannot write " + path);
+}
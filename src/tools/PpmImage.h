@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ PpmImage - 读写 PPM 图像（批量颜色转换的输入输出格式）
+ - readPpm 支持二进制 P6 和文本 P3，maxval 不超过 255，头部可以有 # 注释；
+   maxval 不是 255 时像素值按比例放大到 0..255
+ - writePpm 总是写 P6、maxval 255
+ - 像素按行交错存储（RGBRGB...），可以直接用 Rgb8In::interleaved 处理
+ - 文件格式错误或读写失败时抛出 runtime_error
+*/
+struct PpmImage {
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::vector<std::uint8_t> pixels; // width * height * 3
+
+    std::size_t size() const { return width * height; }
+};
+
+PpmImage readPpm(const std::string& path);
+void writePpm(const std::string& path, const PpmImage& image);
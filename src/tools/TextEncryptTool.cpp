@@ -1,65 +1,564 @@
 #include "TextEncryptTool.h"
 #include "ConfigManager.h"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iterator>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-static std::string xor_crypt(const std::string& s, const std::string& key) {
-    std::string out = s;
-    for (size_t i = 0; i < s.size(); i++)
-        out[i] = s[i] ^ key[i % key.size()];
+/*
+ Implementation details:
+ - XOR uses a pre-expanded key pattern: the key repeated to a period of at least 64 bytes
+   (a multiple of the key length) plus 64 more bytes, so every vector load of key bytes is a
+   plain unaligned load at `phase` and the phase just wraps modulo the period.
+ - cryptFile reads with read(2) straight into one of two CHUNK buffers, transforms it in
+   place, and hands it to a one-thread pool for write(2) while the next chunk is read.
+   A buffer is reused only after the write that used it has finished.
+ - Base64 goes through the same pump but transforms into a second pair of buffers.
+   The scalar codec is table-driven: encoding maps each 12-bit half of a 3-byte group to two
+   chars with one 8 KiB table; decoding ORs four 256-entry tables that hold each char's
+   6 bits pre-shifted for its position in the group, with bit 24 set for non-alphabet chars,
+   so one test validates the whole group.
+ - The bulk kernels only take complete, clean groups. The stream classes carry partial groups
+   between calls and walk line breaks, padding and errors one char at a time before going back
+   to the kernel, so wrapped input (76-char lines) still decodes mostly in bulk.
+*/
+
+static constexpr std::size_t CHUNK = 4 << 20;
+static constexpr std::size_t PATTERN_MIN = 64;
+
+static const ConfigKey<std::string> CFG_METHOD{"encrypt", "method", "xor"};
+static const ConfigKey<int> CFG_SHIFT{"encrypt", "shift", 3};
+static const ConfigKey<std::string> CFG_KEY{"encrypt", "key", "default_key"};
+
+static void xor_scalar(char* d, std::size_t n, const char* pat, std::size_t period, std::size_t phase) {
+    for (std::size_t i = 0; i < n; ++i) {
+        d[i] ^= pat[phase];
+        if (++phase == period) phase = 0;
+    }
+}
+
+static void add_scalar(char* d, std::size_t n, unsigned char delta) {
+    for (std::size_t i = 0; i < n; ++i) d[i] = (char)((unsigned char)d[i] + delta);
+}
+
+const CryptKernels& cryptScalarKernels() {
+    static const CryptKernels k = {"scalar", &xor_scalar, &add_scalar};
+    return k;
+}
+
+const CryptKernels& cryptKernels() {
+    static const CryptKernels& k = [] () -> const CryptKernels& {
+#ifdef SUITE_X86_SIMD
+        SimdLevel level = cpuSimdLevel();
+        if (level >= SimdLevel::Avx2) return cryptAvx2Kernels();
+        if (level >= SimdLevel::Sse2) return cryptSse2Kernels();
+#endif
+        return cryptScalarKernels();
+    }();
+    return k;
+}
+
+namespace {
+
+const char B64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr std::uint32_t B64_BAD = 1u << 24;
+
+struct Base64Tables {
+    std::uint16_t enc[4096];   // 12 bits -> two chars, in memory order
+    std::uint32_t dec[4][256]; // char at position k of a group -> its bits, or B64_BAD
+
+    Base64Tables() {
+        for (unsigned x = 0; x < 4096; ++x) {
+            char pair[2] = {B64_ALPHABET[x >> 6], B64_ALPHABET[x & 63]};
+            std::memcpy(&enc[x], pair, 2);
+        }
+        for (auto& t : dec) std::fill(std::begin(t), std::end(t), B64_BAD);
+        for (std::uint32_t v = 0; v < 64; ++v) {
+            unsigned char c = (unsigned char)B64_ALPHABET[v];
+            for (int k = 0; k < 4; ++k) dec[k][c] = v << (18 - 6 * k);
+        }
+    }
+};
+
+const Base64Tables& b64_tables() {
+    static const Base64Tables t;
+    return t;
+}
+
+std::size_t b64_encode_scalar(const unsigned char* in, std::size_t n, char* out) {
+    const std::uint16_t* enc = b64_tables().enc;
+    std::size_t i = 0;
+    for (; i + 3 <= n; i += 3, out += 4) {
+        std::uint32_t v = (std::uint32_t)in[i] << 16 | (std::uint32_t)in[i + 1] << 8 | in[i + 2];
+        std::memcpy(out, &enc[v >> 12], 2);
+        std::memcpy(out + 2, &enc[v & 0xfff], 2);
+    }
+    return i;
+}
+
+std::size_t b64_decode_scalar(const char* in, std::size_t n, unsigned char* out) {
+    const Base64Tables& t = b64_tables();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4, out += 3) {
+        std::uint32_t v = t.dec[0][p[i]] | t.dec[1][p[i + 1]] | t.dec[2][p[i + 2]] | t.dec[3][p[i + 3]];
+        if (v & B64_BAD) break;
+        out[0] = (unsigned char)(v >> 16);
+        out[1] = (unsigned char)(v >> 8);
+        out[2] = (unsigned char)v;
+    }
+    return i;
+}
+
+[[noreturn]] void b64_fail(std::uint64_t offset, const char* what) {
+    throw std::runtime_error("Invalid base64 at offset " + std::to_string(offset) + ": " + what);
+}
+
+} // namespace
+
+const Base64Kernels& base64ScalarKernels() {
+    static const Base64Kernels k = {"scalar", &b64_encode_scalar, &b64_decode_scalar};
+    return k;
+}
+
+const Base64Kernels& base64Kernels() {
+    static const Base64Kernels& k = [] () -> const Base64Kernels& {
+#ifdef SUITE_X86_SIMD
+        SimdLevel level = cpuSimdLevel();
+        if (level >= SimdLevel::Avx2) return base64Avx2Kernels();
+        if (level >= SimdLevel::Ssse3) return base64Ssse3Kernels();
+#endif
+        return base64ScalarKernels();
+    }();
+    return k;
+}
+
+CryptMethod cryptMethodFromName(const std::string& name) {
+    if (name == "caesar") return CryptMethod::Caesar;
+    if (name == "base64") return CryptMethod::Base64;
+    return CryptMethod::Xor;
+}
+
+const char* cryptMethodName(CryptMethod m) {
+    switch (m) {
+    case CryptMethod::Xor: return "xor";
+    case CryptMethod::Caesar: return "caesar";
+    case CryptMethod::Base64: return "base64";
+    }
+    return "xor";
+}
+
+CryptStream::CryptStream(const CryptSettings& s, const CryptKernels& kernels) : kern(kernels), method(s.method) {
+    if (method == CryptMethod::Base64) throw std::runtime_error("Base64 is not an in-place transform");
+    if (method == CryptMethod::Caesar) {
+        delta = (unsigned char)(s.decrypt ? -s.shift : s.shift);
+        return;
+    }
+    // xor is its own inverse
+    if (s.key.empty()) throw std::runtime_error("XOR key is empty");
+    period = (PATTERN_MIN + s.key.size() - 1) / s.key.size() * s.key.size();
+    pattern.resize(period + PATTERN_MIN);
+    for (std::size_t i = 0; i < pattern.size(); ++i) pattern[i] = s.key[i % s.key.size()];
+}
+
+void CryptStream::apply(char* data, std::size_t n) {
+    if (method == CryptMethod::Caesar) {
+        kern.addByte(data, n, delta);
+        return;
+    }
+    kern.xorPattern(data, n, pattern.data(), period, phase);
+    phase = (phase + n % period) % period;
+}
+
+std::size_t Base64Encoder::update(const char* in, std::size_t n, char* out) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    std::size_t w = 0;
+    if (carried > 0) {
+        while (carried < 3 && n > 0) {
+            carry[carried++] = *p++;
+            --n;
+        }
+        if (carried < 3) return 0;
+        w = b64_encode_scalar(carry, 3, out) / 3 * 4;
+        carried = 0;
+    }
+    std::size_t done = kern.encode(p, n, out + w);
+    done += b64_encode_scalar(p + done, n - done, out + w + done / 3 * 4);
+    w += done / 3 * 4;
+    for (; done < n; ++done) carry[carried++] = p[done];
+    return w;
+}
+
+std::size_t Base64Encoder::finish(char* out) {
+    if (carried == 0) return 0;
+    unsigned char group[3] = {carry[0], carried > 1 ? carry[1] : (unsigned char)0, 0};
+    b64_encode_scalar(group, 3, out);
+    out[3] = '=';
+    if (carried == 1) out[2] = '=';
+    carried = 0;
+    return 4;
+}
+
+std::size_t Base64Decoder::update(const char* in, std::size_t n, char* outc) {
+    unsigned char* out = reinterpret_cast<unsigned char*>(outc);
+    std::size_t i = 0, w = 0;
+    while (i < n) {
+        if (have == 0 && pads == 0 && !ended) {
+            // the kernel may leave a tail short of its block size; the scalar loop takes it
+            std::size_t k = kern.decode(in + i, n - i, out + w);
+            k += b64_decode_scalar(in + i + k, n - i - k, out + w + k / 4 * 3);
+            i += k;
+            w += k / 4 * 3;
+            if (i == n) break;
+        }
+        w += slow(in[i], pos + i, out + w);
+        ++i;
+    }
+    pos += n;
+    return w;
+}
+
+std::size_t Base64Decoder::slow(char c, std::uint64_t offset, unsigned char* out) {
+    if (c == '\n' || c == '\r') return 0;
+    if (ended) b64_fail(offset, "data after padding");
+    const Base64Tables& t = b64_tables();
+    if (c == '=') {
+        if (have < 2) b64_fail(offset, "misplaced '='");
+        if (have + ++pads < 4) return 0;
+        // last group: 2 chars -> 1 byte, 3 chars -> 2 bytes; the dropped bits must be zero
+        std::uint32_t v = t.dec[0][(unsigned char)quad[0]] | t.dec[1][(unsigned char)quad[1]];
+        if (have == 3) v |= t.dec[2][(unsigned char)quad[2]];
+        if (v & (have == 2 ? 0xF000u : 0xC0u)) b64_fail(offset, "non-zero bits before padding");
+        out[0] = (unsigned char)(v >> 16);
+        if (have == 3) out[1] = (unsigned char)(v >> 8);
+        ended = true;
+        std::size_t w = (std::size_t)have - 1;
+        have = pads = 0;
+        return w;
+    }
+    if (t.dec[0][(unsigned char)c] & B64_BAD) b64_fail(offset, "invalid character");
+    if (pads > 0) b64_fail(offset, "expected '='");
+    quad[have++] = c;
+    if (have < 4) return 0;
+    have = 0;
+    return b64_decode_scalar(quad, 4, out) / 4 * 3;
+}
+
+void Base64Decoder::finish() {
+    if (have > 0 || pads > 0) b64_fail(pos, "input ends inside a group");
+}
+
+std::string base64Encode(std::string_view data) {
+    std::string out(Base64Encoder::maxOutput(data.size()), '\0');
+    Base64Encoder enc;
+    std::size_t w = enc.update(data.data(), data.size(), &out[0]);
+    w += enc.finish(&out[0] + w);
+    out.resize(w);
     return out;
 }
 
-void TextEncryptTool::run() {
-    auto& cfg = ConfigManager::instance().config();
-    std::string method = cfg["encrypt"]["method"];
-    int shift = cfg["encrypt"]["shift"];
-    std::string key = cfg["encrypt"]["key"];
+std::string base64Decode(std::string_view text) {
+    std::string out(Base64Decoder::maxOutput(text.size()), '\0');
+    Base64Decoder dec;
+    out.resize(dec.update(text.data(), text.size(), &out[0]));
+    dec.finish();
+    return out;
+}
 
-    while (true) {
-        std::cout << "[EncryptTool] command (encrypt/decrypt/set/quit): ";
-        std::string cmd;
-        std::getline(std::cin, cmd);
+CryptSettings TextEncryptTool::loadSettings() {
+    const ConfigSnapshot& cfg = ConfigManager::instance().current();
+    CryptSettings s;
+    s.method = cryptMethodFromName(cfg.get(CFG_METHOD));
+    s.shift = cfg.get(CFG_SHIFT);
+    s.key = cfg.get(CFG_KEY);
+    return s;
+}
+
+namespace {
+
+struct Fd {
+    int fd;
+    bool owned;
+    ~Fd() {
+        if (owned && fd >= 0) ::close(fd);
+    }
+};
+
+// fills buf unless the input ends first; returns the bytes read
+std::size_t read_full(int fd, char* buf, std::size_t size) {
+    std::size_t got = 0;
+    while (got < size) {
+        ssize_t r = ::read(fd, buf + got, size - got);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("Read failed: ") + std::strerror(errno));
+        if (r == 0) break;
+        got += (std::size_t)r;
+    }
+    return got;
+}
+
+void write_all(int fd, const char* buf, std::size_t size) {
+    while (size > 0) {
+        ssize_t w = ::write(fd, buf, size);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+        buf += w;
+        size -= (std::size_t)w;
+    }
+}
+
+// reads `in` in CHUNK pieces and writes what `transform(cur, buf, n, eof)` returns for each;
+// the returned bytes (in buf or in the transform's own buffer `cur`) must stay untouched until
+// the call after next. Returns the bytes read.
+template <class Transform>
+std::uint64_t pump(int in, int out, Transform transform) {
+    std::vector<char> bufs[2] = {std::vector<char>(CHUNK), std::vector<char>(CHUNK)};
+    std::uint64_t total = 0;
+    ThreadPool writer(1); // destroyed (joined) before the buffers
+    std::future<void> pending;
+    for (int cur = 0;; cur ^= 1) {
+        char* buf = bufs[cur].data();
+        std::size_t got = read_full(in, buf, CHUNK);
+        bool eof = got < CHUNK;
+        std::string_view chunk = transform(cur, buf, got, eof);
+        if (pending.valid()) pending.get(); // the other buffers are free again
+        if (!chunk.empty()) pending = writer.async([out, chunk] { write_all(out, chunk.data(), chunk.size()); });
+        total += got;
+        if (eof) break;
+    }
+    if (pending.valid()) pending.get();
+    return total;
+}
+
+} // namespace
+
+std::uint64_t TextEncryptTool::cryptFile(const std::string& in, const std::string& out, const CryptSettings& s) {
+    std::optional<CryptStream> stream;
+    if (s.method != CryptMethod::Base64) stream.emplace(s);
+    Fd src{in == "-" ? 0 : ::open(in.c_str(), O_RDONLY), in != "-"};
+    if (src.fd < 0) throw std::runtime_error("Cannot open " + in);
+    if (out != "-") {
+        // O_TRUNC on the input itself would destroy it before it is read
+        struct stat a, b;
+        if (::fstat(src.fd, &a) == 0 && ::stat(out.c_str(), &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino)
+            throw std::runtime_error("Input and output are the same file");
+    }
+    Fd dst{out == "-" ? 1 : ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644), out != "-"};
+    if (dst.fd < 0) throw std::runtime_error("Cannot create " + out);
+
+    if (stream) {
+        return pump(src.fd, dst.fd, [&](int, char* buf, std::size_t n, bool) {
+            stream->apply(buf, n);
+            return std::string_view(buf, n);
+        });
+    }
+    if (!s.decrypt) {
+        Base64Encoder enc;
+        std::size_t cap = Base64Encoder::maxOutput(CHUNK);
+        std::vector<char> outs[2] = {std::vector<char>(cap), std::vector<char>(cap)};
+        return pump(src.fd, dst.fd, [&](int cur, char* buf, std::size_t n, bool eof) {
+            char* o = outs[cur].data();
+            std::size_t w = enc.update(buf, n, o);
+            if (eof) w += enc.finish(o + w);
+            return std::string_view(o, w);
+        });
+    }
+    Base64Decoder dec;
+    std::size_t cap = Base64Decoder::maxOutput(CHUNK);
+    std::vector<char> outs[2] = {std::vector<char>(cap), std::vector<char>(cap)};
+    return pump(src.fd, dst.fd, [&](int cur, char* buf, std::size_t n, bool eof) {
+        char* o = outs[cur].data();
+        std::size_t w = dec.update(buf, n, o);
+        if (eof) dec.finish();
+        return std::string_view(o, w);
+    });
+}
 
-        if (cmd == "quit") break;
+void TextEncryptTool::benchmark(std::ostream& out, std::size_t bytes) {
+    constexpr int PASSES = 4;
+    std::vector<char> buf(bytes);
+    for (std::size_t i = 0; i < bytes; ++i) buf[i] = (char)(i * 131 + (i >> 9));
 
-        if (cmd.rfind("set key ", 0) == 0) {
-            key = cmd.substr(8);
-            continue;
+    std::vector<const CryptKernels*> sets = {&cryptScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    SimdLevel level = cpuSimdLevel();
+    if (level >= SimdLevel::Sse2) sets.push_back(&cryptSse2Kernels());
+    if (level >= SimdLevel::Avx2) sets.push_back(&cryptAvx2Kernels());
+#endif
+
+    out << "buffer " << (bytes >> 20) << " MiB, best of " << PASSES << " passes\n";
+    for (const CryptKernels* k : sets) {
+        out << "  " << std::left << std::setw(8) << k->name << std::right;
+        for (CryptMethod m : {CryptMethod::Xor, CryptMethod::Caesar}) {
+            CryptSettings s;
+            s.method = m;
+            CryptStream stream(s, *k);
+            double best = 0;
+            for (int p = 0; p < PASSES; ++p) {
+                auto t0 = std::chrono::steady_clock::now();
+                stream.apply(buf.data(), buf.size());
+                double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                best = std::max(best, (double)bytes / dt / 1e9);
+            }
+            out << (m == CryptMethod::Xor ? " xor " : "  caesar ") << std::fixed << std::setprecision(2) << best
+                << " GB/s";
         }
+        out << "\n";
+    }
 
-        if (cmd == "set method xor") method = "xor";
-        if (cmd == "set method caesar") method = "caesar";
+    std::vector<const Base64Kernels*> b64 = {&base64ScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    if (level >= SimdLevel::Ssse3) b64.push_back(&base64Ssse3Kernels());
+    if (level >= SimdLevel::Avx2) b64.push_back(&base64Avx2Kernels());
+#endif
+    std::string text = base64Encode(std::string_view(buf.data(), bytes));
+    std::vector<char> sink(std::max(Base64Encoder::maxOutput(bytes), Base64Decoder::maxOutput(text.size())));
+    out << "base64\n";
+    for (const Base64Kernels* k : b64) {
+        double enc = 0, dec = 0;
+        for (int p = 0; p < PASSES; ++p) {
+            auto t0 = std::chrono::steady_clock::now();
+            Base64Encoder e(*k);
+            e.finish(sink.data() + e.update(buf.data(), bytes, sink.data()));
+            auto t1 = std::chrono::steady_clock::now();
+            Base64Decoder d(*k);
+            d.update(text.data(), text.size(), sink.data());
+            d.finish();
+            auto t2 = std::chrono::steady_clock::now();
+            enc = std::max(enc, (double)bytes / std::chrono::duration<double>(t1 - t0).count() / 1e9);
+            dec = std::max(dec, (double)text.size() / std::chrono::duration<double>(t2 - t1).count() / 1e9);
+        }
+        out << "  " << std::left << std::setw(8) << k->name << std::right << " encode " << std::fixed
+            << std::setprecision(2) << enc << " GB/s  decode " << dec << " GB/s\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
 
-        if (cmd == "encrypt") {
-            std::cout << "Enter text: ";
-            std::string text;
-            std::getline(std::cin, text);
+namespace {
+
+// what execute() needs from config.json, rebuilt when the config generation changes
+struct RequestCrypt {
+    std::uint64_t generation = ~std::uint64_t(0);
+    CryptMethod method = CryptMethod::Xor;
+    std::optional<CryptStream> streams[2]; // encrypt, decrypt; empty for base64
+};
+
+RequestCrypt& request_crypt() {
+    thread_local RequestCrypt rc;
+    std::uint64_t gen = ConfigManager::instance().generation();
+    if (rc.generation == gen) return rc;
+    CryptSettings s = TextEncryptTool::loadSettings();
+    rc.generation = ~std::uint64_t(0);
+    rc.method = s.method;
+    for (int d = 0; d < 2; ++d) {
+        rc.streams[d].reset();
+        s.decrypt = d == 1;
+        if (s.method != CryptMethod::Base64) rc.streams[d].emplace(s);
+    }
+    rc.generation = gen;
+    return rc;
+}
+
+} // namespace
 
-            if (method == "xor")
-                std::cout << xor_crypt(text, key) << "\n";
-            else if (method == "caesar") {
-                for (char& c : text) c += shift;
-                std::cout << text << "\n";
+void TextEncryptTool::execute(const ToolArgs& args, ToolOutput& out) {
+    std::string_view op = args[0];
+    if (op != "encrypt" && op != "decrypt") throw std::runtime_error("Expected 'encrypt <text>' or 'decrypt <text>'");
+    bool decrypt = op == "decrypt";
+    std::string_view text = args.rest(1);
+    RequestCrypt& rc = request_crypt();
+    std::size_t at = out.size();
+    if (rc.method == CryptMethod::Base64 && decrypt) {
+        Base64Decoder dec;
+        char* o = out.extend(Base64Decoder::maxOutput(text.size()));
+        std::size_t w = dec.update(text.data(), text.size(), o);
+        dec.finish();
+        out.truncate(at + w);
+    } else if (rc.method == CryptMethod::Base64) {
+        Base64Encoder enc;
+        char* o = out.extend(Base64Encoder::maxOutput(text.size()));
+        std::size_t w = enc.update(text.data(), text.size(), o);
+        w += enc.finish(o + w);
+        out.truncate(at + w);
+    } else {
+        CryptStream& stream = *rc.streams[decrypt];
+        stream.rewind();
+        char* o = out.extend(text.size());
+        std::memcpy(o, text.data(), text.size());
+        stream.apply(o, text.size());
+    }
+    out << '\n';
+}
+
+void TextEncryptTool::run() {
+    ConfigManager& config = ConfigManager::instance();
+    CryptSettings settings = loadSettings();
+    std::uint64_t seen = config.generation();
+    ToolOutput out;
+
+    while (true) {
+        std::cout << "[EncryptTool] command (encrypt/decrypt/encrypt file <in> <out>/decrypt file <in> <out>/bench/set/quit): ";
+        std::string cmd;
+        if (!std::getline(std::cin, cmd) || cmd == "quit") break;
+        // config.json was edited (or reloaded) while we were waiting
+        if (config.generation() != seen) settings = loadSettings();
+
+        if (cmd.rfind("set key ", 0) == 0) settings.key = cmd.substr(8);
+        if (cmd == "set method xor") settings.method = CryptMethod::Xor;
+        if (cmd == "set method caesar") settings.method = CryptMethod::Caesar;
+        if (cmd == "set method base64") settings.method = CryptMethod::Base64;
+
+        if (cmd == "bench") benchmark(std::cout, 256 << 20);
+
+        if (cmd.rfind("encrypt file ", 0) == 0 || cmd.rfind("decrypt file ", 0) == 0) {
+            CryptSettings s = settings;
+            s.decrypt = cmd[0] == 'd';
+            std::string args = cmd.substr(13);
+            std::size_t sp = args.find(' ');
+            if (sp == std::string::npos) {
+                std::cout << "Usage: " << cmd.substr(0, 12) << " <in> <out>\n";
+            } else {
+                try {
+                    auto t0 = std::chrono::steady_clock::now();
+                    std::uint64_t n = cryptFile(args.substr(0, sp), args.substr(sp + 1), s);
+                    double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                    std::cout << n << " bytes in " << dt << " s\n";
+                } catch (const std::exception& e) {
+                    std::cout << "Error: " << e.what() << "\n";
+                }
             }
         }
 
-        if (cmd == "decrypt") {
+        // settings changed by a previous command are already in the config execute() reads
+        if (cmd == "encrypt" || cmd == "decrypt") {
             std::cout << "Enter text: ";
             std::string text;
             std::getline(std::cin, text);
-
-            if (method == "xor")
-                std::cout << xor_crypt(text, key) << "\n";
-            else if (method == "caesar") {
-                for (char& c : text) c -= shift;
-                std::cout << text << "\n";
-            }
+            std::string request = cmd + ' ' + text;
+            out.clear();
+            respond(ToolArgs(request), out, "Error: ");
+            std::cout << out.view();
         }
 
-        cfg["encrypt"]["method"] = method;
-        cfg["encrypt"]["shift"] = shift;
-        cfg["encrypt"]["key"] = key;
-        ConfigManager::instance().save();
+        config.set("encrypt", "method", cryptMethodName(settings.method));
+        config.set("encrypt", "shift", settings.shift);
+        config.set("encrypt", "key", settings.key);
+        config.save();
+        seen = config.generation();
     }
-}
 
+    ConfigManager::SaveStats st = config.saveStats();
+    std::cout << "config.json: " << st.writes << " writes, " << st.avoided << " of " << st.requests
+              << " saves avoided\n";
+}
@@ -1,11 +1,121 @@
 #pragma once
 #include "Tool.h"
+#include "Base64Simd.h"
+#include "CryptSimd.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ TextEncryptTool - XOR / Caesar 加密，Base64 编解码
+ - 命令: encrypt / decrypt                            -> 加密/解密一行文本（base64 下为编码/解码）
+         encrypt file <in> <out> / decrypt file ...    -> 处理任意大小的文件（"-" 表示标准输入/输出）
+         bench                                        -> 测量各级 SIMD 内核的吞吐量
+         set key <key> ; set method xor|caesar|base64 ; quit
+ - 设置保存在 config.json 的 "encrypt" 段
+ - 文件按 4 MiB 块原地变换：读入并变换一块的同时，后台线程写出上一块（双缓冲），没有额外复制；
+   XOR 的密钥相位跨块连续，结果与整体一次变换完全相同
+ - Base64 输出长度不同，写到另一对缓冲区；编码不换行，解码跳过 \r \n，其他非法内容
+   （非字母表字符、错位或多余的 '='、补位后的数据、非零的末尾比特、残缺的最后一组）报错并给出偏移
+ - 命令行: --encrypt|--decrypt <in|-> <out|-> [--method xor|caesar|base64] [--key k] [--shift n]
+           --encrypt-bench [MiB]
+*/
+enum class CryptMethod { Xor, Caesar, Base64 };
+
+// "xor", "caesar" or "base64"; anything else is xor
+CryptMethod cryptMethodFromName(const std::string& name);
+const char* cryptMethodName(CryptMethod m);
+
+struct CryptSettings {
+    CryptMethod method = CryptMethod::Xor;
+    std::string key = "default_key";
+    int shift = 3;
+    bool decrypt = false;
+};
+
+// in-place transform of a byte stream delivered in pieces of any size
+class CryptStream {
+public:
+    // throws runtime_error for an empty XOR key or for Base64 (not an in-place transform)
+    explicit CryptStream(const CryptSettings& s, const CryptKernels& kernels = cryptKernels());
+
+    // continues where the previous call stopped (key phase carries over)
+    void apply(char* data, std::size_t n);
+    // the next apply() starts a new stream (key phase 0)
+    void rewind() { phase = 0; }
+
+private:
+    const CryptKernels& kern;
+    CryptMethod method;
+    unsigned char delta = 0;   // caesar
+    std::vector<char> pattern; // xor: the key repeated to period + 64 bytes
+    std::size_t period = 0;
+    std::size_t phase = 0;
+};
+
+// Base64 encoding of a stream delivered in pieces of any size (no line breaks)
+class Base64Encoder {
+public:
+    explicit Base64Encoder(const Base64Kernels& kernels = base64Kernels()) : kern(kernels) {}
+
+    // out must hold maxOutput(n) chars; returns the chars written
+    std::size_t update(const char* in, std::size_t n, char* out);
+    // the final group with '=' padding (up to 4 chars); returns the chars written
+    std::size_t finish(char* out);
+    static std::size_t maxOutput(std::size_t n) { return (n + 2) / 3 * 4; }
+
+private:
+    const Base64Kernels& kern;
+    unsigned char carry[3];
+    std::size_t carried = 0;
+};
+
+// strict Base64 decoding of a stream delivered in pieces of any size; errors are
+// runtime_errors naming the offset of the offending character in the whole stream
+class Base64Decoder {
+public:
+    explicit Base64Decoder(const Base64Kernels& kernels = base64Kernels()) : kern(kernels) {}
+
+    // out must hold maxOutput(n) bytes; returns the bytes written
+    std::size_t update(const char* in, std::size_t n, char* out);
+    // throws if the input ended inside a group
+    void finish();
+    static std::size_t maxOutput(std::size_t n) { return n / 4 * 3 + 3; }
+
+private:
+    const Base64Kernels& kern;
+    char quad[4];
+    int have = 0;          // alphabet chars of the current group
+    int pads = 0;          // '=' seen in the current group
+    bool ended = false;    // a padded group was completed; only line breaks may follow
+    std::uint64_t pos = 0; // chars consumed before the current update
+
+    std::size_t slow(char c, std::uint64_t offset, unsigned char* out);
+};
+
+std::string base64Encode(std::string_view data);
+// throws runtime_error on malformed input
+std::string base64Decode(std::string_view text);
 
 class TextEncryptTool : public Tool {
 public:
     std::string name() const override { return "Text Encrypt"; }
-    std::string description() const override { return "Base64 / Caesar / XOR encryption"; }
+    static constexpr const char* DESCRIPTION = "Base64 / Caesar / XOR encryption";
+    std::string description() const override { return DESCRIPTION; }
     void run() override;
-};
+    // "encrypt <text>" / "decrypt <text>" with the settings from config.json; the reply is the
+    // transformed text (raw bytes for xor / caesar) and a newline. Settings and key patterns
+    // are rebuilt per thread only when the config changes
+    void execute(const ToolArgs& args, ToolOutput& out) override;
 
+    // the "encrypt" section of config.json; defaults for missing values
+    static CryptSettings loadSettings();
+    // streams in -> out ("-" = stdin / stdout); returns the number of input bytes processed
+    static std::uint64_t cryptFile(const std::string& in, const std::string& out, const CryptSettings& s);
+    // throughput of every kernel set the CPU supports, on an in-memory buffer of `bytes`
+    // (Base64: encode per raw byte, decode per input char)
+    static void benchmark(std::ostream& out, std::size_t bytes);
+};
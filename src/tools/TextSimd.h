@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ TextSimd - 文本统计用的字符分类内核
+ - 每 64 字节一块，输出三个位掩码：空白、单词字符、句末标点，第 i 位对应块内第 i 个字节
+ - 分类与 C locale 的 isspace / isalnum 一致（单词字符另含 '\''），>= 0x80 的字节不属于任何一类
+ - TextStatsCounter 用 popcount 计数，用单词掩码的 0/1 跳变找单词边界
+*/
+struct TextClassMasks {
+    std::uint64_t space;
+    std::uint64_t word;
+    std::uint64_t sentence;
+};
+
+struct TextKernels {
+    const char* name;
+    // blocks * 64 bytes at p -> one TextClassMasks per block
+    void (*classify)(const char* p, std::size_t blocks, TextClassMasks* out);
+};
+
+const TextKernels& textScalarKernels();
+#ifdef SUITE_X86_SIMD
+const TextKernels& textSse2Kernels();
+const TextKernels& textAvx2Kernels();
+#endif
+
+// best kernel set for the running CPU (see cpuSimdLevel)
+const TextKernels& textKernels();
@@ -0,0 +1,25 @@
+// Compiled with -mavx2; only called after runtime CPU detection.
+#include <immintrin.h>
+#include "TextSimdKernels.inl"
+
+namespace {
+
+struct Avx2 {
+    using V = __m256i;
+    static constexpr std::size_t W = 32;
+
+    static V load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static V set1(unsigned char c) { return _mm256_set1_epi8((char)c); }
+    static V sub(V a, V b) { return _mm256_sub_epi8(a, b); }
+    static V min(V a, V b) { return _mm256_min_epu8(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V cmpeq(V a, V b) { return _mm256_cmpeq_epi8(a, b); }
+    static std::uint32_t mask(V m) { return (std::uint32_t)_mm256_movemask_epi8(m); }
+};
+
+} // namespace
+
+const TextKernels& textAvx2Kernels() {
+    static const TextKernels k = TextVecKernels<Avx2>::table("avx2");
+    return k;
+}
@@ -0,0 +1,45 @@
+// Shared byte classification template for TextSimd*.cpp.
+// Each including translation unit provides a traits struct S over unsigned bytes and is
+// compiled with the matching target flags; everything here has internal linkage.
+#include "TextSimd.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+template <class S>
+struct TextVecKernels {
+    using V = typename S::V;
+
+    // lo <= x <= hi as unsigned bytes
+    static V in_range(V x, unsigned char lo, unsigned char hi) {
+        V d = S::sub(x, S::set1(lo));
+        return S::cmpeq(S::min(d, S::set1((unsigned char)(hi - lo))), d);
+    }
+
+    static void classify(const char* p, std::size_t blocks, TextClassMasks* out) {
+        for (std::size_t b = 0; b < blocks; ++b, p += 64) {
+            TextClassMasks m{0, 0, 0};
+            for (std::size_t k = 0; k < 64; k += S::W) {
+                V x = S::load(p + k);
+                // ' ' and \t \n \v \f \r
+                V space = S::or_(S::cmpeq(x, S::set1(' ')), in_range(x, '\t', '\r'));
+                // setting bit 5 folds A-Z onto a-z and maps nothing else into a-z
+                V alpha = in_range(S::or_(x, S::set1(0x20)), 'a', 'z');
+                V word = S::or_(S::or_(alpha, in_range(x, '0', '9')), S::cmpeq(x, S::set1('\'')));
+                V sentence = S::or_(S::or_(S::cmpeq(x, S::set1('.')), S::cmpeq(x, S::set1('!'))),
+                                    S::cmpeq(x, S::set1('?')));
+                m.space |= (std::uint64_t)S::mask(space) << k;
+                m.word |= (std::uint64_t)S::mask(word) << k;
+                m.sentence |= (std::uint64_t)S::mask(sentence) << k;
+            }
+            out[b] = m;
+        }
+    }
+
+    static TextKernels table(const char* name) {
+        return {name, &classify};
+    }
+};
+
+} // namespace
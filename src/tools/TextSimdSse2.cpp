@@ -0,0 +1,24 @@
+#include <emmintrin.h>
+#include "TextSimdKernels.inl"
+
+namespace {
+
+struct Sse2 {
+    using V = __m128i;
+    static constexpr std::size_t W = 16;
+
+    static V load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static V set1(unsigned char c) { return _mm_set1_epi8((char)c); }
+    static V sub(V a, V b) { return _mm_sub_epi8(a, b); }
+    static V min(V a, V b) { return _mm_min_epu8(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+    static V cmpeq(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+    static std::uint32_t mask(V m) { return (std::uint32_t)_mm_movemask_epi8(m); }
+};
+
+} // namespace
+
+const TextKernels& textSse2Kernels() {
+    static const TextKernels k = TextVecKernels<Sse2>::table("sse2");
+    return k;
+}
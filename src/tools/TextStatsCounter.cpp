@@ -0,0 +1,432 @@
+#include "TextStatsCounter.h"
+#include "CpuFeatures.h"
+#include "Metrics.h"
+#include "TextSimd.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <set>
+
+/*
+ Implementation details:
+ - feed() classifies 64-byte blocks into space/word/sentence bitmasks (TextSimd kernels,
+   scalar fallback built from the 256-entry class table); counts are popcounts and word
+   boundaries are the set bits of word ^ (word << 1), walked with count-trailing-zeros.
+   The last partial block is classified from a zero-padded copy with the extra bits masked off.
+ - Words are string_views into the chunk; only a word crossing a chunk boundary is copied
+   (into `pending`), so file input is counted straight out of the mapping.
+ - Counting is case-insensitive inside WordCountTable; keys are lowercased and stopwords
+   dropped only when a summary is built.
+ - summary() ranks word Ids with nth_element and sorts only the top N,
+   lowercasing just the words it reports.
+ - RollingTextStats keeps non-stopwords in a std::set ordered by (count desc, word); a count
+   change re-keys the node through extract/insert, so ranking costs O(log V) per word and no
+   allocation, and a summary walks only the first topN nodes.
+ - With a window every line keeps its totals and word ids; eviction subtracts them. Words
+   whose count drops to zero stay interned until they outnumber the live ones, then the
+   interner is rebuilt, so memory follows the window's vocabulary, not the stream's.
+*/
+
+namespace {
+
+constexpr std::uint8_t C_SPACE = 1, C_WORD = 2, C_SENTENCE = 4;
+
+struct ClassTable {
+    std::uint8_t cls[256];
+    ClassTable() {
+        for (int c = 0; c < 256; ++c) {
+            std::uint8_t v = 0;
+            if (std::isspace(c)) v |= C_SPACE;
+            if (std::isalnum(c) || c == '\'') v |= C_WORD; // keep contractions as part of word
+            if (c == '.' || c == '!' || c == '?') v |= C_SENTENCE;
+            cls[c] = v;
+        }
+    }
+};
+
+const ClassTable CLASSES;
+
+constexpr std::size_t CLASSIFY_BATCH = 64; // blocks per kernel call (4 KiB of input)
+constexpr std::size_t COMPACT_SLACK = 4096;  // dead interned words tolerated before compacting
+
+inline unsigned popcount64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcountll(x);
+#else
+    unsigned n = 0;
+    for (; x; x &= x - 1) ++n;
+    return n;
+#endif
+}
+
+// x != 0
+inline unsigned ctz64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    unsigned n = 0;
+    for (; !(x & 1); x >>= 1) ++n;
+    return n;
+#endif
+}
+
+void classify_scalar(const char* p, std::size_t blocks, TextClassMasks* out) {
+    for (std::size_t b = 0; b < blocks; ++b, p += 64) {
+        std::uint64_t space = 0, word = 0, sentence = 0;
+        for (int k = 63; k >= 0; --k) { // highest byte first, so bit k ends up at position k
+            std::uint64_t c = CLASSES.cls[(unsigned char)p[k]];
+            space = (space << 1) | (c & C_SPACE);
+            word = (word << 1) | ((c >> 1) & 1);
+            sentence = (sentence << 1) | (c >> 2);
+        }
+        out[b] = {space, word, sentence};
+    }
+}
+
+const std::set<std::string, std::less<>> STOPWORDS = {
+    "the","and","is","in","it","of","to","a","an","that","this","on","for","with","as","are","was","were","be","by","or","from","at","which","but","not","they","their","i","you","he","she","we","his","her","them"
+};
+
+inline unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+bool is_stopword(std::string_view w) {
+    char buf[16];
+    if (w.size() > sizeof buf) return false; // all stopwords are short
+    for (size_t i = 0; i < w.size(); ++i) buf[i] = (char)lower((unsigned char)w[i]);
+    return STOPWORDS.count(std::string_view(buf, w.size())) != 0;
+}
+
+// a < b after lowercasing both
+bool less_nocase(std::string_view a, std::string_view b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+        return lower((unsigned char)x) < lower((unsigned char)y);
+    });
+}
+
+// the first topN of v under `before`, sorted; the rest is dropped
+template <class T, class Before>
+void keep_top(std::vector<T>& v, std::size_t topN, Before before) {
+    if (v.size() > topN) {
+        std::nth_element(v.begin(), v.begin() + (std::ptrdiff_t)topN, v.end(), before);
+        v.resize(topN);
+    }
+    std::sort(v.begin(), v.end(), before);
+}
+
+std::string lowered(std::string_view w) {
+    std::string lw(w);
+    for (char& c : lw) c = (char)lower((unsigned char)c);
+    return lw;
+}
+
+void fill_totals(TextStatsSummary& s, std::uint64_t chars, std::uint64_t nonSpace, std::uint64_t words,
+                 std::uint64_t marks, std::uint64_t letters) {
+    s.charsTotal = chars;
+    s.charsNoSpace = nonSpace;
+    s.words = words;
+    s.sentences = marks;
+    if (s.sentences == 0 && words > 0) s.sentences = 1; // approximate
+    if (words > 0) s.avgWordLength = (double)letters / (double)words;
+}
+
+// ranks the sketch (at most its fixed capacity) into s.topWords
+void sketch_top(const WordSketch& sketch, std::size_t topN, TextStatsSummary& s) {
+    std::vector<const WordSketch::Entry*> top;
+    sketch.forEach([&](const WordSketch::Entry& e) {
+        if (!is_stopword(e.word)) top.push_back(&e);
+    });
+    keep_top(top, topN, [](const WordSketch::Entry* a, const WordSketch::Entry* b) {
+        if (a->count != b->count) return a->count > b->count;
+        return a->word < b->word;
+    });
+    s.approximate = true;
+    for (const WordSketch::Entry* e : top) {
+        s.topWords.emplace_back(e->word, e->count);
+        s.maxOvercount = std::max(s.maxOvercount, e->error);
+    }
+}
+
+} // namespace
+
+TextStatsCounter::TextStatsCounter(std::size_t sketchBytes) : sketchBytes(sketchBytes) {
+    if (sketchBytes) sketch = std::make_unique<WordSketch>(sketchBytes);
+}
+
+void TextStatsCounter::addWord(std::string_view w, bool stable) {
+    ++words;
+    letters += w.size();
+    if (sketch) sketch->add(w);
+    else table.add(w, 1, stable);
+}
+
+std::size_t TextStatsCounter::splitAtWord(std::string_view text, std::size_t pos) {
+    auto word = [&](size_t i) { return (CLASSES.cls[(unsigned char)text[i]] & C_WORD) != 0; };
+    if (pos == 0) return 0;
+    while (pos < text.size() && word(pos - 1) && word(pos)) ++pos;
+    return std::min(pos, text.size());
+}
+
+// counting and the frequency table are one pass (feed); ranking is summary()
+static MetricTimer& METRIC_COUNT = metricTimer("suite_textstats_count", "Text Stats: counting chars, words and word frequencies");
+static MetricTimer& METRIC_MERGE = metricTimer("suite_textstats_merge", "Text Stats: merging per-thread counters");
+static MetricTimer& METRIC_FREQUENCY = metricTimer("suite_textstats_frequency", "Text Stats: collecting candidate words");
+static MetricTimer& METRIC_SORT = metricTimer("suite_textstats_sort", "Text Stats: selecting and sorting the top words");
+
+void TextStatsCounter::feed(std::string_view s, bool stable) {
+    MetricScope m(METRIC_COUNT);
+    constexpr size_t npos = std::string_view::npos;
+    charsTotal += s.size();
+    const TextKernels& kern = textKernels();
+    bool carry = !pending.empty();
+    size_t start = carry ? 0 : npos; // start of the open word in s
+    std::uint64_t space = 0, marks = 0;
+
+    auto scan = [&](size_t base, const TextClassMasks& m, std::uint64_t valid) {
+        space += popcount64(m.space & valid);
+        marks += popcount64(m.sentence & valid);
+        // bit i set where byte i and byte i-1 differ in being a word char
+        std::uint64_t edges = (m.word ^ ((m.word << 1) | (start != npos))) & valid;
+        while (edges) {
+            size_t i = base + ctz64(edges);
+            edges &= edges - 1;
+            if (start == npos) {
+                start = i;
+            } else if (carry) {
+                pending.append(s.data() + start, i - start);
+                addWord(pending, false);
+                pending.clear();
+                carry = false;
+                start = npos;
+            } else {
+                addWord(s.substr(start, i - start), stable);
+                start = npos;
+            }
+        }
+    };
+
+    TextClassMasks masks[CLASSIFY_BATCH];
+    size_t full = s.size() / 64;
+    for (size_t b = 0; b < full; b += CLASSIFY_BATCH) {
+        size_t n = std::min(CLASSIFY_BATCH, full - b);
+        kern.classify(s.data() + b * 64, n, masks);
+        for (size_t k = 0; k < n; ++k) scan((b + k) * 64, masks[k], ~std::uint64_t(0));
+    }
+    if (size_t rest = s.size() - full * 64) {
+        char tail[64] = {};
+        std::memcpy(tail, s.data() + full * 64, rest);
+        kern.classify(tail, 1, masks);
+        scan(full * 64, masks[0], (std::uint64_t(1) << rest) - 1);
+    }
+
+    charsNoSpace += s.size() - space;
+    sentenceMarks += marks;
+    if (start != npos) pending.append(s.data() + start, s.size() - start);
+}
+
+void TextStatsCounter::finish() {
+    if (pending.empty()) return;
+    addWord(pending, false);
+    pending.clear();
+}
+
+void TextStatsCounter::reset() {
+    *this = TextStatsCounter(sketchBytes);
+}
+
+void TextStatsCounter::merge(TextStatsCounter&& other) {
+    MetricScope m(METRIC_MERGE);
+    charsTotal += other.charsTotal;
+    charsNoSpace += other.charsNoSpace;
+    words += other.words;
+    sentenceMarks += other.sentenceMarks;
+    letters += other.letters;
+    table.merge(std::move(other.table));
+    if (sketch && other.sketch) sketch->merge(std::move(*other.sketch));
+    other.reset();
+}
+
+const TextKernels& textScalarKernels() {
+    static const TextKernels k = {"scalar", &classify_scalar};
+    return k;
+}
+
+const TextKernels& textKernels() {
+    static const TextKernels& k = [] () -> const TextKernels& {
+#ifdef SUITE_X86_SIMD
+        SimdLevel level = cpuSimdLevel();
+        if (level >= SimdLevel::Avx2) return textAvx2Kernels();
+        if (level >= SimdLevel::Sse2) return textSse2Kernels();
+#endif
+        return textScalarKernels();
+    }();
+    return k;
+}
+
+TextStatsSummary TextStatsCounter::summary(std::size_t topN) const {
+    TextStatsSummary s;
+    fill_totals(s, charsTotal, charsNoSpace, words, sentenceMarks, letters);
+    s.distinctWords = sketch ? sketch->size() : table.size();
+    s.wordMemoryBytes = sketch ? sketch->memoryBytes() : table.memoryBytes();
+    if (sketch) {
+        MetricScope m(METRIC_SORT);
+        sketch_top(*sketch, topN, s);
+        return s;
+    }
+
+    std::vector<WordCountTable::Id> top;
+    {
+        MetricScope m(METRIC_FREQUENCY);
+        top.reserve(table.size());
+        for (WordCountTable::Id id = 0; id < table.size(); ++id)
+            if (!is_stopword(table.word(id))) top.push_back(id);
+    }
+    MetricScope m(METRIC_SORT);
+    keep_top(top, topN, [this](WordCountTable::Id a, WordCountTable::Id b) {
+        if (table.count(a) != table.count(b)) return table.count(a) > table.count(b);
+        return less_nocase(table.word(a), table.word(b));
+    });
+    for (WordCountTable::Id id : top) s.topWords.emplace_back(lowered(table.word(id)), table.count(id));
+    return s;
+}
+
+RollingTextStats::RollingTextStats(std::size_t maxLines, Clock::duration maxAge, std::size_t sketchBytes)
+    : maxLines(maxLines), maxAge(maxAge), ranked(RankLess{this}) {
+    if (sketchBytes && !windowed()) sketch = std::make_unique<WordSketch>(sketchBytes);
+}
+
+bool RollingTextStats::RankLess::operator()(Id a, Id b) const {
+    std::uint64_t ca = self->counts[a], cb = self->counts[b];
+    if (ca != cb) return ca > cb;
+    return less_nocase(self->words.word(a), self->words.word(b));
+}
+
+void RollingTextStats::bump(Id id, bool up) {
+    std::uint64_t before = counts[id];
+    if (stopword[id]) {
+        counts[id] = up ? before + 1 : before - 1;
+    } else if (before > 0) {
+        // re-key the node in place: no allocation
+        auto node = ranked.extract(where[id]);
+        counts[id] = up ? before + 1 : before - 1;
+        where[id] = counts[id] ? ranked.insert(std::move(node)).position : ranked.end();
+    } else {
+        counts[id] = 1;
+        where[id] = ranked.insert(id).first;
+    }
+    if (before == 0) ++live;
+    else if (counts[id] == 0) --live;
+}
+
+void RollingTextStats::addLine(std::string_view line, Clock::time_point now) {
+    Line rec;
+    rec.time = now;
+    Totals& t = rec.totals;
+    t.chars = line.size() + 1; // the newline
+    std::uint64_t space = 1;
+    lineWords.clear();
+    size_t start = std::string_view::npos;
+    for (size_t i = 0; i <= line.size(); ++i) {
+        std::uint8_t c = i < line.size() ? CLASSES.cls[(unsigned char)line[i]] : C_SPACE;
+        if (i < line.size()) {
+            space += c & C_SPACE;
+            t.marks += (c >> 2) & 1;
+        }
+        if (c & C_WORD) {
+            if (start == std::string_view::npos) start = i;
+        } else if (start != std::string_view::npos) {
+            lineWords.push_back(line.substr(start, i - start));
+            t.letters += i - start;
+            start = std::string_view::npos;
+        }
+    }
+    t.nonSpace = t.chars - space;
+    t.words = lineWords.size();
+
+    for (std::string_view w : lineWords) {
+        if (sketch) {
+            sketch->add(w);
+            continue;
+        }
+        Id id = words.intern(w);
+        if (id == counts.size()) {
+            counts.push_back(0);
+            stopword.push_back(is_stopword(w));
+            where.push_back(ranked.end());
+        }
+        bump(id, true);
+        if (windowed()) windowWords.push_back(id);
+    }
+
+    totals.chars += t.chars;
+    totals.nonSpace += t.nonSpace;
+    totals.words += t.words;
+    totals.marks += t.marks;
+    totals.letters += t.letters;
+    ++lineCount;
+    if (!windowed()) return;
+    window.push_back(rec);
+    while (maxLines && window.size() > maxLines) evictFront();
+    expire(now);
+}
+
+void RollingTextStats::expire(Clock::time_point now) {
+    if (maxAge == Clock::duration::zero()) return;
+    while (!window.empty() && now - window.front().time > maxAge) evictFront();
+}
+
+void RollingTextStats::evictFront() {
+    const Totals& t = window.front().totals;
+    for (std::uint64_t i = 0; i < t.words; ++i) {
+        bump(windowWords.front(), false);
+        windowWords.pop_front();
+    }
+    totals.chars -= t.chars;
+    totals.nonSpace -= t.nonSpace;
+    totals.words -= t.words;
+    totals.marks -= t.marks;
+    totals.letters -= t.letters;
+    --lineCount;
+    window.pop_front();
+    // words that left the window still occupy the interner; rebuild once they dominate
+    if (words.size() > 2 * live + COMPACT_SLACK) compact();
+}
+
+void RollingTextStats::compact() {
+    WordInterner fresh;
+    std::vector<Id> remap(words.size(), WordInterner::NONE);
+    std::vector<std::uint64_t> freshCounts;
+    std::vector<bool> freshStop;
+    for (Id id = 0; id < words.size(); ++id) {
+        if (!counts[id]) continue;
+        remap[id] = fresh.intern(words.word(id));
+        freshCounts.push_back(counts[id]);
+        freshStop.push_back(stopword[id]);
+    }
+    for (Id& id : windowWords) id = remap[id];
+    ranked.clear();
+    words = std::move(fresh);
+    counts = std::move(freshCounts);
+    stopword = std::move(freshStop);
+    where.assign(counts.size(), ranked.end());
+    for (Id id = 0; id < counts.size(); ++id)
+        if (!stopword[id]) where[id] = ranked.insert(id).first;
+}
+
+TextStatsSummary RollingTextStats::summary(std::size_t topN) const {
+    TextStatsSummary s;
+    fill_totals(s, totals.chars, totals.nonSpace, totals.words, totals.marks, totals.letters);
+    if (sketch) {
+        s.distinctWords = sketch->size();
+        s.wordMemoryBytes = sketch->memoryBytes();
+        sketch_top(*sketch, topN, s);
+        return s;
+    }
+    s.distinctWords = live;
+    s.wordMemoryBytes = words.memoryBytes() + counts.capacity() * sizeof(std::uint64_t) +
+                        ranked.size() * 4 * sizeof(void*) + windowWords.size() * sizeof(Id);
+    for (auto it = ranked.begin(); it != ranked.end() && s.topWords.size() < topN; ++it)
+        s.topWords.emplace_back(lowered(words.word(*it)), counts[*it]);
+    return s;
+}
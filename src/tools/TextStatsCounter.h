@@ -0,0 +1,139 @@
+#pragma once
+#include "WordCountTable.h"
+#include "WordSketch.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ TextStatsCounter - 文本统计的单遍累加器
+ - 一次扫描同时得到字符数、非空白字符数、单词数、句末标点数、单词总长度和词频
+ - 输入可以分块喂入（feed），跨块的单词会被拼接，结果与一次性处理整段文本相同
+ - 内存只与词汇量有关，与输入长度无关
+ - 并行：在单词边界处切分输入（splitAtWord），每个线程一个计数器，最后 merge；
+   停用词在 summary 时才过滤，计数路径上不需要转小写或查停用词表
+ - 词频有两种模式：精确（WordCountTable，内存随词汇量增长）和近似（WordSketch，
+   固定内存预算，带误差界）；其他统计量在两种模式下都是精确的
+ - summary 只部分排序（nth_element 后排序前 N 个），不对整个词表排序
+ - RollingTextStats：逐行更新的滚动统计，可选按行数或时间的滑动窗口（旧行的贡献被扣除），
+   高频词按计数有序维护，summary 的代价是 O(topN)，适合对无限的日志流频繁查询
+*/
+struct TextStatsSummary {
+    std::uint64_t charsTotal = 0;
+    std::uint64_t charsNoSpace = 0;
+    std::uint64_t words = 0;
+    std::uint64_t sentences = 0;
+    double avgWordLength = 0.0;
+    // lowercased, stopwords removed; by count descending, then by word
+    std::vector<std::pair<std::string, std::uint64_t>> topWords;
+    // approximate mode: each reported count exceeds the true count by at most maxOvercount
+    bool approximate = false;
+    std::uint64_t maxOvercount = 0;
+    // word storage: distinct words held (at most the sketch capacity) and their bytes
+    std::uint64_t distinctWords = 0;
+    std::uint64_t wordMemoryBytes = 0;
+};
+
+class TextStatsCounter {
+public:
+    // sketchBytes = 0: exact word counts; otherwise approximate top words within that budget
+    explicit TextStatsCounter(std::size_t sketchBytes = 0);
+
+    // the next piece of input; a word cut at the end of chunk continues in the next call.
+    // stable: chunk outlives this counter (e.g. a mapped file), so words are not copied
+    void feed(std::string_view chunk, bool stable = false);
+    // end of input: counts a word left open by the last chunk
+    void finish();
+    void reset();
+    // adds the counts of another finished counter; other is left empty
+    void merge(TextStatsCounter&& other);
+
+    // smallest position >= pos that does not fall inside a word of text
+    static std::size_t splitAtWord(std::string_view text, std::size_t pos);
+
+    TextStatsSummary summary(std::size_t topN) const;
+
+private:
+    std::uint64_t charsTotal = 0;
+    std::uint64_t charsNoSpace = 0;
+    std::uint64_t words = 0;
+    std::uint64_t sentenceMarks = 0;
+    std::uint64_t letters = 0;
+    std::size_t sketchBytes;
+    WordCountTable table;
+    std::unique_ptr<WordSketch> sketch; // approximate mode, replaces table
+    std::string pending; // word prefix from the previous chunk
+
+    void addWord(std::string_view w, bool stable);
+};
+
+class RollingTextStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // maxLines / maxAge of zero: no limit. Without a window, sketchBytes > 0 approximates the
+    // top words within that budget (a window needs exact counts to evict)
+    explicit RollingTextStats(std::size_t maxLines = 0, Clock::duration maxAge = Clock::duration::zero(),
+                              std::size_t sketchBytes = 0);
+
+    // the ranking keeps a pointer to this object
+    RollingTextStats(const RollingTextStats&) = delete;
+    RollingTextStats& operator=(const RollingTextStats&) = delete;
+
+    // one line without its terminator (counted as a newline); evicts what left the window
+    void addLine(std::string_view line, Clock::time_point now = Clock::now());
+    // evicts lines older than maxAge
+    void expire(Clock::time_point now = Clock::now());
+
+    // lines currently counted
+    std::size_t lines() const { return lineCount; }
+    // O(topN); call expire() first for an up-to-date time window
+    TextStatsSummary summary(std::size_t topN) const;
+
+private:
+    using Id = WordInterner::Id;
+
+    struct Totals {
+        std::uint64_t chars = 0;
+        std::uint64_t nonSpace = 0;
+        std::uint64_t words = 0;
+        std::uint64_t marks = 0;
+        std::uint64_t letters = 0;
+    };
+    struct Line {
+        Clock::time_point time;
+        Totals totals;
+    };
+    // count descending, then lowercased word
+    struct RankLess {
+        const RollingTextStats* self;
+        bool operator()(Id a, Id b) const;
+    };
+
+    std::size_t maxLines;
+    Clock::duration maxAge;
+    std::size_t lineCount = 0;
+    Totals totals;
+    std::deque<Line> window;          // only with a window
+    std::deque<Id> windowWords;       // word ids of the lines in window, in order
+    WordInterner words;
+    std::vector<std::uint64_t> counts; // by Id
+    std::vector<bool> stopword;        // by Id
+    std::set<Id, RankLess> ranked;     // non-stopwords with count > 0
+    std::vector<std::set<Id, RankLess>::iterator> where; // by Id, ranked.end() if absent
+    std::size_t live = 0;              // ids with count > 0
+    std::unique_ptr<WordSketch> sketch;
+    std::vector<std::string_view> lineWords;
+
+    bool windowed() const { return maxLines != 0 || maxAge != Clock::duration::zero(); }
+    void bump(Id id, bool up);
+    void evictFront();
+    void compact();
+};
@@ -1,124 +1,207 @@
 #include "TextStatsTool.h"
+#include "ConfigManager.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <chrono>
 #include <iostream>
-#include <sstream>
+#include <fstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <algorithm>
-#include <cctype>
-#include <set>
-#include <limits>
-
-static inline std::string to_lower(const std::string& s) {
-    std::string o; o.reserve(s.size());
-    for (char c : s) o.push_back((char)std::tolower((unsigned char)c));
-    return o;
+#include <stdexcept>
+#include <thread>
+
+/*
+ Implementation details:
+ - All statistics come from TextStatsCounter in a single pass.
+ - Mapped files are fed in MAP_WINDOW pieces and each processed window is released,
+   so resident memory stays bounded on multi-GB inputs.
+ - Streams (stdin, pipes) are read in STREAM_CHUNK blocks; words crossing a block
+   boundary are joined by the counter.
+ - In approximate mode every part counter gets its own sketch of sketchBytes; the sketches
+   merge with the same error bound.
+ - follow() is line based: RollingTextStats updates its aggregates per line, so a periodic
+   summary never rescans the input.
+ - Mapped files of at least MIN_PART_BYTES per thread are cut at word boundaries; each
+   part is counted into its own TextStatsCounter (words stay views into the mapping)
+   and the counters are merged in order.
+*/
+
+static constexpr std::size_t STREAM_CHUNK = 1 << 20;
+static constexpr std::size_t MAP_WINDOW = 16 << 20;
+static constexpr std::size_t MIN_PART_BYTES = 4 << 20;
+
+// missing or mistyped values fall back to the TextStatsOptions defaults
+static const ConfigKey<std::size_t> CFG_TOP_N{"textstats", "top_n", TextStatsOptions().topN};
+static const ConfigKey<bool> CFG_APPROXIMATE{"textstats", "approximate", TextStatsOptions().approximate};
+static const ConfigKey<std::size_t> CFG_SKETCH_KB{"textstats", "sketch_kb", TextStatsOptions().sketchBytes >> 10};
+static const ConfigKey<std::size_t> CFG_WINDOW_LINES{"textstats", "window_lines", TextStatsOptions().windowLines};
+static const ConfigKey<double> CFG_WINDOW_SECONDS{"textstats", "window_seconds", TextStatsOptions().windowSeconds};
+
+static TextStatsCounter make_counter(const TextStatsOptions& opt) {
+    return TextStatsCounter(opt.approximate ? opt.sketchBytes : 0);
 }
 
-static inline bool is_word_char(char c) {
-    return std::isalnum((unsigned char)c) || c == '\''; // keep contractions as part of word
+TextStatsOptions TextStatsTool::loadOptions() {
+    const ConfigSnapshot& cfg = ConfigManager::instance().current();
+    TextStatsOptions opt;
+    opt.topN = std::max<std::size_t>(1, cfg.get(CFG_TOP_N));
+    opt.approximate = cfg.get(CFG_APPROXIMATE);
+    opt.sketchBytes = cfg.get(CFG_SKETCH_KB) << 10;
+    opt.windowLines = cfg.get(CFG_WINDOW_LINES);
+    opt.windowSeconds = std::max(0.0, cfg.get(CFG_WINDOW_SECONDS));
+    return opt;
 }
 
-static std::vector<std::string> tokenize_words(const std::string& text) {
-    std::vector<std::string> words;
-    std::string cur;
-    for (size_t i = 0; i < text.size(); ++i) {
-        char c = text[i];
-        if (is_word_char(c)) cur.push_back(c);
-        else {
-            if (!cur.empty()) {
-                words.push_back(cur);
-                cur.clear();
-            }
+TextStatsSummary TextStatsTool::analyzeStream(std::istream& in, const TextStatsOptions& opt) {
+    TextStatsCounter counter = make_counter(opt);
+    std::vector<char> buf(STREAM_CHUNK);
+    while (in) {
+        in.read(buf.data(), (std::streamsize)buf.size());
+        std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        counter.feed(std::string_view(buf.data(), (size_t)got));
+    }
+    counter.finish();
+    return counter.summary(opt.topN);
+}
+
+TextStatsSummary TextStatsTool::analyzeFile(const std::string& path, const TextStatsOptions& opt, unsigned threads) {
+    if (path == "-") return analyzeStream(std::cin, opt);
+    if (!MappedFile::mappable(path)) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open " + path);
+        return analyzeStream(in, opt);
+    }
+
+    MappedFile file(path);
+    std::string_view text(file.data(), file.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t parts = std::max<size_t>(1, std::min<size_t>(threads, text.size() / MIN_PART_BYTES));
+
+    std::vector<size_t> bounds(parts + 1, text.size());
+    bounds[0] = 0;
+    for (size_t i = 1; i < parts; ++i) bounds[i] = TextStatsCounter::splitAtWord(text, text.size() / parts * i);
+
+    std::vector<TextStatsCounter> counters;
+    counters.reserve(parts);
+    for (size_t i = 0; i < parts; ++i) counters.push_back(make_counter(opt));
+    auto count_part = [&](size_t i) {
+        for (size_t off = bounds[i]; off < bounds[i + 1]; off += MAP_WINDOW) {
+            size_t len = std::min(MAP_WINDOW, bounds[i + 1] - off);
+            counters[i].feed(text.substr(off, len), true);
+            file.release(off, len);
+        }
+        counters[i].finish();
+    };
+    if (parts == 1) {
+        count_part(0);
+    } else {
+        ThreadPool pool((unsigned)parts);
+        for (size_t i = 0; i < parts; ++i) pool.submit([&count_part, i] { count_part(i); });
+        pool.wait();
+    }
+    for (size_t i = 1; i < parts; ++i) counters[0].merge(std::move(counters[i]));
+    return counters[0].summary(opt.topN);
+}
+
+void TextStatsTool::follow(std::istream& in, std::ostream& out, const TextStatsOptions& opt, double intervalSeconds) {
+    using Clock = RollingTextStats::Clock;
+    auto seconds = [](double s) { return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s)); };
+    RollingTextStats stats(opt.windowLines, seconds(opt.windowSeconds), opt.approximate ? opt.sketchBytes : 0);
+    auto report = [&](Clock::time_point now) {
+        stats.expire(now);
+        printSummary(out, stats.summary(opt.topN), opt.topN);
+        out << "Lines counted: " << stats.lines() << std::endl;
+    };
+
+    Clock::time_point next = Clock::now() + seconds(intervalSeconds);
+    std::string line;
+    while (std::getline(in, line)) {
+        Clock::time_point now = Clock::now();
+        stats.addLine(line, now);
+        if (now >= next) {
+            report(now);
+            next = now + seconds(intervalSeconds);
         }
     }
-    if (!cur.empty()) words.push_back(cur);
-    return words;
+    report(Clock::now());
 }
 
-static const std::set<std::string> STOPWORDS = {
-    "the","and","is","in","it","of","to","a","an","that","this","on","for","with","as","are","was","were","be","by","or","from","at","which","but","not","they","their","i","you","he","she","we","his","her","them"
-};
+void TextStatsTool::printSummary(std::ostream& out, const TextStatsSummary& s, std::size_t topN) {
+    ToolOutput text;
+    formatSummary(text, s, topN);
+    out << text.view();
+}
+
+void TextStatsTool::formatSummary(ToolOutput& out, const TextStatsSummary& s, std::size_t topN) {
+    out << "\n--- Summary ---\n";
+    out << "Characters (total): " << s.charsTotal << "\n";
+    out << "Characters (no spaces): " << s.charsNoSpace << "\n";
+    out << "Words: " << s.words << "\n";
+    out << "Sentences: " << s.sentences << "\n";
+    out << "Average word length: " << (s.words > 0 ? s.avgWordLength : 0.0) << "\n";
+
+    out << "Top " << topN << " words (excluding common stopwords";
+    if (s.approximate) out << "; approximate, counts high by at most " << s.maxOvercount;
+    out << "):\n";
+    for (auto& w : s.topWords) {
+        out << "  " << w.first << " : " << w.second << "\n";
+    }
+    if (s.topWords.empty()) out << "  (no words or only stopwords found)\n";
+}
+
+void TextStatsTool::execute(const ToolArgs& args, ToolOutput& out) {
+    TextStatsOptions opt = loadOptions();
+    TextStatsCounter counter = make_counter(opt);
+    counter.feed(args.text());
+    counter.finish();
+    formatSummary(out, counter.summary(opt.topN), opt.topN);
+}
 
 void TextStatsTool::run() {
     std::cout << "\n=== Text Stats ===\n";
     std::cout << "请输入多行文本，完成后输入一个空行（直接回车）结束输入。\n";
-    std::cout << "输入命令: summary (显示统计) ; quit (退出)\n";
+    std::cout << "输入命令: summary (显示统计) ; file <路径> (统计整个文件) ; quit (退出)\n";
 
-    // read multi-line input until an empty line or 'quit' typed alone
+    // read multi-line input until an empty line or 'quit' typed alone; lines are counted as
+    // they arrive, so nothing is buffered (execute() is the whole-text form of the same summary)
+    TextStatsOptions opt = loadOptions();
     std::string line;
-    std::string text;
+    TextStatsCounter counter = make_counter(opt);
+    ToolOutput out;
     while (true) {
-        std::string chunk;
-        bool anyInput = false;
+        bool eof = false;
         while (true) {
-            if (!std::getline(std::cin, line)) break;
+            if (!std::getline(std::cin, line)) { eof = true; break; }
             if (line.empty()) break; // empty line ends text input
             if (line == "quit") return;
             if (line == "summary") {
                 // user wants to show summary of current collected text
                 break;
             }
-            anyInput = true;
-            text += line;
-            text.push_back('\n');
-        }
-
-        // calculate stats for current 'text' (could be empty)
-        int chars_total = (int)text.size();
-        int chars_no_space = 0;
-        for (char c : text) if (!std::isspace((unsigned char)c)) ++chars_no_space;
-
-        auto words = tokenize_words(text);
-        int word_count = (int)words.size();
-
-        // sentence count by counting '.', '!', '?'
-        int sentence_count = 0;
-        for (char c : text) if (c == '.' || c == '!' || c == '?') ++sentence_count;
-        if (sentence_count == 0 && word_count > 0) sentence_count = 1; // approximate
-
-        double avg_word_len = 0.0;
-        if (word_count > 0) {
-            int total_letters = 0;
-            for (auto &w : words) total_letters += (int)w.size();
-            avg_word_len = (double)total_letters / word_count;
-        }
-
-        // frequency (lowercased), filter stopwords
-        std::unordered_map<std::string, int> freq;
-        for (auto &w : words) {
-            std::string lw = to_lower(w);
-            if (STOPWORDS.count(lw)) continue;
-            ++freq[lw];
+            if (line.rfind("file ", 0) == 0) {
+                std::string path = line.substr(5);
+                try {
+                    printSummary(std::cout, analyzeFile(path, opt), opt.topN);
+                } catch (const std::exception& e) {
+                    std::cout << "错误: " << e.what() << "\n";
+                }
+                continue;
+            }
+            counter.feed(line);
+            counter.feed("\n");
         }
 
-        // top N
-        std::vector<std::pair<std::string,int>> freqv;
-        freqv.reserve(freq.size());
-        for (auto &p : freq) freqv.emplace_back(p.first, p.second);
-        std::sort(freqv.begin(), freqv.end(), [](const auto& a, const auto& b){
-            if (a.second != b.second) return a.second > b.second;
-            return a.first < b.first;
-        });
-
-        // output summary
-        std::cout << "\n--- Summary ---\n";
-        std::cout << "Characters (total): " << chars_total << "\n";
-        std::cout << "Characters (no spaces): " << chars_no_space << "\n";
-        std::cout << "Words: " << word_count << "\n";
-        std::cout << "Sentences: " << sentence_count << "\n";
-        std::cout << "Average word length: " << (word_count>0 ? avg_word_len : 0.0) << "\n";
-
-        int topN = 8;
-        std::cout << "Top " << topN << " words (excluding common stopwords):\n";
-        for (int i = 0; i < (int)freqv.size() && i < topN; ++i) {
-            std::cout << "  " << freqv[i].first << " : " << freqv[i].second << "\n";
-        }
-        if (freqv.empty()) std::cout << "  (no words or only stopwords found)\n";
+        // calculate stats for the text collected so far (could be empty)
+        counter.finish();
+        out.clear();
+        formatSummary(out, counter.summary(opt.topN), opt.topN);
+        std::cout << out.view();
 
-        // clear text buffer and ask user whether to continue or quit
-        text.clear();
+        // start counting afresh and ask user whether to continue or quit
+        counter.reset();
+        if (eof) return;
         std::cout << "\n继续输入新文本或输入 'quit' 返回主菜单。\n";
     }
 }
-
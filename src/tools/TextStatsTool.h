@@ -1,19 +1,60 @@
 #pragma once
 #include "Tool.h"
+#include "TextStatsCounter.h"
+#include <cstddef>
+#include <iosfwd>
 #include <string>
 
 /*
  TextStatsTool - enhanced
  - 支持多行输入（直到空行结束）
  - 命令:
-     summary -> 输出统计信息
-     quit    -> 返回主菜单
+     summary     -> 输出统计信息
+     file <路径> -> 统计整个文件（内存映射，单遍扫描，内存占用与文件大小无关）
+     quit        -> 返回主菜单
  - 输出: 字符总数、字符（不含空白）、单词数、句子数、平均单词长度、前 N 常见词
+ - 命令行: --textstats [file|-] [--threads N] 直接统计文件或标准输入（按固定大小分块读取）
+ - 大文件在单词边界处切分，多线程各自计数后合并，结果与单线程完全相同
+ - config.json 的 "textstats" 段：top_n（默认 8）、approximate（近似高频词，默认 false）、
+   sketch_kb（近似模式下每个计数线程的内存预算，默认 1024 KiB）、
+   window_lines / window_seconds（follow 模式的滑动窗口，0 表示不限）
+ - follow 模式：逐行读取持续追加的输入（如 tail -f），定期输出窗口内的统计，每次输出是 O(topN)
 */
+struct TextStatsOptions {
+    std::size_t topN = 8;
+    // approximate top words (WordSketch) within sketchBytes per counting thread
+    bool approximate = false;
+    std::size_t sketchBytes = 1 << 20;
+    // follow mode: only the last windowLines lines / windowSeconds seconds count (0 = no limit)
+    std::size_t windowLines = 0;
+    double windowSeconds = 0;
+};
+
 class TextStatsTool : public Tool {
 public:
+
     std::string name() const override { return "Text Stats"; }
-    std::string description() const override { return "Count characters/words/sentences and top words"; }
+    static constexpr const char* DESCRIPTION = "Count characters/words/sentences and top words";
+    std::string description() const override { return DESCRIPTION; }
     void run() override;
-};
+    // the whole input is the text; replies with the same summary as run()
+    void execute(const ToolArgs& args, ToolOutput& out) override;
 
+    // one pass over a file: memory-mapped when possible, otherwise read as a stream;
+    // "-" reads standard input. Mapped files are split at word boundaries and counted
+    // on `threads` threads (0 = all cores)
+    static TextStatsSummary analyzeFile(const std::string& path, const TextStatsOptions& opt = TextStatsOptions(),
+                                        unsigned threads = 0);
+    // one pass over a stream, read in fixed-size chunks
+    static TextStatsSummary analyzeStream(std::istream& in, const TextStatsOptions& opt = TextStatsOptions());
+
+    // rolling statistics of a line stream: a summary every intervalSeconds (when a line
+    // arrives) and one at end of input
+    static void follow(std::istream& in, std::ostream& out, const TextStatsOptions& opt, double intervalSeconds);
+
+    // the "textstats" section of config.json; defaults for missing or invalid values
+    static TextStatsOptions loadOptions();
+
+    static void printSummary(std::ostream& out, const TextStatsSummary& s, std::size_t topN);
+    static void formatSummary(ToolOutput& out, const TextStatsSummary& s, std::size_t topN);
+};
@@ -0,0 +1,325 @@
+#include "UnitBatch.h"
+#include "CalcSimd.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+/*
+ Implementation details:
+ - The table is a constexpr array built from the Units constants, so the runtime path uses
+   the same factors the compile-time checks do. Lookups scan it linearly; they happen once
+   per conversion, not per value.
+ - convertUnits runs the calculator's `affine` kernel (CalcSimd.h), so it uses the same
+   runtime-selected AVX2 / SSE2 / scalar level as column batches.
+ - convertUnitCsv reads 1 MiB at a time and handles the complete lines in it: selected cells
+   are located and parsed into one array, converted in a single convertUnits call, and the
+   block is written back as the text between cells plus the formatted values. The partial
+   last line is carried into the next read.
+ - Quoted fields ("a,b") are skipped over correctly; a quoted number is written back unquoted.
+   Quoted fields spanning lines are not supported.
+*/
+
+namespace {
+
+constexpr const char* LENGTH = "length";
+constexpr const char* MASS = "mass";
+constexpr const char* TIME = "time";
+constexpr const char* TEMPERATURE = "temperature";
+constexpr const char* DATA = "data";
+constexpr const char* SPEED = "speed";
+constexpr const char* RATE = "data rate";
+
+constexpr UnitDef UNIT_TABLE[] = {
+    unitDef("m", "meter meters metre metres", LENGTH, Units::m),
+    unitDef("km", "kilometer kilometers", LENGTH, Units::km),
+    unitDef("cm", "centimeter centimeters", LENGTH, Units::cm),
+    unitDef("mm", "millimeter millimeters", LENGTH, Units::mm),
+    unitDef("um", "micrometer micrometers micron", LENGTH, Units::um),
+    unitDef("nm", "nanometer nanometers", LENGTH, Units::nm),
+    unitDef("in", "inch inches", LENGTH, Units::in),
+    unitDef("ft", "foot feet", LENGTH, Units::ft),
+    unitDef("yd", "yard yards", LENGTH, Units::yd),
+    unitDef("mi", "mile miles", LENGTH, Units::mi),
+    unitDef("nmi", "nautical-mile nautical-miles", LENGTH, Units::nmi),
+
+    unitDef("kg", "kilogram kilograms", MASS, Units::kg),
+    unitDef("g", "gram grams", MASS, Units::g),
+    unitDef("mg", "milligram milligrams", MASS, Units::mg),
+    unitDef("t", "tonne tonnes", MASS, Units::t),
+    unitDef("lb", "pound pounds lbs", MASS, Units::lb),
+    unitDef("oz", "ounce ounces", MASS, Units::oz),
+    unitDef("st", "stone stones", MASS, Units::st),
+
+    unitDef("s", "second seconds sec", TIME, Units::s),
+    unitDef("ms", "millisecond milliseconds", TIME, Units::ms),
+    unitDef("us", "microsecond microseconds", TIME, Units::us),
+    unitDef("ns", "nanosecond nanoseconds", TIME, Units::ns),
+    unitDef("min", "minute minutes", TIME, Units::min),
+    unitDef("h", "hour hours hr", TIME, Units::h),
+    unitDef("d", "day days", TIME, Units::d),
+    unitDef("wk", "week weeks", TIME, Units::wk),
+    unitDef("yr", "year years", TIME, Units::yr),
+
+    unitDef("K", "kelvin", TEMPERATURE, Units::K),
+    unitDef("C", "celsius degc", TEMPERATURE, Units::degC),
+    unitDef("F", "fahrenheit degf", TEMPERATURE, Units::degF),
+    unitDef("R", "rankine degr", TEMPERATURE, Units::degR),
+
+    unitDef("B", "byte bytes", DATA, Units::B),
+    unitDef("bit", "bits", DATA, Units::bit),
+    unitDef("kB", "kilobyte kilobytes", DATA, Units::kB),
+    unitDef("MB", "megabyte megabytes", DATA, Units::MB),
+    unitDef("GB", "gigabyte gigabytes", DATA, Units::GB),
+    unitDef("TB", "terabyte terabytes", DATA, Units::TB),
+    unitDef("PB", "petabyte petabytes", DATA, Units::PB),
+    unitDef("KiB", "kibibyte kibibytes", DATA, Units::KiB),
+    unitDef("MiB", "mebibyte mebibytes", DATA, Units::MiB),
+    unitDef("GiB", "gibibyte gibibytes", DATA, Units::GiB),
+    unitDef("TiB", "tebibyte tebibytes", DATA, Units::TiB),
+    unitDef("PiB", "pebibyte pebibytes", DATA, Units::PiB),
+    unitDef("kbit", "kilobit kilobits", DATA, Units::kbit),
+    unitDef("Mbit", "megabit megabits", DATA, Units::Mbit),
+    unitDef("Gbit", "gigabit gigabits", DATA, Units::Gbit),
+
+    unitDef("m/s", "", SPEED, Units::m / Units::s),
+    unitDef("km/h", "kph", SPEED, Units::km / Units::h),
+    unitDef("mph", "", SPEED, Units::mi / Units::h),
+    unitDef("kn", "knot knots", SPEED, Units::nmi / Units::h),
+    unitDef("ft/s", "", SPEED, Units::ft / Units::s),
+
+    unitDef("B/s", "", RATE, Units::B / Units::s),
+    unitDef("kB/s", "", RATE, Units::kB / Units::s),
+    unitDef("MB/s", "", RATE, Units::MB / Units::s),
+    unitDef("MiB/s", "", RATE, Units::MiB / Units::s),
+    unitDef("Mbit/s", "mbps", RATE, Units::Mbit / Units::s),
+    unitDef("Gbit/s", "gbps", RATE, Units::Gbit / Units::s),
+};
+
+bool same_word_ci(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i])) return false;
+    return true;
+}
+
+bool has_name(const UnitDef& u, std::string_view name) {
+    std::string_view names = u.names;
+    while (!names.empty()) {
+        std::size_t sp = names.find(' ');
+        if (same_word_ci(names.substr(0, sp), name)) return true;
+        if (sp == std::string_view::npos) break;
+        names.remove_prefix(sp + 1);
+    }
+    return false;
+}
+
+const UnitDef& require_unit(std::string_view name) {
+    const UnitDef* u = findUnit(name);
+    if (!u) throw std::runtime_error("Unknown unit: " + std::string(name));
+    return *u;
+}
+
+// ---- CSV ----
+
+constexpr std::size_t READ_BLOCK = 1 << 20;
+
+struct Span {
+    std::size_t begin, end; // offsets into the block
+};
+
+// the next field of line [pos, end) starting at pos; returns its span and moves pos past the delimiter
+Span next_field(const std::string& buf, std::size_t& pos, std::size_t end, char delim) {
+    std::size_t start = pos;
+    bool quoted = false;
+    while (pos < end) {
+        char c = buf[pos];
+        if (c == '"') quoted = !quoted; // "" inside quotes toggles twice
+        else if (c == delim && !quoted) break;
+        ++pos;
+    }
+    Span s{start, pos};
+    if (pos < end) ++pos;
+    return s;
+}
+
+// field text without surrounding spaces and quotes
+std::string_view field_text(const std::string& buf, Span s) {
+    std::string_view v(buf.data() + s.begin, s.end - s.begin);
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    if (v.size() >= 2 && v.front() == '"' && v.back() == '"') v = v.substr(1, v.size() - 2);
+    return v;
+}
+
+bool parse_number(std::string_view v, double* out) {
+    if (!v.empty() && v.front() == '+') v.remove_prefix(1);
+    if (v.empty()) return false;
+    auto r = std::from_chars(v.data(), v.data() + v.size(), *out);
+    return r.ec == std::errc() && r.ptr == v.data() + v.size();
+}
+
+bool all_digits(const std::string& s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// the line [begin, end) without its '\n' and any '\r' before it
+std::size_t content_end(const std::string& buf, std::size_t begin, std::size_t end) {
+    if (end > begin && buf[end - 1] == '\n') --end;
+    if (end > begin && buf[end - 1] == '\r') --end;
+    return end;
+}
+
+class CsvConverter {
+public:
+    CsvConverter(const UnitCsvOptions& opt, std::ostream& out) : opt(opt), out(out) {}
+
+    // whole lines [0, cut) of buf
+    void block(const std::string& buf, std::size_t cut) {
+        std::size_t first = 0;
+        if (!resolved) {
+            first = resolve(buf, cut);
+            out.write(buf.data(), (std::streamsize)first);
+        }
+
+        cells.clear();
+        values.clear();
+        for (std::size_t pos = first; pos < cut;) {
+            std::size_t nl = buf.find('\n', pos);
+            std::size_t next = nl == std::string::npos || nl >= cut ? cut : nl + 1;
+            std::size_t end = content_end(buf, pos, next);
+            ++stats.rows;
+
+            // walk the fields up to the last selected one
+            std::size_t at = pos, field = 0, want = 0;
+            bool more = true;
+            while (more && want < columns.size()) {
+                Span s = next_field(buf, at, end, opt.delimiter);
+                more = s.end < end; // stopped at a delimiter
+                if (field++ != columns[want]) continue;
+                ++want;
+                double v;
+                if (parse_number(field_text(buf, s), &v)) {
+                    cells.push_back(s);
+                    values.push_back(v);
+                } else {
+                    ++stats.skipped;
+                }
+            }
+            stats.skipped += columns.size() - want; // short rows
+            pos = next;
+        }
+
+        convertUnits(opt.conversion, values.data(), values.data(), values.size());
+        stats.values += values.size();
+
+        text.clear();
+        std::size_t copied = first;
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            text.append(buf, copied, cells[i].begin - copied);
+            char num[64];
+            auto r = std::to_chars(num, num + sizeof num, values[i], std::chars_format::general, opt.digits);
+            text.append(num, r.ptr);
+            copied = cells[i].end;
+        }
+        text.append(buf, copied, cut - copied);
+        out.write(text.data(), (std::streamsize)text.size());
+    }
+
+    UnitCsvStats stats;
+
+private:
+    const UnitCsvOptions& opt;
+    std::ostream& out;
+    bool resolved = false;
+    std::vector<std::size_t> columns; // 0-based, ascending
+    std::vector<Span> cells;
+    std::vector<double> values;
+    std::string text;
+
+    // column indexes from the options and, with a header, its first line; returns where data starts
+    std::size_t resolve(const std::string& buf, std::size_t cut) {
+        resolved = true;
+        std::vector<std::string> names;
+        std::size_t start = 0;
+        if (opt.header) {
+            std::size_t nl = buf.find('\n');
+            start = nl == std::string::npos || nl >= cut ? cut : nl + 1;
+            std::size_t end = content_end(buf, 0, start), at = 0;
+            while (at < end) names.emplace_back(field_text(buf, next_field(buf, at, end, opt.delimiter)));
+        }
+        for (const auto& c : opt.columns) {
+            if (all_digits(c)) {
+                std::size_t i = std::strtoul(c.c_str(), nullptr, 10);
+                if (i == 0) throw std::runtime_error("Column numbers start at 1");
+                columns.push_back(i - 1);
+                continue;
+            }
+            auto it = std::find(names.begin(), names.end(), c);
+            if (it == names.end())
+                throw std::runtime_error(opt.header ? "No column named " + c : "Column names need a header: " + c);
+            columns.push_back((std::size_t)(it - names.begin()));
+        }
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        return start;
+    }
+};
+
+} // namespace
+
+const UnitDef* unitTable(std::size_t* count) {
+    *count = sizeof UNIT_TABLE / sizeof UNIT_TABLE[0];
+    return UNIT_TABLE;
+}
+
+const UnitDef* findUnit(std::string_view name) {
+    for (const UnitDef& u : UNIT_TABLE)
+        if (name == u.symbol) return &u;
+    for (const UnitDef& u : UNIT_TABLE)
+        if (has_name(u, name)) return &u;
+    return nullptr;
+}
+
+UnitConversion unitConversion(std::string_view from, std::string_view to) {
+    const UnitDef& a = require_unit(from);
+    const UnitDef& b = require_unit(to);
+    if (!std::equal(a.dim, a.dim + 5, b.dim))
+        throw std::runtime_error("Cannot convert " + std::string(a.symbol) + " (" + a.kind + ") to " + b.symbol +
+                                 " (" + b.kind + ")");
+    return {(double)(a.scale / b.scale), (double)((a.offset - b.offset) / b.scale)};
+}
+
+void convertUnits(const UnitConversion& c, const double* in, double* out, std::size_t n) {
+    calcKernels().affine(in, c.mul, c.add, out, n);
+}
+
+UnitCsvStats convertUnitCsv(std::istream& in, std::ostream& out, const UnitCsvOptions& opt) {
+    if (opt.digits < 1 || opt.digits > 17) throw std::runtime_error("digits must be between 1 and 17");
+    auto start = std::chrono::steady_clock::now();
+    CsvConverter conv(opt, out);
+    std::string buf;
+    while (true) {
+        std::size_t have = buf.size();
+        buf.resize(have + READ_BLOCK);
+        in.read(&buf[have], READ_BLOCK);
+        buf.resize(have + (std::size_t)in.gcount());
+        if (in.bad()) throw std::runtime_error("Read error");
+        bool eof = !in;
+
+        std::size_t cut = buf.rfind('\n');
+        cut = eof ? buf.size() : cut == std::string::npos ? 0 : cut + 1;
+        if (cut > 0) {
+            conv.block(buf, cut);
+            buf.erase(0, cut);
+        }
+        if (eof) break;
+    }
+    out.flush();
+    conv.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return conv.stats;
+}
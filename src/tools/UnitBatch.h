@@ -0,0 +1,58 @@
+#pragma once
+#include "Units.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ UnitBatch - 运行时的单位换算：按名字查单位、整列换算、CSV 流式换算
+ - 单位表由 Units.h 的 constexpr 常量生成；名字区分大小写（mB 与 MB 不同），
+   英文全称（meter、celsius ...）不区分大小写
+ - unitConversion(from, to) 只解析一次单位对，量纲不同或单位未知时抛出 runtime_error
+ - convertUnits 对整个数组做乘加，使用计算器按 CPU 选择的向量内核（CalcSimd.h 的 affine）
+ - convertUnitCsv 按块读入 CSV，把选中的列解析成数组、整块换算后再写回；其他列和行尾原样保留，
+   无法解析为数字的单元格（空值、文本）不变并计入 skipped；内存占用与输入大小无关
+*/
+struct UnitDef {
+    const char* symbol;
+    const char* names; // space-separated full names, matched case-insensitively
+    const char* kind;  // "length", "mass", ...
+    int dim[5];
+    long double scale;
+    long double offset;
+};
+
+template <class D>
+constexpr UnitDef unitDef(const char* symbol, const char* names, const char* kind, Unit<D> u) {
+    return {symbol, names, kind, {D::exponents[0], D::exponents[1], D::exponents[2], D::exponents[3], D::exponents[4]},
+            u.scale, u.offset};
+}
+
+// every known unit, grouped by kind
+const UnitDef* unitTable(std::size_t* count);
+// nullptr for unknown names
+const UnitDef* findUnit(std::string_view name);
+UnitConversion unitConversion(std::string_view from, std::string_view to);
+
+// out may equal in
+void convertUnits(const UnitConversion& c, const double* in, double* out, std::size_t n);
+
+struct UnitCsvOptions {
+    UnitConversion conversion;
+    std::vector<std::string> columns = {"1"}; // 1-based indexes, or header names with `header`
+    char delimiter = ',';
+    bool header = false; // first line is copied as is and names the columns
+    int digits = 15;     // significant digits of converted values
+};
+
+struct UnitCsvStats {
+    std::size_t rows = 0;
+    std::size_t values = 0;  // cells converted
+    std::size_t skipped = 0; // cells in a selected column that were not numbers
+    double seconds = 0;
+};
+
+// throws runtime_error for a column that is not in the header or a read error
+UnitCsvStats convertUnitCsv(std::istream& in, std::ostream& out, const UnitCsvOptions& opt);
@@ -1,13 +1,64 @@
 #include "UnitConverterTool.h"
+#include "UnitBatch.h"
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+
+void convert_one(double v, const UnitDef& from, const UnitDef& to, ToolOutput& out) {
+    UnitConversion c = unitConversion(from.symbol, to.symbol);
+    out << v << ' ' << from.symbol << " = " << c(v) << ' ' << to.symbol << '\n';
+}
+
+void list_units(ToolOutput& out) {
+    std::size_t n;
+    const UnitDef* units = unitTable(&n);
+    for (std::size_t i = 0; i < n; ++i) {
+        bool first = i == 0 || std::strcmp(units[i - 1].kind, units[i].kind) != 0;
+        if (first) out << (i ? "\n" : "") << units[i].kind << ':';
+        out << ' ' << units[i].symbol;
+    }
+    out << '\n';
+}
+
+} // namespace
 
 void UnitConverterTool::run() {
-    double v;
-    std::cout << "Enter meters: ";
-    std::cin >> v;
-    std::cin.ignore();
+    std::cout << "Enter <value> <unit> [target unit], a number of meters, or list: ";
+    std::string line;
+    std::getline(std::cin, line);
 
-    std::cout << v << " m = " << v * 100 << " cm\n";
-    std::cout << v << " m = " << v * 1000 << " mm\n";
+    ToolOutput out;
+    respond(ToolArgs(line), out, "Error: ");
+    std::cout << out.view();
 }
 
+void UnitConverterTool::execute(const ToolArgs& args, ToolOutput& out) {
+    if (args.size() == 1 && args[0] == "list") {
+        list_units(out);
+        return;
+    }
+    double v;
+    if (args.empty() || args.size() > 3 || !args.toDouble(0, &v))
+        throw std::runtime_error("Expected <value> <unit> [target unit], or a number of meters");
+
+    if (args.size() == 1) {
+        out << v << " m = " << v * 100 << " cm\n";
+        out << v << " m = " << v * 1000 << " mm\n";
+        return;
+    }
+    const UnitDef* from = findUnit(args[1]);
+    if (!from) throw std::runtime_error("Unknown unit: " + std::string(args[1]));
+    if (args.size() == 3) {
+        const UnitDef* to = findUnit(args[2]);
+        if (!to) throw std::runtime_error("Unknown unit: " + std::string(args[2]));
+        convert_one(v, *from, *to, out);
+        return;
+    }
+
+    std::size_t n;
+    const UnitDef* units = unitTable(&n);
+    for (std::size_t i = 0; i < n; ++i)
+        if (&units[i] != from && std::strcmp(units[i].kind, from->kind) == 0) convert_one(v, *from, units[i], out);
+}
@@ -2,10 +2,17 @@
 #include "Tool.h"
 #include <iostream>
 
+/*
+ UnitConverterTool - 单位换算（长度、质量、时间、温度、数据量、速度、数据速率）
+ - "<数值> <单位> <目标单位>" 换算一个值；"<数值> <单位>" 换算成同类的所有单位；
+   只有数值时按米换算成厘米和毫米（原来的行为）；"list" 列出所有单位
+ - 单位和换算系数来自 Units.h / UnitBatch.h；整列 CSV 换算见 convertUnitCsv（命令行 --units）
+*/
 class UnitConverterTool : public Tool {
 public:
     std::string name() const override { return "Unit Converter"; }
-    std::string description() const override { return "Convert meters to cm/mm"; }
+    static constexpr const char* DESCRIPTION = "Convert length, mass, time, temperature and data units";
+    std::string description() const override { return DESCRIPTION; }
     void run() override;
+    void execute(const ToolArgs& args, ToolOutput& out) override;
 };
-
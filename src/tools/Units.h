@@ -0,0 +1,99 @@
+#pragma once
+#include <type_traits>
+
+/*
+ Units - 编译期量纲分析
+ - Dim<L, M, T, K, B> 用类型表示量纲（长度、质量、时间、温度、数据量的指数）
+ - Unit<D> 是一个 constexpr 单位：基本单位值 = 数值 * scale + offset（offset 只用于摄氏度、华氏度等仿射单位）
+ - conversion(from, to) 在编译期算出 to = from * mul + add 的系数；两个单位量纲不同时编译失败
+ - 单位可以相乘除得到导出单位（如 Units::km / Units::h），仿射单位不能参与乘除
+ - 运行时按名字查找单位见 UnitBatch.h，它的单位表由这里的常量生成
+*/
+template <int L, int M, int T, int K, int B>
+struct Dim {
+    static constexpr int exponents[5] = {L, M, T, K, B};
+};
+
+template <class D1, class D2>
+struct DimProduct;
+template <int L1, int M1, int T1, int K1, int B1, int L2, int M2, int T2, int K2, int B2>
+struct DimProduct<Dim<L1, M1, T1, K1, B1>, Dim<L2, M2, T2, K2, B2>> {
+    using type = Dim<L1 + L2, M1 + M2, T1 + T2, K1 + K2, B1 + B2>;
+};
+
+template <class D>
+struct DimInverse;
+template <int L, int M, int T, int K, int B>
+struct DimInverse<Dim<L, M, T, K, B>> {
+    using type = Dim<-L, -M, -T, -K, -B>;
+};
+
+using Dimensionless = Dim<0, 0, 0, 0, 0>;
+using Length = Dim<1, 0, 0, 0, 0>;
+using Mass = Dim<0, 1, 0, 0, 0>;
+using Duration = Dim<0, 0, 1, 0, 0>;
+using Temperature = Dim<0, 0, 0, 1, 0>;
+using DataSize = Dim<0, 0, 0, 0, 1>;
+using Speed = Dim<1, 0, -1, 0, 0>;
+using DataRate = Dim<0, 0, -1, 0, 1>;
+
+template <class D>
+struct Unit {
+    using Dimension = D;
+    // long double so that affine offsets cancel exactly when a conversion is derived
+    long double scale;       // base units per unit
+    long double offset = 0;  // base value of 0 in this unit (affine units only)
+};
+
+// to = from * mul + add
+struct UnitConversion {
+    double mul = 1;
+    double add = 0;
+
+    constexpr double operator()(double v) const { return v * mul + add; }
+};
+
+template <class D1, class D2>
+constexpr UnitConversion conversion(Unit<D1> from, Unit<D2> to) {
+    static_assert(std::is_same<D1, D2>::value, "units measure different dimensions");
+    return {(double)(from.scale / to.scale), (double)((from.offset - to.offset) / to.scale)};
+}
+
+template <class D1, class D2>
+constexpr Unit<typename DimProduct<D1, D2>::type> operator*(Unit<D1> a, Unit<D2> b) {
+    // a throw is not a constant expression: using an affine unit here fails to compile
+    return a.offset != 0 || b.offset != 0 ? throw "affine units cannot be multiplied"
+                                          : Unit<typename DimProduct<D1, D2>::type>{a.scale * b.scale};
+}
+
+template <class D1, class D2>
+constexpr Unit<typename DimProduct<D1, typename DimInverse<D2>::type>::type> operator/(Unit<D1> a, Unit<D2> b) {
+    return a.offset != 0 || b.offset != 0
+               ? throw "affine units cannot be divided"
+               : Unit<typename DimProduct<D1, typename DimInverse<D2>::type>::type>{a.scale / b.scale};
+}
+
+// the units the converter knows; base units are m, kg, s, K and bytes
+struct Units {
+    static constexpr Unit<Length> m{1}, km{1e3L}, cm{1e-2L}, mm{1e-3L}, um{1e-6L}, nm{1e-9L};
+    static constexpr Unit<Length> in{0.0254L}, ft{0.3048L}, yd{0.9144L}, mi{1609.344L}, nmi{1852};
+
+    static constexpr Unit<Mass> kg{1}, g{1e-3L}, mg{1e-6L}, t{1e3L};
+    static constexpr Unit<Mass> lb{0.45359237L}, oz{0.45359237L / 16}, st{0.45359237L * 14};
+
+    static constexpr Unit<Duration> s{1}, ms{1e-3L}, us{1e-6L}, ns{1e-9L};
+    static constexpr Unit<Duration> min{60}, h{3600}, d{86400}, wk{7 * 86400}, yr{365.25L * 86400};
+
+    static constexpr Unit<Temperature> K{1}, degC{1, 273.15L}, degF{5.0L / 9, 273.15L - 32 * 5.0L / 9}, degR{5.0L / 9};
+
+    static constexpr Unit<DataSize> B{1}, bit{0.125L};
+    static constexpr Unit<DataSize> kB{1e3L}, MB{1e6L}, GB{1e9L}, TB{1e12L}, PB{1e15L};
+    static constexpr Unit<DataSize> KiB{1024.0L}, MiB{1024.0L * 1024}, GiB{1024.0L * 1024 * 1024},
+        TiB{1024.0L * 1024 * 1024 * 1024}, PiB{1024.0L * 1024 * 1024 * 1024 * 1024};
+    static constexpr Unit<DataSize> kbit{1e3L / 8}, Mbit{1e6L / 8}, Gbit{1e9L / 8};
+};
+
+static_assert(conversion(Units::km, Units::m)(1.5) == 1500, "km -> m");
+static_assert(conversion(Units::degC, Units::K)(0) == 273.15, "degC -> K");
+static_assert(conversion(Units::degF, Units::degC)(32) == 0, "degF -> degC");
+static_assert(conversion(Units::KiB, Units::B)(2) == 2048, "KiB -> B");
@@ -0,0 +1,13 @@
+#include "WordCountTable.h"
+
+void WordCountTable::merge(WordCountTable&& other) {
+    // other's copied words move with its arena, so they can be interned here as stable
+    words.adoptStorage(other.words);
+    for (Id i = 0; i < other.size(); ++i) add(other.word(i), other.counts[i], true);
+    other.clear();
+}
+
+void WordCountTable::clear() {
+    words.clear();
+    counts.clear();
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "WordInterner.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+ WordCountTable - 不区分大小写（ASCII）的单词计数表
+ - 单词驻留在 WordInterner 中（arena 存储，输入稳定时零复制），计数是按 Id 索引的数组
+ - 键保留第一次出现时的原始大小写，输出时再转成小写
+ - 每个线程各自计数，最后用 merge 合并（被合并方的 arena 整体转移，单词不重新复制）
+*/
+class WordCountTable {
+public:
+    using Id = WordInterner::Id;
+
+    // stable: word stays valid as long as this table (or any table it is merged into)
+    Id add(std::string_view word, std::uint64_t n = 1, bool stable = false) {
+        Id id = words.intern(word, stable);
+        if (id == counts.size()) counts.push_back(0);
+        counts[id] += n;
+        return id;
+    }
+    // adds all counts of other; other is left empty
+    void merge(WordCountTable&& other);
+
+    // Ids are 0 .. size()-1
+    std::size_t size() const { return counts.size(); }
+    std::string_view word(Id id) const { return words.word(id); }
+    std::uint64_t count(Id id) const { return counts[id]; }
+    void clear();
+
+    // bytes held by the words, their index and the counts
+    std::size_t memoryBytes() const { return words.memoryBytes() + counts.capacity() * sizeof(std::uint64_t); }
+    std::size_t arenaBlocks() const { return words.arenaBlocks(); }
+
+    // hash of the ASCII-lowercased word
+    static std::uint64_t hash(std::string_view word) { return WordInterner::hash(word); }
+
+private:
+    WordInterner words;
+    std::vector<std::uint64_t> counts; // by Id
+};
@@ -0,0 +1,81 @@
+#include "WordInterner.h"
+
+/*
+ Implementation details:
+ - Linear probing with load factor at most 1/2. A slot keeps the low 32 bits of the hash,
+   which is all that indexing ever uses (tables stay below 2^32 slots), so growing never
+   touches the words and most failed probes never compare strings.
+ - Ids are positions in `words`, so they stay dense and stable across growth.
+*/
+
+namespace {
+
+constexpr std::size_t INITIAL_SLOTS = 1024;
+
+inline unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+bool equal_nocase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (lower((unsigned char)a[i]) != lower((unsigned char)b[i])) return false;
+    return true;
+}
+
+} // namespace
+
+std::uint64_t WordInterner::hash(std::string_view word) {
+    // FNV-1a over the lowercased bytes, with a final mix so the low bits index well
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : word) h = (h ^ lower((unsigned char)c)) * 0x100000001b3ull;
+    return h ^ (h >> 32);
+}
+
+std::size_t WordInterner::probe(std::string_view word, std::uint32_t h) const {
+    std::size_t mask = slots.size() - 1;
+    for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+        const Slot& s = slots[i];
+        if (!s.id1 || (s.hash == h && equal_nocase(words[s.id1 - 1], word))) return i;
+    }
+}
+
+WordInterner::Id WordInterner::intern(std::string_view word, std::uint64_t h64, bool stable) {
+    if (slots.empty()) slots.resize(INITIAL_SLOTS);
+    std::uint32_t h = (std::uint32_t)h64;
+    Slot& s = slots[probe(word, h)];
+    if (s.id1) return s.id1 - 1;
+    words.push_back(stable ? word : arena.store(word));
+    s.id1 = (Id)words.size();
+    s.hash = h;
+    if (words.size() * 2 > slots.size()) grow();
+    return (Id)words.size() - 1;
+}
+
+WordInterner::Id WordInterner::find(std::string_view word) const {
+    if (slots.empty()) return NONE;
+    const Slot& s = slots[probe(word, (std::uint32_t)hash(word))];
+    return s.id1 ? s.id1 - 1 : NONE;
+}
+
+void WordInterner::grow() {
+    std::vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    std::size_t mask = slots.size() - 1;
+    for (const Slot& s : old) {
+        if (!s.id1) continue;
+        std::size_t i = s.hash & mask;
+        while (slots[i].id1) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+}
+
+void WordInterner::clear() {
+    slots.clear();
+    words.clear();
+    arena.clear();
+}
+
+std::size_t WordInterner::memoryBytes() const {
+    return slots.capacity() * sizeof(Slot) + words.capacity() * sizeof(std::string_view) + arena.bytesReserved();
+}
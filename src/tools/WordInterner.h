@@ -0,0 +1,54 @@
+#pragma once
+#include "StringArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+ WordInterner - 不区分大小写（ASCII）的单词驻留表
+ - 每个不同的单词得到一个从 0 开始连续编号的 Id，调用方可以用 Id 索引自己的数组（如计数）
+ - 单词文本存放在 StringArena 中；输入在驻留表生命周期内有效（stable，例如内存映射的文件）
+   时直接引用输入，不复制
+ - 索引是开放寻址的 Id 数组，每个槽位 8 字节（Id + 32 位哈希），单词本身只存一份 string_view
+ - 保留第一次出现时的原始大小写
+*/
+class WordInterner {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id NONE = ~Id(0);
+
+    // Id of word, adding it (with the next free Id) on first sight
+    Id intern(std::string_view word, bool stable = false) { return intern(word, hash(word), stable); }
+    Id intern(std::string_view word, std::uint64_t h, bool stable);
+    // NONE if word was never interned
+    Id find(std::string_view word) const;
+
+    std::string_view word(Id id) const { return words[id]; }
+    std::size_t size() const { return words.size(); }
+
+    // takes over other's arena so its words can be interned here with stable = true;
+    // the caller then re-interns other's words and discards other
+    void adoptStorage(WordInterner& other) { arena.adopt(std::move(other.arena)); }
+    void clear();
+
+    // bytes held by the index, the word list and the arena
+    std::size_t memoryBytes() const;
+    std::size_t arenaBlocks() const { return arena.blockCount(); }
+
+    // hash of the ASCII-lowercased word
+    static std::uint64_t hash(std::string_view word);
+
+private:
+    struct Slot {
+        Id id1 = 0; // Id + 1, 0 = empty
+        std::uint32_t hash = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<std::string_view> words;
+    StringArena arena;
+
+    std::size_t probe(std::string_view word, std::uint32_t h) const;
+    void grow();
+};
@@ -0,0 +1,176 @@
+#include "WordSketch.h"
+#include "WordInterner.h"
+#include <algorithm>
+#include <utility>
+
+/*
+ Implementation details:
+ - Entries form a binary min-heap on count, so the eviction victim is always entries[0];
+   a word's count only grows, so an update is a single sift-down.
+ - The hash index uses linear probing with backward-shift deletion (no tombstones), and
+   every entry remembers its slot so heap swaps can patch the index in O(1).
+ - merge follows Agarwal et al., "Mergeable Summaries": a word missing from one full sketch
+   is credited with that sketch's minimum count (and the same amount of error), then the
+   largest `capacity` entries are kept.
+*/
+
+namespace {
+
+inline unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+// b is already lowercase
+bool equal_lowered(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (lower((unsigned char)a[i]) != (unsigned char)b[i]) return false;
+    return true;
+}
+
+} // namespace
+
+WordSketch::WordSketch(std::size_t budgetBytes)
+    : cap(std::max(MIN_CAPACITY, budgetBytes / BYTES_PER_ENTRY)) {
+    std::size_t slots = 1;
+    while (slots < cap * 2) slots <<= 1;
+    index.assign(slots, 0);
+    entries.reserve(cap);
+}
+
+std::size_t WordSketch::find(std::string_view word, std::uint64_t h) const {
+    std::size_t mask = index.size() - 1;
+    for (std::size_t i = (std::size_t)h & mask;; i = (i + 1) & mask) {
+        std::uint32_t p = index[i];
+        if (!p) return i;
+        const Entry& e = entries[p - 1];
+        if (e.hash == h && equal_lowered(word, e.word)) return i;
+    }
+}
+
+void WordSketch::eraseSlot(std::size_t i) {
+    std::size_t mask = index.size() - 1;
+    for (std::size_t j = (i + 1) & mask; index[j]; j = (j + 1) & mask) {
+        std::size_t home = (std::size_t)entries[index[j] - 1].hash & mask;
+        // j's entry may move into the hole if its home is not cyclically inside (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            index[i] = index[j];
+            entries[index[i] - 1].slot = (std::uint32_t)i;
+            i = j;
+        }
+    }
+    index[i] = 0;
+}
+
+void WordSketch::place(std::size_t pos) {
+    std::size_t slot = find(entries[pos].word, entries[pos].hash);
+    index[slot] = (std::uint32_t)(pos + 1);
+    entries[pos].slot = (std::uint32_t)slot;
+}
+
+void WordSketch::swapEntries(std::size_t a, std::size_t b) {
+    std::swap(entries[a], entries[b]);
+    index[entries[a].slot] = (std::uint32_t)(a + 1);
+    index[entries[b].slot] = (std::uint32_t)(b + 1);
+}
+
+void WordSketch::siftUp(std::size_t pos) {
+    while (pos > 0) {
+        std::size_t parent = (pos - 1) / 2;
+        if (entries[parent].count <= entries[pos].count) break;
+        swapEntries(parent, pos);
+        pos = parent;
+    }
+}
+
+void WordSketch::siftDown(std::size_t pos) {
+    std::size_t n = entries.size();
+    while (true) {
+        std::size_t l = pos * 2 + 1, smallest = pos;
+        if (l < n && entries[l].count < entries[smallest].count) smallest = l;
+        if (l + 1 < n && entries[l + 1].count < entries[smallest].count) smallest = l + 1;
+        if (smallest == pos) return;
+        swapEntries(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void WordSketch::add(std::string_view word, std::uint64_t n) {
+    added += n;
+    std::uint64_t h = WordInterner::hash(word);
+    std::size_t slot = find(word, h);
+    if (std::uint32_t p = index[slot]) {
+        entries[p - 1].count += n;
+        siftDown(p - 1);
+        return;
+    }
+
+    std::size_t pos;
+    if (entries.size() < cap) {
+        pos = entries.size();
+        entries.emplace_back();
+    } else {
+        // evict the minimum: the newcomer inherits its count as error
+        pos = 0;
+        Entry& victim = entries[0];
+        eraseSlot(victim.slot);
+        victim.error = victim.count;
+        slot = find(word, h); // the backward shift may have moved the probe end
+    }
+    Entry& e = entries[pos];
+    e.word.resize(word.size());
+    for (size_t i = 0; i < word.size(); ++i) e.word[i] = (char)lower((unsigned char)word[i]);
+    e.hash = h;
+    e.count = e.error + n;
+    e.slot = (std::uint32_t)slot;
+    index[slot] = (std::uint32_t)(pos + 1);
+    if (pos == 0) siftDown(0);
+    else siftUp(pos);
+}
+
+void WordSketch::rebuild() {
+    std::make_heap(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) { return a.count > b.count; });
+    std::fill(index.begin(), index.end(), 0);
+    for (std::size_t i = 0; i < entries.size(); ++i) place(i);
+}
+
+void WordSketch::merge(WordSketch&& other) {
+    std::uint64_t minThis = entries.size() >= cap ? entries[0].count : 0;
+    std::uint64_t minOther = other.entries.size() >= other.cap ? other.entries[0].count : 0;
+
+    std::vector<bool> matched(other.entries.size(), false);
+    for (Entry& e : entries) {
+        std::size_t slot = other.find(e.word, e.hash);
+        if (std::uint32_t p = other.index[slot]) {
+            const Entry& o = other.entries[p - 1];
+            e.count += o.count;
+            e.error += o.error;
+            matched[p - 1] = true;
+        } else {
+            e.count += minOther;
+            e.error += minOther;
+        }
+    }
+    for (std::size_t i = 0; i < other.entries.size(); ++i) {
+        if (matched[i]) continue;
+        Entry& o = other.entries[i];
+        o.count += minThis;
+        o.error += minThis;
+        entries.push_back(std::move(o));
+    }
+    if (entries.size() > cap) {
+        std::nth_element(entries.begin(), entries.begin() + (std::ptrdiff_t)cap, entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.count > b.count; });
+        entries.resize(cap);
+    }
+    added += other.added;
+    rebuild();
+    other.clear();
+}
+
+void WordSketch::clear() {
+    entries.clear();
+    std::fill(index.begin(), index.end(), 0);
+    added = 0;
+}
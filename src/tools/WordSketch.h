@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ WordSketch - 固定内存的高频词估计（Space-Saving 算法）
+ - 最多跟踪 capacity 个单词，容量由内存预算决定；表满时新词顶替计数最小的词，
+   并继承它的计数作为误差
+ - 误差界：报告的计数 count 满足 count - error <= 真实计数 <= count，且 error <= total / capacity；
+   真实出现次数超过 total / capacity 的词一定在表中
+ - 不区分大小写（ASCII），单词以小写形式保存
+ - 多个线程各自的 sketch 可以合并（mergeable summaries），误差界仍然成立
+*/
+class WordSketch {
+public:
+    struct Entry {
+        std::string word; // lowercased
+        std::uint64_t hash = 0;
+        std::uint64_t count = 0;
+        std::uint64_t error = 0; // count may exceed the true count by at most this much
+        std::uint32_t slot = 0;  // position in the hash index
+    };
+
+    // approximate bytes per tracked word (entry plus hash index; longer words allocate more)
+    static constexpr std::size_t BYTES_PER_ENTRY = sizeof(Entry) + 2 * sizeof(std::uint32_t);
+    static constexpr std::size_t MIN_CAPACITY = 64;
+
+    explicit WordSketch(std::size_t budgetBytes);
+
+    void add(std::string_view word, std::uint64_t n = 1);
+    // combines the counts of another sketch; other is left empty
+    void merge(WordSketch&& other);
+    void clear();
+
+    std::size_t size() const { return entries.size(); }
+    std::size_t capacity() const { return cap; }
+    // sum of all counts added
+    std::uint64_t total() const { return added; }
+    // entries and index (words longer than the std::string inline buffer allocate extra)
+    std::size_t memoryBytes() const {
+        return entries.capacity() * sizeof(Entry) + index.capacity() * sizeof(std::uint32_t);
+    }
+
+    template <class F>
+    void forEach(F&& f) const {
+        for (const Entry& e : entries) f(e);
+    }
+
+private:
+    std::size_t cap;
+    std::uint64_t added = 0;
+    std::vector<Entry> entries;        // min-heap by count
+    std::vector<std::uint32_t> index;  // open addressing, entry position + 1 (0 = empty)
+
+    std::size_t find(std::string_view word, std::uint64_t h) const; // slot of word or of the empty slot ending its probe
+    void eraseSlot(std::size_t slot);
+    void place(std::size_t pos);
+    void swapEntries(std::size_t a, std::size_t b);
+    void siftUp(std::size_t pos);
+    void siftDown(std::size_t pos);
+    void rebuild();
+};
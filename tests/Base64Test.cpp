@@ -0,0 +1,151 @@
+#include "TestSupport.h"
+#include "CpuFeatures.h"
+#include "tools/TextEncryptTool.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Streaming Base64 at every kernel level the CPU and SUITE_SIMD allow (ctest runs this once
+// per SUITE_SIMD level): round trips of random data fed in random pieces with line breaks,
+// the RFC 4648 vectors, and the offset and reason reported for each kind of malformed input.
+
+namespace {
+
+const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string refEncode(const std::string& s) {
+    std::string out;
+    std::size_t i = 0;
+    for (; i + 3 <= s.size(); i += 3) {
+        unsigned v = (unsigned char)s[i] << 16 | (unsigned char)s[i + 1] << 8 | (unsigned char)s[i + 2];
+        for (int k = 18; k >= 0; k -= 6) out += ALPHABET[(v >> k) & 63];
+    }
+    if (s.size() - i == 1) {
+        unsigned v = (unsigned char)s[i] << 16;
+        out += std::string{ALPHABET[v >> 18], ALPHABET[(v >> 12) & 63], '=', '='};
+    } else if (s.size() - i == 2) {
+        unsigned v = (unsigned char)s[i] << 16 | (unsigned char)s[i + 1] << 8;
+        out += std::string{ALPHABET[v >> 18], ALPHABET[(v >> 12) & 63], ALPHABET[(v >> 6) & 63], '='};
+    }
+    return out;
+}
+
+// random piece sizes, so groups and vector blocks straddle update() calls
+std::vector<std::size_t> pieces(TestRng& rng, std::size_t n) {
+    std::vector<std::size_t> v;
+    while (n) {
+        std::size_t k = std::min(n, rng.below(4) ? 1 + rng.below(7) : 1 + rng.below(300));
+        v.push_back(k);
+        n -= k;
+    }
+    return v;
+}
+
+std::string encode(const Base64Kernels& k, const std::string& s, TestRng& rng) {
+    Base64Encoder enc(k);
+    std::string out;
+    std::size_t at = 0;
+    for (std::size_t n : pieces(rng, s.size())) {
+        std::vector<char> buf(Base64Encoder::maxOutput(n));
+        out.append(buf.data(), enc.update(s.data() + at, n, buf.data()));
+        at += n;
+    }
+    char tail[4];
+    out.append(tail, enc.finish(tail));
+    return out;
+}
+
+// the decoded bytes, or the error message
+std::string decode(const Base64Kernels& k, const std::string& text, TestRng& rng, bool* ok) {
+    Base64Decoder dec(k);
+    std::string out;
+    std::size_t at = 0;
+    try {
+        for (std::size_t n : pieces(rng, text.size())) {
+            std::vector<char> buf(Base64Decoder::maxOutput(n));
+            out.append(buf.data(), dec.update(text.data() + at, n, buf.data()));
+            at += n;
+        }
+        dec.finish();
+    } catch (const std::runtime_error& e) {
+        *ok = false;
+        return e.what();
+    }
+    *ok = true;
+    return out;
+}
+
+void checkError(const Base64Kernels& k, const std::string& text, std::size_t offset, const char* reason, TestRng& rng) {
+    bool ok;
+    std::string got = decode(k, text, rng, &ok);
+    std::string want = "Invalid base64 at offset " + std::to_string(offset) + ": " + reason;
+    CHECK(!ok && got == want, std::string(k.name) + ": expected \"" + want + "\", got \"" + got + "\"");
+}
+
+void checkKernels(const Base64Kernels& k, TestRng& rng) {
+    const char* rfc[][2] = {{"", ""},          {"f", "Zg=="},         {"fo", "Zm8="},        {"foo", "Zm9v"},
+                            {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+    for (auto& c : rfc) {
+        bool ok;
+        CHECK(encode(k, c[0], rng) == c[1], std::string(k.name) + ": encode " + c[0]);
+        CHECK(decode(k, c[1], rng, &ok) == c[0] && ok, std::string(k.name) + ": decode " + c[1]);
+    }
+
+    for (int i = 0; i < 400; ++i) {
+        std::string data(rng.below(4) ? rng.below(100) : rng.below(5000), '\0');
+        for (char& c : data) c = (char)rng.next();
+        std::string text = encode(k, data, rng);
+        CHECK(text == refEncode(data), std::string(k.name) + ": encode " + std::to_string(data.size()) + " bytes");
+
+        // line breaks anywhere are skipped
+        std::string wrapped;
+        for (char c : text) {
+            wrapped += c;
+            if (rng.below(40) == 0) wrapped += rng.below(2) ? "\n" : "\r\n";
+        }
+        bool ok;
+        CHECK(decode(k, wrapped, rng, &ok) == data && ok, std::string(k.name) + ": round trip " + std::to_string(data.size()));
+
+        // a bad character deep inside the input, where the vector kernels run
+        if (text.size() > 8) {
+            std::size_t at = rng.below(text.size() - 4);
+            std::string bad = text;
+            bad[at] = "!*-_ \t."[rng.below(7)];
+            checkError(k, bad, at, "invalid character", rng);
+        }
+    }
+
+    std::string body = refEncode(std::string(3000, 'x')); // long valid prefix
+    checkError(k, body + "Z===", body.size() + 1, "misplaced '='", rng);
+    checkError(k, body + "Zh==", body.size() + 3, "non-zero bits before padding", rng);
+    checkError(k, body + "Zm9=", body.size() + 3, "non-zero bits before padding", rng);
+    checkError(k, body + "Zg==Zg==", body.size() + 4, "data after padding", rng);
+    checkError(k, body + "Zg=a", body.size() + 3, "expected '='", rng);
+    checkError(k, body + "Zg", body.size() + 2, "input ends inside a group", rng);
+    checkError(k, body + "Zg=", body.size() + 3, "input ends inside a group", rng);
+}
+
+} // namespace
+
+int main() {
+    TestRng rng(16);
+    std::vector<const Base64Kernels*> sets = {&base64ScalarKernels()};
+#ifdef SUITE_X86_SIMD
+    SimdLevel level = cpuSimdLevel(); // capped by SUITE_SIMD
+    if (level >= SimdLevel::Ssse3) sets.push_back(&base64Ssse3Kernels());
+    if (level >= SimdLevel::Avx2) sets.push_back(&base64Avx2Kernels());
+#endif
+    std::string levels;
+    for (const Base64Kernels* k : sets) {
+        checkKernels(*k, rng);
+        levels += std::string(" ") + k->name;
+    }
+
+    // the default entry points use the runtime-selected kernels
+    std::string data = "The quick brown fox jumps over the lazy dog";
+    CHECK(base64Decode(base64Encode(data)) == data, "base64Encode / base64Decode");
+    CHECK(base64Kernels().name == sets.back()->name, std::string("selected ") + base64Kernels().name);
+
+    std::printf("base64: kernels%s\n", levels.c_str());
+    return testResult("base64");
+}
@@ -0,0 +1,60 @@
+#include "TestSupport.h"
+#include "tools/CalcBatch.h"
+#include "tools/CalcProgram.h"
+#include "tools/CalcSimd.h"
+#include "tools/UnitBatch.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Column-wise evaluation against CalcProgram::eval row by row. Without sin/cos/ln/log
+// (polynomial approximations in the vector kernels) every row must match bitwise, whether
+// it lands in a vector lane or in a block's scalar tail. Unit conversions run the same
+// kernels and must match UnitConversion applied to one value. Run once per SUITE_SIMD level.
+
+namespace {
+
+constexpr std::size_t ROWS = 4099; // several blocks and an odd tail
+
+bool sameBits(double a, double b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+} // namespace
+
+int main() {
+    TestRng rng(7);
+    std::vector<double> x(ROWS), y(ROWS), out(ROWS);
+    for (std::size_t i = 0; i < ROWS; ++i) {
+        x[i] = ((double)rng.below(2000001) - 1000000) / 1e5;
+        y[i] = ((double)rng.below(2000001) + 1) / 1e4;
+    }
+
+    const char* exprs[] = {"x^11", "x^-7", "x^37", "x^63", "x^2", "x^3 - x^8", "y^-1", "x^y", "y^0.5",
+                           "(x + y) * (x - y) / y", "abs(-x) * 3 - sqrt(y)", "x * 1.8 + 32", "-x^2 + y^(x/x)"};
+    for (const char* expr : exprs) {
+        CalcProgram prog = CalcProgram::compile(expr);
+        std::vector<CalcColumn> cols(prog.vars.size());
+        for (std::size_t v = 0; v < prog.vars.size(); ++v) cols[v].data = prog.vars[v] == "x" ? x.data() : y.data();
+        evalCalcBatch(prog, cols.data(), ROWS, out.data());
+        int bad = 0;
+        for (std::size_t i = 0; i < ROWS; ++i) {
+            std::vector<double> vars;
+            for (const std::string& v : prog.vars) vars.push_back(v == "x" ? x[i] : y[i]);
+            double want = prog.eval(vars.data());
+            if (!sameBits(want, out[i]) && bad++ == 0)
+                CHECK(false, std::string(expr) + " row " + std::to_string(i) + ": " + std::to_string(want) + " / " +
+                                 std::to_string(out[i]));
+        }
+        if (bad > 1) CHECK(false, std::string(expr) + ": " + std::to_string(bad) + " rows differ");
+    }
+    const char* pairs[][2] = {{"F", "C"}, {"C", "F"}, {"mi", "km"}, {"K", "F"}};
+    for (auto& pair : pairs) {
+        UnitConversion c = unitConversion(pair[0], pair[1]);
+        convertUnits(c, x.data(), out.data(), ROWS);
+        int bad = 0;
+        for (std::size_t i = 0; i < ROWS; ++i) bad += !sameBits(c(x[i]), out[i]);
+        CHECK(bad == 0, std::string(pair[0]) + " -> " + pair[1] + ": " + std::to_string(bad) + " values differ");
+    }
+    std::printf("calc_batch: %s kernels\n", calcKernels().name);
+    return testResult("calc_batch");
+}
@@ -0,0 +1,154 @@
+#include "TestSupport.h"
+#include "tools/CalcBigInt.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// CalcBigInt against references: __int128 for values that fit, a base-10^9 schoolbook
+// multiplication for large ones (sizes on both sides of KARATSUBA_THRESHOLD), and the
+// defining identities for division, gcd, isqrt, pow and shifts.
+
+namespace {
+
+using i128 = __int128;
+
+std::string str128(i128 v) {
+    if (v == 0) return "0";
+    bool neg = v < 0;
+    unsigned __int128 m = neg ? -(unsigned __int128)v : (unsigned __int128)v;
+    std::string s;
+    while (m) {
+        s.insert(s.begin(), char('0' + (int)(m % 10)));
+        m /= 10;
+    }
+    return neg ? "-" + s : s;
+}
+
+CalcBigInt big(const std::string& s) {
+    if (!s.empty() && s[0] == '-') return -CalcBigInt::fromDecimal(s.substr(1));
+    return CalcBigInt::fromDecimal(s);
+}
+
+std::string randomDigits(TestRng& rng, std::size_t n) {
+    std::string s(1, char('1' + rng.below(9)));
+    while (s.size() < n) s += char('0' + rng.below(10));
+    return s;
+}
+
+// |a| * |b| of decimal strings, base 10^9 schoolbook
+std::string refMul(const std::string& a, const std::string& b) {
+    auto limbs = [](const std::string& s) {
+        std::vector<unsigned long long> v;
+        for (std::size_t end = s.size(); end > 0; end = end >= 9 ? end - 9 : 0) {
+            std::size_t begin = end >= 9 ? end - 9 : 0;
+            v.push_back(std::stoull(s.substr(begin, end - begin)));
+            if (begin == 0) break;
+        }
+        return v;
+    };
+    std::vector<unsigned long long> x = limbs(a), y = limbs(b), r(x.size() + y.size() + 1, 0);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        unsigned long long carry = 0;
+        for (std::size_t j = 0; j < y.size(); ++j) {
+            unsigned long long t = r[i + j] + x[i] * y[j] + carry;
+            r[i + j] = t % 1000000000ULL;
+            carry = t / 1000000000ULL;
+        }
+        for (std::size_t k = i + y.size(); carry; ++k) {
+            unsigned long long t = r[k] + carry;
+            r[k] = t % 1000000000ULL;
+            carry = t / 1000000000ULL;
+        }
+    }
+    while (r.size() > 1 && r.back() == 0) r.pop_back();
+    std::string s = std::to_string(r.back());
+    for (std::size_t i = r.size() - 1; i-- > 0;) {
+        std::string part = std::to_string(r[i]);
+        s += std::string(9 - part.size(), '0') + part;
+    }
+    return s;
+}
+
+void checkDivision(const CalcBigInt& a, const CalcBigInt& b) {
+    CalcBigInt q, r;
+    CalcBigInt::divMod(a, b, q, r);
+    CHECK(q * b + r == a, a.toString() + " / " + b.toString());
+    CHECK(CalcBigInt::compare(r.abs(), b.abs()) < 0, "remainder too large: " + a.toString() + " % " + b.toString());
+    CHECK(r.isZero() || r.sign() == a.sign(), "remainder sign: " + a.toString() + " % " + b.toString());
+    CHECK(a / b == q && a % b == r, "operators vs divMod: " + a.toString());
+}
+
+void smallValues(TestRng& rng) {
+    for (int i = 0; i < 20000; ++i) {
+        auto pick = [&]() -> long long {
+            switch (rng.below(4)) {
+            case 0: return (long long)rng.below(100) - 50;
+            case 1: return (long long)(rng.next() >> 1) * (rng.below(2) ? 1 : -1);
+            case 2: return (long long)(rng.next() >> 33) * (rng.below(2) ? 1 : -1);
+            default: return rng.below(2) ? (long long)0x7fffffffffffffffLL : (long long)(-0x7fffffffffffffffLL - 1);
+            }
+        };
+        long long x = pick(), y = pick();
+        CalcBigInt a(x), b(y);
+        CHECK(a.toString() == str128(x), "toString " + str128(x));
+        CHECK((a + b).toString() == str128((i128)x + y), str128(x) + " + " + str128(y));
+        CHECK((a - b).toString() == str128((i128)x - y), str128(x) + " - " + str128(y));
+        CHECK((a * b).toString() == str128((i128)x * y), str128(x) + " * " + str128(y));
+        CHECK(CalcBigInt::compare(a, b) == (x < y ? -1 : x > y ? 1 : 0), "compare " + str128(x) + " " + str128(y));
+        long long back;
+        CHECK(a.toInt64(&back) && back == x, "toInt64 " + str128(x));
+        if (y != 0 && !(x == (-0x7fffffffffffffffLL - 1) && y == -1)) {
+            CHECK((a / b).toString() == str128(x / y), str128(x) + " / " + str128(y));
+            CHECK((a % b).toString() == str128(x % y), str128(x) + " % " + str128(y));
+        }
+        unsigned s = (unsigned)rng.below(60);
+        CHECK((a << s).toString() == str128((x < 0 ? -1 : 1) * ((i128)(x < 0 ? -(i128)x : x) << s)), "shl " + str128(x));
+    }
+    bool threw = false;
+    try {
+        CalcBigInt(1) / CalcBigInt(0);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw, "division by zero throws");
+}
+
+void largeValues(TestRng& rng) {
+    // up to ~2400 digits: 250 limbs, well past the Karatsuba threshold on both sides
+    for (int i = 0; i < 300; ++i) {
+        std::string da = randomDigits(rng, 1 + rng.below(2400)), db = randomDigits(rng, 1 + rng.below(2400));
+        bool na = rng.below(2), nb = rng.below(2);
+        CalcBigInt a = big((na ? "-" : "") + da), b = big((nb ? "-" : "") + db);
+        CHECK(a.toString() == (na ? "-" : "") + da, "decimal round trip");
+
+        std::string prod = refMul(da, db);
+        CHECK((a * b).toString() == (na != nb ? "-" : "") + prod, "multiply " + std::to_string(da.size()) + "x" +
+                                                                       std::to_string(db.size()) + " digits");
+        CHECK(a + b - b == a && (a + b) - a == b, "add / sub");
+        checkDivision(a, b);
+        checkDivision(a * b + CalcBigInt((long long)rng.below(1000)), b);
+
+        CalcBigInt g = CalcBigInt::gcd(a, b);
+        CHECK(!g.isNegative() && (a % g).isZero() && (b % g).isZero(), "gcd divides");
+        CHECK(CalcBigInt::gcd(a / g, b / g) == CalcBigInt(1), "gcd is greatest");
+
+        CalcBigInt s = a.isqrt(), s1 = s + CalcBigInt(1);
+        CHECK(CalcBigInt::compare(s * s, a.abs()) <= 0 && CalcBigInt::compare(s1 * s1, a.abs()) > 0, "isqrt");
+
+        std::size_t k = rng.below(200);
+        CalcBigInt p2 = CalcBigInt::pow(CalcBigInt(2), k);
+        CHECK((a << k) == a * p2, "shl vs pow(2, k)");
+        CHECK((a >> k) == a / p2, "shr rounds toward zero");
+    }
+    CalcBigInt x(7), acc(1);
+    for (unsigned e = 0; e < 300; ++e, acc = acc * x) CHECK(CalcBigInt::pow(x, e) == acc, "pow 7^" + std::to_string(e));
+}
+
+} // namespace
+
+int main() {
+    TestRng rng(8);
+    smallValues(rng);
+    largeValues(rng);
+    return testResult("calc_bigint");
+}
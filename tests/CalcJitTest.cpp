@@ -0,0 +1,105 @@
+#include "TestSupport.h"
+#include "tools/CalcJit.h"
+#include "tools/CalcProgram.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// The JIT promises results bitwise identical to the bytecode interpreter, and the same
+// exceptions. Random expressions over every operator and builtin, optimized and not,
+// are evaluated both ways on random variable values.
+
+namespace {
+
+constexpr int EXPRESSIONS = 3000;
+constexpr int POINTS = 8; // variable assignments per expression
+
+const char* const FUNCS[] = {"sin", "cos", "tan", "sqrt", "abs", "log", "ln"};
+const char* const VARS[] = {"x", "y", "z"};
+
+std::string gen(TestRng& rng, int depth) {
+    if (depth == 0 || rng.below(4) == 0) {
+        switch (rng.below(3)) {
+        case 0: return VARS[rng.below(3)];
+        case 1: return std::to_string(rng.below(10));
+        default: return std::to_string(rng.below(1000)) + "." + std::to_string(rng.below(100));
+        }
+    }
+    switch (rng.below(8)) {
+    case 0: return "(" + gen(rng, depth - 1) + "+" + gen(rng, depth - 1) + ")";
+    case 1: return "(" + gen(rng, depth - 1) + "-" + gen(rng, depth - 1) + ")";
+    case 2: return "(" + gen(rng, depth - 1) + "*" + gen(rng, depth - 1) + ")";
+    case 3: return "(" + gen(rng, depth - 1) + "/" + gen(rng, depth - 1) + ")";
+    case 4: return "(" + gen(rng, depth - 1) + "^" + std::to_string((int)rng.below(7) - 2) + ")";
+    case 5: return "(" + gen(rng, depth - 1) + "^" + gen(rng, depth - 1) + ")";
+    case 6: return "-" + gen(rng, depth - 1);
+    default: return std::string(FUNCS[rng.below(7)]) + "(" + gen(rng, depth - 1) + ")";
+    }
+}
+
+struct Outcome {
+    double value = 0;
+    std::string error;
+};
+
+template <class F>
+Outcome run(F&& f) {
+    Outcome o;
+    try {
+        o.value = f();
+    } catch (const std::runtime_error& e) {
+        o.error = e.what();
+    }
+    return o;
+}
+
+bool same(const Outcome& a, const Outcome& b) {
+    if (a.error != b.error) return false;
+    if (!a.error.empty()) return true;
+    if (std::isnan(a.value) && std::isnan(b.value)) return true;
+    return std::memcmp(&a.value, &b.value, sizeof(double)) == 0;
+}
+
+} // namespace
+
+int main() {
+    if (!CalcJitCode::supported()) {
+        std::printf("calc_jit: JIT not supported on this platform\n");
+        return TEST_SKIPPED;
+    }
+    TestRng rng(2024);
+    int compared = 0;
+    for (int i = 0; i < EXPRESSIONS; ++i) {
+        std::string expr = gen(rng, 5);
+        for (bool optimize : {false, true}) {
+            CalcProgram prog = CalcProgram::compile(expr, optimize);
+            auto jit = CalcJitCode::compile(prog);
+            CHECK(jit != nullptr, "compile " + expr);
+            if (!jit) continue;
+            for (int p = 0; p < POINTS; ++p) {
+                double vars[3];
+                for (double& v : vars) v = ((double)rng.below(2000001) - 1000000) / 1000.0;
+                if (p == 0) vars[0] = vars[1] = vars[2] = 0; // division by zero, ln(0)...
+                Outcome want = run([&] { return prog.interpret(vars); });
+                Outcome got = run([&] { return jit->eval(vars); });
+                CHECK(same(want, got), expr + (optimize ? " (optimized)" : "") + ": interpreter " +
+                                           (want.error.empty() ? std::to_string(want.value) : want.error) +
+                                           ", jit " + (got.error.empty() ? std::to_string(got.value) : got.error));
+                ++compared;
+            }
+        }
+    }
+
+    // fixed cases for each error path
+    const char* errors[] = {"1/0", "sqrt(-1)", "log(0)", "ln(-2)", "x/(y-y)"};
+    for (const char* expr : errors) {
+        CalcProgram prog = CalcProgram::compile(expr, false);
+        auto jit = CalcJitCode::compile(prog);
+        double vars[3] = {1, 2, 3};
+        Outcome want = run([&] { return prog.interpret(vars); }), got = run([&] { return jit->eval(vars); });
+        CHECK(!want.error.empty() && same(want, got), std::string(expr) + ": " + want.error + " / " + got.error);
+    }
+    std::printf("calc_jit: %d evaluations compared\n", compared);
+    return testResult("calc_jit");
+}
@@ -0,0 +1,60 @@
+#include "TestSupport.h"
+#include "tools/CalcProgram.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// The optimizer must accept anything the parser accepts, however deep, and evaluate it
+// exactly like the unoptimized program. Long chains are built as text, as a request to
+// the calculator (or to --serve) would send them.
+
+namespace {
+
+constexpr int CHAIN = 300000;
+
+std::string outcome(const CalcProgram& prog, const double* vars) {
+    try {
+        return std::to_string(prog.interpret(vars));
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+}
+
+void compareChain(const std::string& what, const std::string& expr) {
+    double vars[3] = {1.25, -0.5, 3.0};
+    try {
+        CalcProgram plain = CalcProgram::compile(expr, false);
+        CalcProgram opt = CalcProgram::compile(expr, true);
+        CHECK(outcome(plain, vars) == outcome(opt, vars), what + ": " + outcome(plain, vars) + " / " + outcome(opt, vars));
+    } catch (const std::exception& e) {
+        CHECK(false, what + " threw " + e.what());
+    }
+}
+
+} // namespace
+
+int main() {
+    std::string sum = "x";
+    for (int i = 1; i < CHAIN; ++i) sum += "+x";
+    compareChain("x+x+...+x", sum);
+
+    // distinct nodes, alternating operators, and a shared subexpression all along the chain
+    std::string mixed = "x";
+    for (int i = 1; i < CHAIN; ++i) mixed += (i % 3 == 0 ? "*(x-y)" : i % 3 == 1 ? "-(x-y)" : "/z");
+    compareChain("mixed chain", mixed);
+
+    std::string nested;
+    for (int i = 0; i < CHAIN / 10; ++i) nested += "(";
+    nested += "y";
+    for (int i = 0; i < CHAIN / 10; ++i) nested += "+1)";
+    compareChain("nested parentheses", nested);
+
+    // x^2 .. x^8 become multiplication chains: close to pow, not bitwise equal
+    for (int n = 2; n <= 8; ++n) {
+        double vars[3] = {1.7, 0, 0};
+        double got = CalcProgram::compile("x^" + std::to_string(n), true).interpret(vars);
+        double want = std::pow(1.7, n);
+        CHECK(std::fabs(got - want) <= 8 * std::fabs(want) * 2.2e-16, "x^" + std::to_string(n));
+    }
+    return testResult("calc_optimizer");
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*
+ TestSupport - ctest 差分测试的公共部分（不依赖测试框架）
+ - CHECK(cond, what) 失败时打印位置和说明并计数，测试继续运行；main 返回 testResult()
+ - TestRng 是固定种子的 splitmix64，每次运行生成相同的用例，失败可以复现
+ - 返回 TEST_SKIPPED 的测试在 ctest 中显示为跳过（平台不支持被测功能时）
+*/
+constexpr int TEST_SKIPPED = 77;
+
+inline int& testFailures() {
+    static int n = 0;
+    return n;
+}
+
+#define CHECK(cond, what)                                                                        \
+    do {                                                                                         \
+        if (!(cond)) {                                                                           \
+            if (++testFailures() <= 20)                                                          \
+                std::fprintf(stderr, "%s:%d: CHECK(%s) failed: %s\n", __FILE__, __LINE__, #cond, \
+                             std::string(what).c_str());                                         \
+        }                                                                                        \
+    } while (0)
+
+inline int testResult(const char* name) {
+    if (testFailures()) std::fprintf(stderr, "%s: %d check(s) failed\n", name, testFailures());
+    else std::printf("%s: ok\n", name);
+    return testFailures() ? 1 : 0;
+}
+
+class TestRng {
+public:
+    explicit TestRng(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    // [0, n)
+    std::size_t below(std::size_t n) { return (std::size_t)(next() % n); }
+
+private:
+    std::uint64_t state;
+};